@@ -6,10 +6,7 @@ where /q cl || (
   exit /b 1
 )
 
-
-call fxc /nologo /T cs_5_0 /E ComputeMain /O3 /WX /Fh refterm_cs.h /Vn ReftermCSShaderBytes /Qstrip_reflect /Qstrip_debug /Qstrip_priv refterm.hlsl
-call fxc /nologo /T ps_5_0 /E PixelMain /O3 /WX /Fh refterm_ps.h /Vn ReftermPSShaderBytes /Qstrip_reflect /Qstrip_debug /Qstrip_priv refterm.hlsl
-call fxc /nologo /T vs_5_0 /E VertexMain /O3 /WX /Fh refterm_vs.h /Vn ReftermVSShaderBytes /Qstrip_reflect /Qstrip_debug /Qstrip_priv refterm.hlsl
+rem NOTE: There is no shader step - refterm compiles refterm.hlsl when it starts, so it has to stay next to the .exe
 
 set CFLAGS=/nologo /W3 /Z7 /GS- /Gs999999
 set LDFLAGS=/incremental:no /opt:icf /opt:ref
@@ -24,6 +21,8 @@ call cl -O2 -Ferefterm_release_msvc.exe %CFLAGS% %BASE_FILES% /link %LDFLAGS% /s
 
 call cl -O2 -Fesplat.exe %CFLAGS% splat.cpp /link %LDFLAGS% /subsystem:console
 call cl -O2 -Fesplat2.exe %CFLAGS% splat2.cpp /link %LDFLAGS% /subsystem:console
+call cl -O2 -Feglyph_cache_bench.exe %CFLAGS% glyph_cache_bench.c /link %LDFLAGS% /subsystem:console
+call cl -O2 -Fesource_buffer_bench.exe %CFLAGS% source_buffer_bench.c /link %LDFLAGS% /subsystem:console
 
 where /q clang || (
   echo WARNING: "clang" not found - to run the fastest version of refterm, please install CLANG.
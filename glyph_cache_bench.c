@@ -0,0 +1,2132 @@
+/* NOTE:
+
+   Standalone benchmark for refterm_glyph_cache.  It does not need a GPU, a font, or
+   a window - it just feeds synthetic glyph hashes through the table the same way the
+   terminal does (look up, and if the entry isn't filled yet, mark it filled).
+
+   glyph_cache_bench -layout [EntryCount]
+
+       Compares ns/lookup of GlyphTableLayout_Chained vs. GlyphTableLayout_OpenAddressed
+       at roughly 50%, 90% and 99% hit rates.  The default EntryCount is what refterm
+       gets from a 2048x2048 cache texture with a 8x17 font.
+
+   glyph_cache_bench -threads [EntryCount]
+
+       Hammers one shared sharded table (glyph_table_params.ShardCount) from 1 to 16
+       threads at a ~99% hit rate and prints the total lookup throughput.  ShardCount=1
+       is the "one big lock" baseline.
+
+   glyph_cache_bench -batch [EntryCount]
+
+       Lays out synthetic 300-column rows of mixed CJK, emoji and symbol glyphs, and
+       compares one FindGlyphEntryByHash per cell against one FindGlyphEntriesByHashBatch
+       per row.
+
+   glyph_cache_bench -spans [EntryCount]
+
+       Lays out rows of mostly double-width glyphs (plus a few 3-4 cell ones), and compares
+       one entry per tile against moving wide glyphs into multi-tile spans
+       (glyph_table_params.SpanEntryCounts), with the same number of texture tiles.
+
+   glyph_cache_bench -grow [EntryCount]
+
+       Fills an empty table with a stream of new glyphs, and compares a fixed 4096-slot hash
+       table against one that starts at 4096 and grows (glyph_table_params.MaxHashCount), and
+       one that is big enough from the start.  Prints ns/lookup for each half of the run.
+
+   glyph_cache_bench -front [EntryCount]
+
+       Replays tmux/htop-style frames (box-drawing borders, meter bars, a powerline status
+       row and a scrolling CJK pane) with a BeginGlyphTableFrame per frame, and compares no
+       front cache against a few glyph_table_params.FrontCacheCount sizes, one-by-one and
+       batched.
+
+   glyph_cache_bench -codepoints [EntryCount]
+
+       Draws frames of single BMP codepoints (box-drawing, Cyrillic/Greek, and two-tile Han
+       that can't be mapped), and compares hashing every cell against trying the codepoint
+       page table (glyph_table_params.DirectPageCount) first.
+
+   glyph_cache_bench -hash
+
+       Measures every glyph_hash_backend the CPU supports: GB/s and ns/hash on 2, 8, 64 and
+       4096-byte runs (plus the latency of one hash feeding the next), and the collisions it
+       gives on a corpus of about 2.4 million Unicode clusters - every scalar value, plus
+       combining sequences, jamo, conjuncts, emoji sequences and flags - both on the full
+       128 bits and on the low 32 bits the hash table slot comes from.  It also hashes
+       256-cluster rows one ComputeGlyphHash at a time and with one ComputeGlyphHashes per
+       row, and checks that both give the same hashes.
+
+   glyph_cache_bench -utf8 [EntryCount]
+
+       Lays out rows of complex-script clusters (combining sequences, jamo, conjuncts, emoji
+       sequences) as UTF-8, and compares the all-hit path of converting each run to UTF-16
+       and hashing that, like ParseWithKB used to, against hashing the UTF-8 in place.
+
+   glyph_cache_bench -flood [EntryCount]
+
+       Brute-forces strings whose hashes with the fixed DefaultSeed all land in one hash slot,
+       draws them along with ordinary glyphs, and compares tables hashed with DefaultSeed and
+       with their own seed (GetGlyphTableSeed), each with and without the MaxChainLength guard.
+
+   glyph_cache_bench -trace File [File...]
+
+       Replays recorded terminal output (the raw bytes a program wrote to the terminal,
+       eg. captured with "script" or by redirecting it to a file) through the table, and
+       prints hit ratio, rasterization count, rejected admissions and ns/lookup for
+       every eviction/admission policy at a few cache sizes.  Escape sequences and direct-mapped ASCII are skipped just
+       like the terminal does, so only glyphs that would really go through the table are
+       looked up.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <time.h>
+#include <pthread.h>
+#endif
+
+#include "refterm.h"
+#include "refterm_glyph_cache.h"
+#include "refterm_glyph_cache.c"
+#include "refterm_glyph_hash.h"
+#include "refterm_glyph_hash.c"
+
+#define BENCH_FILLED_STATE 2
+
+static double GetSeconds(void)
+{
+#if _WIN32
+    LARGE_INTEGER Frequency, Counter;
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    double Result = (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    double Result = (double)Time.tv_sec + 1e-9*(double)Time.tv_nsec;
+#endif
+    return Result;
+}
+
+static uint64_t RandomState = 0x9e3779b97f4a7c15ull;
+static uint64_t RandomU64(void)
+{
+    // NOTE: xorshift64*, which is plenty for generating test keys
+    RandomState ^= RandomState >> 12;
+    RandomState ^= RandomState << 25;
+    RandomState ^= RandomState >> 27;
+    uint64_t Result = RandomState*0x2545f4914f6cdd1dull;
+    return Result;
+}
+
+static glyph_hash RandomHash(void)
+{
+    glyph_hash Result;
+    Result.Value = _mm_set_epi64x((long long)RandomU64(), (long long)RandomU64());
+    return Result;
+}
+
+static glyph_table *AllocateBenchTable(glyph_table_params Params)
+{
+    // NOTE: Deliberately not zeroed, so the benchmark also checks that PlaceGlyphTableInMemory
+    // doesn't rely on fresh pages.
+    void *Memory = malloc(GetGlyphTableFootprint(Params));
+    glyph_table *Result = PlaceGlyphTableInMemory(Params, Memory);
+    return Result;
+}
+
+static void FreeBenchTable(glyph_table *Table)
+{
+    // NOTE: The first shard's entry array (or the only one) is always at the base of the block
+    free(Table->ShardCount ? Table->Shards[0]->Entries : Table->Entries);
+}
+
+static uint32_t RunLookups(glyph_table *Table, size_t Count, glyph_hash *Hashes)
+{
+    uint32_t Sink = 0;
+    for(size_t Index = 0; Index < Count; ++Index)
+    {
+        glyph_state State = FindGlyphEntryByHash(Table, Hashes[Index]);
+        if(State.FilledState != BENCH_FILLED_STATE)
+        {
+            UpdateGlyphCacheEntry(Table, State.ID, BENCH_FILLED_STATE, 1, 1);
+        }
+        Sink += State.GPUIndex.Value;
+    }
+
+    return Sink;
+}
+
+static glyph_hash *MakeHitRateStream(size_t Count, uint32_t EntryCount, double HitRate)
+{
+    /* NOTE: A fixed "hot" set is hit with probability HitRate, everything else is a key that
+       has never been seen before.  The hot set is sized so that it plus the stream of new keys
+       between two uses of a hot key fit in the table, so the actual hit rate lands close to
+       the target.  The benchmark prints the real rate anyway. */
+
+    uint32_t HotCount = (uint32_t)(0.5*HitRate*EntryCount);
+    if(HotCount < 1) HotCount = 1;
+
+    glyph_hash *HotKeys = (glyph_hash *)malloc(HotCount*sizeof(glyph_hash));
+    for(uint32_t HotIndex = 0; HotIndex < HotCount; ++HotIndex)
+    {
+        HotKeys[HotIndex] = RandomHash();
+    }
+
+    uint64_t HitThreshold = (uint64_t)(HitRate*(double)(1ull << 32));
+    glyph_hash *Result = (glyph_hash *)malloc(Count*sizeof(glyph_hash));
+    for(size_t Index = 0; Index < Count; ++Index)
+    {
+        uint64_t Roll = RandomU64();
+        if((Roll >> 32) < HitThreshold)
+        {
+            Result[Index] = HotKeys[(uint32_t)Roll % HotCount];
+        }
+        else
+        {
+            Result[Index] = RandomHash();
+        }
+    }
+
+    free(HotKeys);
+    return Result;
+}
+
+static void BenchLayout(glyph_table_params Params, char *Name, size_t Count, glyph_hash *Hashes, double TargetHitRate)
+{
+    glyph_table *Table = AllocateBenchTable(Params);
+    if(Table)
+    {
+        // NOTE: First half warms the table up, second half is timed
+        size_t WarmCount = Count / 2;
+        uint32_t Sink = RunLookups(Table, WarmCount, Hashes);
+        GetAndClearStats(Table);
+
+        double Start = GetSeconds();
+        Sink += RunLookups(Table, Count - WarmCount, Hashes + WarmCount);
+        double End = GetSeconds();
+
+        glyph_table_stats Stats = GetAndClearStats(Table);
+        double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+        printf("%-14s HashCount=%6u  target %2.0f%%  actual %5.1f%%  %6.1f ns/lookup  (%x)\n",
+               Name, Params.HashCount, 100.0*TargetHitRate,
+               100.0*(double)Stats.HitCount / LookupCount,
+               1e9*(End - Start) / LookupCount, Sink & 0xf);
+
+        FreeBenchTable(Table);
+    }
+}
+
+typedef struct
+{
+    glyph_table *Table;
+    size_t Count;
+    glyph_hash *Hashes;
+    uint32_t Sink;
+} bench_thread_work;
+
+#if _WIN32
+static DWORD WINAPI BenchThreadProc(LPVOID Param)
+#else
+static void *BenchThreadProc(void *Param)
+#endif
+{
+    bench_thread_work *Work = (bench_thread_work *)Param;
+    Work->Sink = RunLookups(Work->Table, Work->Count, Work->Hashes);
+    return 0;
+}
+
+#define MAX_BENCH_THREADS 16
+static void RunBenchThreads(uint32_t ThreadCount, bench_thread_work *Work)
+{
+    Assert(ThreadCount <= MAX_BENCH_THREADS);
+
+#if _WIN32
+    HANDLE Threads[MAX_BENCH_THREADS];
+    for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Threads[ThreadIndex] = CreateThread(0, 0, BenchThreadProc, Work + ThreadIndex, 0, 0);
+    }
+    WaitForMultipleObjects(ThreadCount, Threads, TRUE, INFINITE);
+    for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        CloseHandle(Threads[ThreadIndex]);
+    }
+#else
+    pthread_t Threads[MAX_BENCH_THREADS];
+    for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        pthread_create(&Threads[ThreadIndex], 0, BenchThreadProc, Work + ThreadIndex);
+    }
+    for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        pthread_join(Threads[ThreadIndex], 0);
+    }
+#endif
+}
+
+static void BenchThreads(uint32_t EntryCount)
+{
+    uint32_t ShardCounts[] = {1, 8, 64};
+    uint32_t ThreadCounts[] = {1, 2, 4, 8, 16};
+    size_t PerThreadCount = 256*1024;
+
+    // NOTE: All threads draw from the same hot set, so they really do share entries
+    glyph_hash *Hashes = MakeHitRateStream(MAX_BENCH_THREADS*PerThreadCount, EntryCount, 0.99);
+
+    printf("EntryCount=%u, %u lookups per thread\n", EntryCount, (uint32_t)PerThreadCount);
+    for(uint32_t ShardIndex = 0; ShardIndex < ArrayCount(ShardCounts); ++ShardIndex)
+    {
+        glyph_table_params Params = {0};
+        Params.EntryCount = EntryCount;
+        Params.HashCount = 65536;
+        Params.ReservedTileCount = 96;
+        Params.CacheTileCountInX = 256;
+        Params.ShardCount = ShardCounts[ShardIndex];
+
+        glyph_table *Table = AllocateBenchTable(Params);
+        if(Table)
+        {
+            RunLookups(Table, PerThreadCount, Hashes);
+
+            for(uint32_t CountIndex = 0; CountIndex < ArrayCount(ThreadCounts); ++CountIndex)
+            {
+                uint32_t ThreadCount = ThreadCounts[CountIndex];
+
+                bench_thread_work Work[MAX_BENCH_THREADS];
+                for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+                {
+                    Work[ThreadIndex].Table = Table;
+                    Work[ThreadIndex].Count = PerThreadCount;
+                    Work[ThreadIndex].Hashes = Hashes + ThreadIndex*PerThreadCount;
+                    Work[ThreadIndex].Sink = 0;
+                }
+
+                GetAndClearStats(Table);
+                double Start = GetSeconds();
+                RunBenchThreads(ThreadCount, Work);
+                double End = GetSeconds();
+                glyph_table_stats Stats = GetAndClearStats(Table);
+
+                double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+                printf("ShardCount=%2u  threads=%2u  %7.2f M lookups/s  hit %5.1f%%\n",
+                       Params.ShardCount, ThreadCount, 1e-6*LookupCount / (End - Start),
+                       100.0*(double)Stats.HitCount / LookupCount);
+            }
+
+            FreeBenchTable(Table);
+        }
+    }
+
+    free(Hashes);
+}
+
+static uint32_t RoundUpToPowerOfTwo(uint32_t Value)
+{
+    uint32_t Result = 1;
+    while(Result < Value) Result <<= 1;
+    return Result;
+}
+
+typedef struct
+{
+    uint32_t Count;
+    double *CDF;
+    glyph_hash *Keys;
+} zipf_vocabulary;
+
+static zipf_vocabulary MakeZipfVocabulary(uint32_t Count)
+{
+    // NOTE: Glyph usage in real text is roughly Zipf-distributed - a few very common
+    // glyphs and a long tail.
+    zipf_vocabulary Result;
+    Result.Count = Count;
+    Result.CDF = (double *)malloc(Count*sizeof(double));
+    Result.Keys = (glyph_hash *)malloc(Count*sizeof(glyph_hash));
+
+    double Total = 0.0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        double Weight = 1.0 / (double)(Index + 1);
+        Total += Weight;
+        Result.CDF[Index] = Total;
+        Result.Keys[Index] = RandomHash();
+    }
+
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        Result.CDF[Index] /= Total;
+    }
+
+    return Result;
+}
+
+static glyph_hash SampleZipf(zipf_vocabulary *Vocabulary)
+{
+    double Roll = (double)(RandomU64() >> 11) * (1.0 / 9007199254740992.0);
+
+    uint32_t Low = 0;
+    uint32_t High = Vocabulary->Count - 1;
+    while(Low < High)
+    {
+        uint32_t Mid = (Low + High) / 2;
+        if(Vocabulary->CDF[Mid] < Roll)
+        {
+            Low = Mid + 1;
+        }
+        else
+        {
+            High = Mid;
+        }
+    }
+
+    return Vocabulary->Keys[Low];
+}
+
+static void FreeZipfVocabulary(zipf_vocabulary *Vocabulary)
+{
+    free(Vocabulary->CDF);
+    free(Vocabulary->Keys);
+}
+
+static glyph_hash *MakeMixedRows(uint32_t RowCount, uint32_t ColumnCount)
+{
+    /* NOTE: Every cell that reaches the glyph table in refterm is non-ASCII, since ASCII is
+       direct-mapped.  So the rows here are a mix of Han characters (large vocabulary),
+       emoji (including multi-codepoint sequences, which are just more keys as far as the
+       table is concerned), and box-drawing/powerline style symbols. */
+    zipf_vocabulary Han = MakeZipfVocabulary(20000);
+    zipf_vocabulary Emoji = MakeZipfVocabulary(1400);
+    zipf_vocabulary Symbols = MakeZipfVocabulary(256);
+
+    size_t Count = (size_t)RowCount*ColumnCount;
+    glyph_hash *Result = (glyph_hash *)malloc(Count*sizeof(glyph_hash));
+    for(size_t Index = 0; Index < Count; ++Index)
+    {
+        uint32_t Pick = (uint32_t)(RandomU64() % 100);
+        if(Pick < 60)
+        {
+            Result[Index] = SampleZipf(&Han);
+        }
+        else if(Pick < 75)
+        {
+            Result[Index] = SampleZipf(&Emoji);
+        }
+        else
+        {
+            Result[Index] = SampleZipf(&Symbols);
+        }
+    }
+
+    FreeZipfVocabulary(&Han);
+    FreeZipfVocabulary(&Emoji);
+    FreeZipfVocabulary(&Symbols);
+
+    return Result;
+}
+
+static uint32_t RunRows(glyph_table *Table, uint32_t RowCount, uint32_t ColumnCount, glyph_hash *Hashes, int Batched)
+{
+    uint32_t Sink = 0;
+
+    glyph_state States[512];
+    Assert(ColumnCount <= ArrayCount(States));
+
+    for(uint32_t RowIndex = 0; RowIndex < RowCount; ++RowIndex)
+    {
+        glyph_hash *Row = Hashes + (size_t)RowIndex*ColumnCount;
+        if(Batched)
+        {
+            FindGlyphEntriesByHashBatch(Table, ColumnCount, Row, States);
+        }
+        else
+        {
+            for(uint32_t Column = 0; Column < ColumnCount; ++Column)
+            {
+                States[Column] = FindGlyphEntryByHash(Table, Row[Column]);
+            }
+        }
+
+        for(uint32_t Column = 0; Column < ColumnCount; ++Column)
+        {
+            if(States[Column].FilledState != BENCH_FILLED_STATE)
+            {
+                UpdateGlyphCacheEntry(Table, States[Column].ID, BENCH_FILLED_STATE, 1, 1);
+            }
+            Sink += States[Column].GPUIndex.Value;
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchBatch(uint32_t EntryCount)
+{
+    uint32_t ColumnCount = 300;
+    uint32_t RowCount = 20000;
+    glyph_hash *Hashes = MakeMixedRows(RowCount, ColumnCount);
+
+    printf("EntryCount=%u, %u rows of %u columns\n", EntryCount, RowCount, ColumnCount);
+    for(uint32_t Layout = GlyphTableLayout_Chained; Layout <= GlyphTableLayout_OpenAddressed; ++Layout)
+    {
+        for(int Batched = 0; Batched <= 1; ++Batched)
+        {
+            glyph_table_params Params = {0};
+            Params.EntryCount = EntryCount;
+            Params.HashCount = (Layout == GlyphTableLayout_OpenAddressed) ? RoundUpToPowerOfTwo(2*EntryCount) : 4096;
+            Params.ReservedTileCount = 96;
+            Params.CacheTileCountInX = 256;
+            Params.Layout = Layout;
+
+            glyph_table *Table = AllocateBenchTable(Params);
+            if(Table)
+            {
+                uint32_t Sink = RunRows(Table, RowCount / 4, ColumnCount, Hashes, Batched);
+                GetAndClearStats(Table);
+
+                double Start = GetSeconds();
+                Sink += RunRows(Table, RowCount, ColumnCount, Hashes, Batched);
+                double End = GetSeconds();
+
+                glyph_table_stats Stats = GetAndClearStats(Table);
+                double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+                printf("%-14s HashCount=%6u  %-10s hit %5.1f%%  %6.1f ns/lookup  %7.2f us/row  (%x)\n",
+                       (Layout == GlyphTableLayout_OpenAddressed) ? "open-addressed" : "chained",
+                       Params.HashCount, Batched ? "batched" : "one-by-one",
+                       100.0*(double)Stats.HitCount / LookupCount,
+                       1e9*(End - Start) / LookupCount,
+                       1e6*(End - Start) / (double)RowCount, Sink & 0xf);
+
+                FreeBenchTable(Table);
+            }
+        }
+    }
+
+    free(Hashes);
+}
+
+static int IsWideCodepoint(uint32_t Codepoint)
+{
+    // NOTE: Rough East Asian Wide/Fullwidth ranges, plus the common emoji blocks
+    int Result = (((Codepoint >= 0x1100) && (Codepoint <= 0x115F)) ||
+                  ((Codepoint >= 0x2E80) && (Codepoint <= 0xA4CF)) ||
+                  ((Codepoint >= 0xAC00) && (Codepoint <= 0xD7A3)) ||
+                  ((Codepoint >= 0xF900) && (Codepoint <= 0xFAFF)) ||
+                  ((Codepoint >= 0xFE30) && (Codepoint <= 0xFE4F)) ||
+                  ((Codepoint >= 0xFF00) && (Codepoint <= 0xFF60)) ||
+                  ((Codepoint >= 0xFFE0) && (Codepoint <= 0xFFE6)) ||
+                  ((Codepoint >= 0x1F300) && (Codepoint <= 0x1F64F)) ||
+                  ((Codepoint >= 0x1F900) && (Codepoint <= 0x1F9FF)) ||
+                  ((Codepoint >= 0x20000) && (Codepoint <= 0x3FFFD)));
+    return Result;
+}
+
+static int IsExtendingCodepoint(uint32_t Codepoint)
+{
+    // NOTE: Just enough grapheme clustering to keep combining marks, variation selectors,
+    // skin tones and ZWJ sequences in the same run as the codepoint they modify
+    int Result = (((Codepoint >= 0x0300) && (Codepoint <= 0x036F)) ||
+                  (Codepoint == 0x200D) ||
+                  ((Codepoint >= 0xFE00) && (Codepoint <= 0xFE0F)) ||
+                  ((Codepoint >= 0x1F3FB) && (Codepoint <= 0x1F3FF)));
+    return Result;
+}
+
+static glyph_hash HashTraceCodepoint(glyph_hash Hash, uint32_t Codepoint)
+{
+    Hash.Value = _mm_xor_si128(Hash.Value, _mm_set1_epi32((int)Codepoint));
+    Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+    Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+    return Hash;
+}
+
+static glyph_hash HashTraceTile(glyph_hash Hash, uint32_t TileIndex)
+{
+    // NOTE: Same derivation as ComputeHashForTileIndex
+    if(TileIndex)
+    {
+        Hash.Value = _mm_xor_si128(Hash.Value, _mm_set1_epi32((int)TileIndex));
+        Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+        Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+        Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+        Hash.Value = _mm_aesdec_si128(Hash.Value, _mm_setzero_si128());
+    }
+    return Hash;
+}
+
+static uint32_t DecodeTraceUTF8(unsigned char *At, size_t Remaining, uint32_t *Codepoint)
+{
+    // NOTE: Returns the number of bytes consumed.  Invalid bytes decode as U+FFFD, one at a time.
+    uint32_t Result = 1;
+    *Codepoint = 0xFFFD;
+
+    uint32_t Lead = At[0];
+    uint32_t Length = (Lead < 0x80) ? 1 : (Lead >= 0xF0) ? 4 : (Lead >= 0xE0) ? 3 : (Lead >= 0xC0) ? 2 : 0;
+    if(Length && (Length <= Remaining))
+    {
+        uint32_t Value = (Length == 1) ? Lead : (Lead & (0x7F >> Length));
+        uint32_t Index = 1;
+        while((Index < Length) && ((At[Index] & 0xC0) == 0x80))
+        {
+            Value = (Value << 6) | (At[Index] & 0x3F);
+            ++Index;
+        }
+
+        if(Index == Length)
+        {
+            *Codepoint = Value;
+            Result = Length;
+        }
+    }
+
+    return Result;
+}
+
+typedef struct
+{
+    size_t Count;
+    size_t Max;
+    glyph_hash *Hashes;
+} trace_stream;
+
+static void AppendTraceHash(trace_stream *Stream, glyph_hash Hash)
+{
+    if(Stream->Count == Stream->Max)
+    {
+        Stream->Max = Stream->Max ? 2*Stream->Max : 4096;
+        Stream->Hashes = (glyph_hash *)realloc(Stream->Hashes, Stream->Max*sizeof(glyph_hash));
+    }
+
+    Stream->Hashes[Stream->Count++] = Hash;
+}
+
+static void EndTraceRun(trace_stream *Stream, glyph_hash RunHash, uint32_t TileCount)
+{
+    // NOTE: The terminal looks up the run once to size it (which is also tile 0), then every other tile
+    for(uint32_t TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+    {
+        AppendTraceHash(Stream, HashTraceTile(RunHash, TileIndex));
+    }
+}
+
+static trace_stream LoadTrace(char *FileName)
+{
+    trace_stream Result = {0};
+
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        size_t Size = (size_t)ftell(File);
+        fseek(File, 0, SEEK_SET);
+
+        unsigned char *Data = (unsigned char *)malloc(Size + 1);
+        if(fread(Data, 1, Size, File) == Size)
+        {
+            glyph_hash RunHash = {0};
+            uint32_t RunTileCount = 0;
+
+            size_t At = 0;
+            while(At < Size)
+            {
+                if(Data[At] == 0x1B)
+                {
+                    // NOTE: Skip CSI (ESC [ ... final) and OSC (ESC ] ... BEL/ST) sequences, and two-byte escapes
+                    ++At;
+                    if((At < Size) && (Data[At] == '['))
+                    {
+                        ++At;
+                        while((At < Size) && !((Data[At] >= 0x40) && (Data[At] <= 0x7E))) ++At;
+                        ++At;
+                    }
+                    else if((At < Size) && (Data[At] == ']'))
+                    {
+                        while((At < Size) && (Data[At] != 0x07) && (Data[At] != 0x1B)) ++At;
+                        At += ((At < Size) && (Data[At] == 0x1B)) ? 2 : 1;
+                    }
+                    else
+                    {
+                        ++At;
+                    }
+                    continue;
+                }
+
+                uint32_t Codepoint;
+                At += DecodeTraceUTF8(Data + At, Size - At, &Codepoint);
+
+                if(RunTileCount && IsExtendingCodepoint(Codepoint))
+                {
+                    RunHash = HashTraceCodepoint(RunHash, Codepoint);
+                    if(Codepoint == 0x200D)
+                    {
+                        // NOTE: Whatever follows a ZWJ joins the run too
+                        if(At < Size)
+                        {
+                            At += DecodeTraceUTF8(Data + At, Size - At, &Codepoint);
+                            RunHash = HashTraceCodepoint(RunHash, Codepoint);
+                        }
+                    }
+                    continue;
+                }
+
+                if(RunTileCount)
+                {
+                    EndTraceRun(&Result, RunHash, RunTileCount);
+                    RunTileCount = 0;
+                }
+
+                // NOTE: Controls and direct-mapped ASCII never reach the glyph table
+                if(Codepoint >= 0x80)
+                {
+                    glyph_hash Zero = {0};
+                    RunHash = HashTraceCodepoint(Zero, Codepoint);
+                    RunTileCount = IsWideCodepoint(Codepoint) ? 2 : 1;
+                }
+            }
+
+            if(RunTileCount)
+            {
+                EndTraceRun(&Result, RunHash, RunTileCount);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Unable to read %s\n", FileName);
+        }
+
+        free(Data);
+        fclose(File);
+    }
+    else
+    {
+        fprintf(stderr, "Unable to open %s\n", FileName);
+    }
+
+    return Result;
+}
+
+typedef struct
+{
+    char *Name;
+    uint32_t Eviction;
+    uint32_t Admission;
+} trace_policy;
+
+static trace_policy TracePolicies[] =
+{
+    {"LRU", GlyphTableEviction_LRU, GlyphTableAdmission_None},
+    {"CLOCK", GlyphTableEviction_Clock, GlyphTableAdmission_None},
+    {"TinyLFU", GlyphTableEviction_LRU, GlyphTableAdmission_TinyLFU},
+};
+
+static void BenchTrace(char *FileName)
+{
+    trace_stream Stream = LoadTrace(FileName);
+    if(Stream.Count)
+    {
+        printf("%s: %zu glyph table lookups\n", FileName, Stream.Count);
+
+        uint32_t EntryCounts[] = {256, 1024, 4096, 256*120 - 96};
+        for(uint32_t SizeIndex = 0; SizeIndex < ArrayCount(EntryCounts); ++SizeIndex)
+        {
+            for(uint32_t PolicyIndex = 0; PolicyIndex < ArrayCount(TracePolicies); ++PolicyIndex)
+            {
+                trace_policy *Policy = TracePolicies + PolicyIndex;
+
+                glyph_table_params Params = {0};
+                Params.EntryCount = EntryCounts[SizeIndex];
+                Params.HashCount = 4096;
+                Params.ReservedTileCount = 96;
+                Params.CacheTileCountInX = 256;
+                Params.Eviction = Policy->Eviction;
+                Params.Admission = Policy->Admission;
+
+                // NOTE: The hit ratio and rasterizations come from the first replay, which starts cold.
+                // Short traces are then replayed on fresh tables until there are enough lookups to time.
+                glyph_table_stats Stats = {0};
+                uint32_t Sink = 0;
+                size_t TimedCount = 0;
+                double Seconds = 0.0;
+                for(uint32_t Pass = 0; (Pass == 0) || (TimedCount < 4*1024*1024); ++Pass)
+                {
+                    glyph_table *Table = AllocateBenchTable(Params);
+                    if(!Table)
+                    {
+                        break;
+                    }
+
+                    double Start = GetSeconds();
+                    Sink += RunLookups(Table, Stream.Count, Stream.Hashes);
+                    Seconds += GetSeconds() - Start;
+                    TimedCount += Stream.Count;
+
+                    if(Pass == 0)
+                    {
+                        Stats = GetAndClearStats(Table);
+                    }
+
+                    FreeBenchTable(Table);
+                }
+
+                // NOTE: Every miss comes back unfilled, so it is exactly one rasterization in the terminal
+                printf("  EntryCount=%5u %-7s hit %6.2f%%  rasterizations %8zu  rejected %8zu  %6.1f ns/lookup  (%x)\n",
+                       Params.EntryCount, Policy->Name,
+                       100.0*(double)Stats.HitCount / (double)(Stats.HitCount + Stats.MissCount),
+                       Stats.MissCount, Stats.RejectedAdmissionCount,
+                       1e9*Seconds / (double)TimedCount, Sink & 0xf);
+            }
+        }
+    }
+
+    free(Stream.Hashes);
+}
+
+typedef struct
+{
+    uint32_t RunCount;
+    glyph_hash *Hashes;
+    uint32_t *TileCounts;
+} wide_rows;
+
+static wide_rows MakeWideRows(uint32_t RowCount, uint32_t ColumnCount)
+{
+    /* NOTE: Like MakeMixedRows, but the Han characters and emoji are two cells wide, and a
+       small set of ligature-like runs is three or four cells wide, so each row is a list of
+       runs that add up to ColumnCount cells. */
+    zipf_vocabulary Han = MakeZipfVocabulary(20000);
+    zipf_vocabulary Emoji = MakeZipfVocabulary(1400);
+    zipf_vocabulary Symbols = MakeZipfVocabulary(256);
+    zipf_vocabulary Long = MakeZipfVocabulary(200);
+
+    size_t MaxRunCount = (size_t)RowCount*ColumnCount;
+    wide_rows Result;
+    Result.RunCount = 0;
+    Result.Hashes = (glyph_hash *)malloc(MaxRunCount*sizeof(glyph_hash));
+    Result.TileCounts = (uint32_t *)malloc(MaxRunCount*sizeof(uint32_t));
+    for(uint32_t RowIndex = 0; RowIndex < RowCount; ++RowIndex)
+    {
+        uint32_t Column = 0;
+        while(Column < ColumnCount)
+        {
+            glyph_hash Hash;
+            uint32_t TileCount;
+            uint32_t Pick = (uint32_t)(RandomU64() % 100);
+            if(Pick < 50)
+            {
+                Hash = SampleZipf(&Han);
+                TileCount = 2;
+            }
+            else if(Pick < 65)
+            {
+                Hash = SampleZipf(&Emoji);
+                TileCount = 2;
+            }
+            else if(Pick < 70)
+            {
+                Hash = SampleZipf(&Long);
+                TileCount = 3 + (_mm_cvtsi128_si32(Hash.Value) & 1);
+            }
+            else
+            {
+                Hash = SampleZipf(&Symbols);
+                TileCount = 1;
+            }
+
+            if((Column + TileCount) > ColumnCount)
+            {
+                TileCount = ColumnCount - Column;
+            }
+
+            Result.Hashes[Result.RunCount] = Hash;
+            Result.TileCounts[Result.RunCount] = TileCount;
+            ++Result.RunCount;
+            Column += TileCount;
+        }
+    }
+
+    FreeZipfVocabulary(&Han);
+    FreeZipfVocabulary(&Emoji);
+    FreeZipfVocabulary(&Symbols);
+    FreeZipfVocabulary(&Long);
+
+    return Result;
+}
+
+static uint32_t RunWideRows(glyph_table *Table, wide_rows *Rows, uint32_t RunCount, int UseSpans, size_t *RasterizeCount)
+{
+    /* NOTE: This does what FlushGlyphRunBatch does with each run: without spans, tile 0 is the
+       run entry and every other tile is its own lookup, and the glyph has to be rasterized
+       again if any one of its tiles was recycled.  With spans, a wide glyph gets moved into a
+       span the first time, and after that it is one lookup. */
+    uint32_t Sink = 0;
+    for(uint32_t RunIndex = 0; RunIndex < RunCount; ++RunIndex)
+    {
+        glyph_hash RunHash = Rows->Hashes[RunIndex];
+        uint32_t TileCount = Rows->TileCounts[RunIndex];
+
+        glyph_state RunEntry = FindGlyphEntryByHash(Table, RunHash);
+        if(UseSpans && (TileCount > 1) && (RunEntry.TileSpan < TileCount))
+        {
+            RunEntry = FindGlyphSpanByHash(Table, RunHash, TileCount);
+        }
+
+        if(RunEntry.TileSpan >= TileCount)
+        {
+            if(RunEntry.FilledState != BENCH_FILLED_STATE)
+            {
+                UpdateGlyphCacheEntry(Table, RunEntry.ID, BENCH_FILLED_STATE, 1, 1);
+                ++*RasterizeCount;
+            }
+
+            for(uint32_t TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+            {
+                Sink += GetGlyphSpanTile(RunEntry, TileIndex).Value;
+            }
+        }
+        else
+        {
+            int Rasterized = 0;
+            for(uint32_t TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+            {
+                glyph_state Entry = TileIndex ? FindGlyphEntryByHash(Table, HashTraceTile(RunHash, TileIndex)) : RunEntry;
+                if(Entry.FilledState != BENCH_FILLED_STATE)
+                {
+                    UpdateGlyphCacheEntry(Table, Entry.ID, BENCH_FILLED_STATE, 1, 1);
+                    Rasterized = 1;
+                }
+                Sink += Entry.GPUIndex.Value;
+            }
+            *RasterizeCount += Rasterized;
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchSpans(uint32_t EntryCount)
+{
+    uint32_t ColumnCount = 300;
+    uint32_t RowCount = 20000;
+    wide_rows Rows = MakeWideRows(RowCount, ColumnCount);
+
+    // NOTE: Both tables get the same number of texture tiles
+    uint32_t TextureTileCount = EntryCount + 96;
+
+    printf("%u texture tiles, %u rows of %u columns (%.1f runs/row)\n", TextureTileCount, RowCount, ColumnCount,
+           (double)Rows.RunCount / (double)RowCount);
+    for(int UseSpans = 0; UseSpans <= 1; ++UseSpans)
+    {
+        glyph_table_params Params = {0};
+        Params.HashCount = 4096;
+        Params.ReservedTileCount = 96;
+        Params.CacheTileCountInX = 256;
+        if(UseSpans)
+        {
+            // NOTE: The same split RefreshFont uses
+            Params.SpanEntryCounts[0] = TextureTileCount / 4;
+            Params.SpanEntryCounts[1] = TextureTileCount / 64;
+        }
+        Params.EntryCount = TextureTileCount - GetGlyphTableTileCount(Params);
+
+        glyph_table *Table = AllocateBenchTable(Params);
+        if(Table)
+        {
+            size_t RasterizeCount = 0;
+            uint32_t WarmRunCount = Rows.RunCount / 4;
+            uint32_t Sink = RunWideRows(Table, &Rows, WarmRunCount, UseSpans, &RasterizeCount);
+            GetAndClearStats(Table);
+            RasterizeCount = 0;
+
+            double Start = GetSeconds();
+            Sink += RunWideRows(Table, &Rows, Rows.RunCount, UseSpans, &RasterizeCount);
+            double End = GetSeconds();
+
+            glyph_table_stats Stats = GetAndClearStats(Table);
+            double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+            printf("%-10s singles=%6u  hit %5.1f%%  %5.1f lookups/row  %7.2f us/row  %6.2f rasterizations/row  %5.2f spans moved/row  (%x)\n",
+                   UseSpans ? "spans" : "per-tile", Params.EntryCount,
+                   100.0*(double)Stats.HitCount / LookupCount,
+                   LookupCount / (double)RowCount,
+                   1e6*(End - Start) / (double)RowCount,
+                   (double)RasterizeCount / (double)RowCount,
+                   (double)Stats.SpanCount / (double)RowCount, Sink & 0xf);
+
+            FreeBenchTable(Table);
+        }
+    }
+
+    free(Rows.Hashes);
+    free(Rows.TileCounts);
+}
+
+typedef struct
+{
+    uint32_t FrameCount;
+    uint32_t RowCount;
+    uint32_t *RowStarts; // NOTE: FrameCount*RowCount + 1 offsets into Hashes
+    glyph_hash *Hashes;
+    size_t HashCount;
+} tui_frames;
+
+static void AppendTUICodepoint(tui_frames *Frames, uint32_t Codepoint, uint32_t Count)
+{
+    glyph_hash Hash = HashTraceCodepoint((glyph_hash){0}, Codepoint);
+    while(Count--)
+    {
+        Frames->Hashes[Frames->HashCount++] = Hash;
+    }
+}
+
+static tui_frames MakeTUIFrames(uint32_t FrameCount, uint32_t RowCount, uint32_t ColumnCount)
+{
+    /* NOTE: Only the cells that would reach the glyph table are generated - the ASCII text
+       around them (process names, numbers, the words in the status line) is direct-mapped.
+       Each frame is a tmux-style window split in two panes:
+
+       - box-drawing borders all the way around and between the panes,
+       - htop-style meter bars in the left pane, made of full blocks, one partial block and
+         light shade, whose lengths change every frame,
+       - a powerline-style status row, and a process tree drawn with box-drawing characters,
+       - a CJK paragraph scrolling by one line per frame in the right pane.
+
+       So almost every cell is the same few dozen glyphs over and over, in long runs of the
+       same glyph, plus one pane of larger-vocabulary text that moves. */
+    zipf_vocabulary Han = MakeZipfVocabulary(3000);
+
+    uint32_t PaneWidth = (ColumnCount - 3) / 2;
+    uint32_t ParagraphLineCount = FrameCount + RowCount;
+    uint32_t ParagraphLineLength = PaneWidth / 2;
+    glyph_hash *Paragraph = (glyph_hash *)malloc((size_t)ParagraphLineCount*ParagraphLineLength*sizeof(glyph_hash));
+    for(size_t Index = 0; Index < (size_t)ParagraphLineCount*ParagraphLineLength; ++Index)
+    {
+        Paragraph[Index] = SampleZipf(&Han);
+    }
+
+    tui_frames Result = {0};
+    Result.FrameCount = FrameCount;
+    Result.RowCount = RowCount;
+    Result.RowStarts = (uint32_t *)malloc(((size_t)FrameCount*RowCount + 1)*sizeof(uint32_t));
+    Result.Hashes = (glyph_hash *)malloc((size_t)FrameCount*RowCount*ColumnCount*sizeof(glyph_hash));
+
+    for(uint32_t FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        for(uint32_t RowIndex = 0; RowIndex < RowCount; ++RowIndex)
+        {
+            Result.RowStarts[FrameIndex*RowCount + RowIndex] = (uint32_t)Result.HashCount;
+            if((RowIndex == 0) || (RowIndex == (RowCount - 1)))
+            {
+                int Top = (RowIndex == 0);
+                AppendTUICodepoint(&Result, Top ? 0x250C : 0x2514, 1);
+                AppendTUICodepoint(&Result, 0x2500, PaneWidth);
+                AppendTUICodepoint(&Result, Top ? 0x252C : 0x2534, 1);
+                AppendTUICodepoint(&Result, 0x2500, PaneWidth);
+                AppendTUICodepoint(&Result, Top ? 0x2510 : 0x2518, 1);
+                continue;
+            }
+
+            AppendTUICodepoint(&Result, 0x2502, 1);
+            if(RowIndex <= 8)
+            {
+                // NOTE: "  1[" and the percentage are ASCII, so only the bar itself is here
+                uint32_t BarWidth = PaneWidth - 12;
+                uint32_t Eighths = (uint32_t)(RandomU64() % (8*BarWidth));
+                AppendTUICodepoint(&Result, 0x2588, Eighths / 8);
+                if(Eighths % 8)
+                {
+                    AppendTUICodepoint(&Result, 0x2590 - (Eighths % 8), 1);
+                }
+                AppendTUICodepoint(&Result, 0x2591, BarWidth - (Eighths + 7) / 8);
+            }
+            else if(RowIndex == 9)
+            {
+                uint32_t Separators[] = {0xE0B0, 0xE0B1, 0xE0A0, 0xE0B2, 0xE0B3, 0x2387, 0x25CF};
+                for(uint32_t Index = 0; Index < ArrayCount(Separators); ++Index)
+                {
+                    AppendTUICodepoint(&Result, Separators[Index], 1);
+                }
+            }
+            else
+            {
+                // NOTE: Process tree, a few levels deep
+                uint32_t Depth = (uint32_t)((RowIndex*7 + FrameIndex / 16) % 5);
+                AppendTUICodepoint(&Result, 0x2502, Depth);
+                AppendTUICodepoint(&Result, (RowIndex % 4) ? 0x251C : 0x2514, 1);
+                AppendTUICodepoint(&Result, 0x2500, 1);
+            }
+            AppendTUICodepoint(&Result, 0x2502, 1);
+
+            glyph_hash *Line = Paragraph + (size_t)(FrameIndex + RowIndex)*ParagraphLineLength;
+            for(uint32_t Index = 0; Index < ParagraphLineLength; ++Index)
+            {
+                Result.Hashes[Result.HashCount++] = Line[Index];
+            }
+            AppendTUICodepoint(&Result, 0x2502, 1);
+        }
+    }
+    Result.RowStarts[FrameCount*RowCount] = (uint32_t)Result.HashCount;
+
+    free(Paragraph);
+    FreeZipfVocabulary(&Han);
+
+    return Result;
+}
+
+static uint32_t RunTUIFrames(glyph_table *Table, tui_frames *Frames, uint32_t RunFrameCount, int Batched)
+{
+    uint32_t Sink = 0;
+
+    glyph_state States[512];
+    for(uint32_t RunFrameIndex = 0; RunFrameIndex < RunFrameCount; ++RunFrameIndex)
+    {
+        uint32_t FrameIndex = RunFrameIndex % Frames->FrameCount;
+        BeginGlyphTableFrame(Table);
+        for(uint32_t RowIndex = 0; RowIndex < Frames->RowCount; ++RowIndex)
+        {
+            uint32_t Start = Frames->RowStarts[FrameIndex*Frames->RowCount + RowIndex];
+            uint32_t Count = Frames->RowStarts[FrameIndex*Frames->RowCount + RowIndex + 1] - Start;
+            glyph_hash *Row = Frames->Hashes + Start;
+            Assert(Count <= ArrayCount(States));
+
+            if(Batched)
+            {
+                FindGlyphEntriesByHashBatch(Table, Count, Row, States);
+            }
+            else
+            {
+                for(uint32_t Column = 0; Column < Count; ++Column)
+                {
+                    States[Column] = FindGlyphEntryByHash(Table, Row[Column]);
+                }
+            }
+
+            for(uint32_t Column = 0; Column < Count; ++Column)
+            {
+                if(States[Column].FilledState != BENCH_FILLED_STATE)
+                {
+                    UpdateGlyphCacheEntry(Table, States[Column].ID, BENCH_FILLED_STATE, 1, 1);
+                }
+                Sink += States[Column].GPUIndex.Value;
+            }
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchFront(uint32_t EntryCount)
+{
+    uint32_t FrameCount = 256;
+    uint32_t RowCount = 50;
+    uint32_t ColumnCount = 200;
+    uint32_t RunFrameCount = 4096;
+    tui_frames Frames = MakeTUIFrames(FrameCount, RowCount, ColumnCount);
+
+    uint32_t FrontCacheCounts[] = {0, 16, 64, 256};
+
+    printf("EntryCount=%u, %u frames of %ux%u (%.0f table lookups per frame)\n", EntryCount, RunFrameCount,
+           ColumnCount, RowCount, (double)Frames.HashCount / (double)FrameCount);
+    for(int Batched = 0; Batched <= 1; ++Batched)
+    {
+        for(uint32_t CountIndex = 0; CountIndex < ArrayCount(FrontCacheCounts); ++CountIndex)
+        {
+            glyph_table_params Params = {0};
+            Params.EntryCount = EntryCount;
+            Params.HashCount = RoundUpToPowerOfTwo(2*EntryCount);
+            Params.ReservedTileCount = 96;
+            Params.CacheTileCountInX = 256;
+            Params.Layout = GlyphTableLayout_OpenAddressed;
+            Params.FrontCacheCount = FrontCacheCounts[CountIndex];
+
+            glyph_table *Table = AllocateBenchTable(Params);
+            if(Table)
+            {
+                uint32_t Sink = RunTUIFrames(Table, &Frames, FrameCount, Batched);
+                GetAndClearStats(Table);
+
+                double Start = GetSeconds();
+                Sink += RunTUIFrames(Table, &Frames, RunFrameCount, Batched);
+                double End = GetSeconds();
+
+                glyph_table_stats Stats = GetAndClearStats(Table);
+                double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+                printf("FrontCacheCount=%4u  %-10s hit %5.1f%%  front %5.1f%%  %6.1f ns/lookup  %7.1f us/frame  (%x)\n",
+                       Params.FrontCacheCount, Batched ? "batched" : "one-by-one",
+                       100.0*(double)Stats.HitCount / LookupCount,
+                       100.0*(double)Stats.FrontHitCount / LookupCount,
+                       1e9*(End - Start) / LookupCount,
+                       1e6*(End - Start) / (double)RunFrameCount, Sink & 0xf);
+
+                FreeBenchTable(Table);
+            }
+        }
+    }
+
+    free(Frames.RowStarts);
+    free(Frames.Hashes);
+}
+
+static uint32_t *MakeCodepointFrames(uint32_t FrameCount, uint32_t CellCount)
+{
+    /* NOTE: Every cell is one BMP codepoint that would reach the glyph table: a third
+       box-drawing and block characters, a third Cyrillic and Greek text (one tile each),
+       and a third Han characters, which are two tiles wide and so can never be mapped. */
+    uint32_t *Result = (uint32_t *)malloc((size_t)FrameCount*CellCount*sizeof(uint32_t));
+    for(size_t Index = 0; Index < (size_t)FrameCount*CellCount; ++Index)
+    {
+        uint32_t Pick = (uint32_t)(RandomU64() % 3);
+        uint32_t Rank = (uint32_t)(RandomU64() % 64);
+        Rank = (Rank*Rank) / 64; // NOTE: Skewed towards the low ranks, like real text
+        if(Pick == 0)
+        {
+            Result[Index] = 0x2500 + Rank % 160;
+        }
+        else if(Pick == 1)
+        {
+            Result[Index] = (Rank & 1) ? (0x0410 + Rank / 2) : (0x0391 + Rank / 4);
+        }
+        else
+        {
+            Result[Index] = 0x4E00 + Rank*37 + (uint32_t)(RandomU64() % 8);
+        }
+    }
+
+    return Result;
+}
+
+static int IsBenchWideCodepoint(uint32_t Codepoint)
+{
+    int Result = (Codepoint >= 0x4E00);
+    return Result;
+}
+
+static uint32_t RunCodepointFrames(glyph_table *Table, uint32_t FrameCount, uint32_t CellCount, uint32_t *Codepoints, int UsePageTable)
+{
+    uint32_t Sink = 0;
+    for(uint32_t FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        BeginGlyphTableFrame(Table);
+
+        uint32_t *Frame = Codepoints + (size_t)FrameIndex*CellCount;
+        for(uint32_t CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+        {
+            uint32_t Codepoint = Frame[CellIndex];
+
+            glyph_state State;
+            if(!UsePageTable || !FindGlyphEntryByCodepoint(Table, Codepoint, BENCH_FILLED_STATE, &State))
+            {
+                // NOTE: HashTraceCodepoint stands in for ComputeGlyphHash over the UTF-8
+                State = FindGlyphEntryByHash(Table, HashTraceCodepoint((glyph_hash){0}, Codepoint));
+                if(State.FilledState != BENCH_FILLED_STATE)
+                {
+                    UpdateGlyphCacheEntry(Table, State.ID, BENCH_FILLED_STATE, 1, 1);
+                }
+
+                if(UsePageTable && !IsBenchWideCodepoint(Codepoint))
+                {
+                    MapGlyphCodepoint(Table, Codepoint, State.ID);
+                }
+            }
+
+            Sink += State.GPUIndex.Value;
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchCodepoints(uint32_t EntryCount)
+{
+    uint32_t CellCount = 200*50;
+    uint32_t FrameCount = 64;
+    uint32_t RunFrameCount = 1024;
+    uint32_t *Codepoints = MakeCodepointFrames(FrameCount, CellCount);
+
+    printf("EntryCount=%u, %u frames of %u cells\n", EntryCount, RunFrameCount, CellCount);
+    for(uint32_t Layout = GlyphTableLayout_Chained; Layout <= GlyphTableLayout_OpenAddressed; ++Layout)
+    {
+        for(int UsePageTable = 0; UsePageTable <= 1; ++UsePageTable)
+        {
+            glyph_table_params Params = {0};
+            Params.EntryCount = EntryCount;
+            Params.HashCount = (Layout == GlyphTableLayout_OpenAddressed) ? RoundUpToPowerOfTwo(2*EntryCount) : 4096;
+            Params.ReservedTileCount = 96;
+            Params.CacheTileCountInX = 256;
+            Params.Layout = Layout;
+            Params.DirectPageCount = UsePageTable ? 64 : 0;
+
+            glyph_table *Table = AllocateBenchTable(Params);
+            if(Table)
+            {
+                uint32_t Sink = RunCodepointFrames(Table, FrameCount, CellCount, Codepoints, UsePageTable);
+                GetAndClearStats(Table);
+
+                double Start = GetSeconds();
+                for(uint32_t RunIndex = 0; RunIndex < (RunFrameCount / FrameCount); ++RunIndex)
+                {
+                    Sink += RunCodepointFrames(Table, FrameCount, CellCount, Codepoints, UsePageTable);
+                }
+                double End = GetSeconds();
+
+                glyph_table_stats Stats = GetAndClearStats(Table);
+                double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+                printf("%-14s %-11s hit %5.1f%%  codepoint %5.1f%%  %6.1f ns/cell  (%x)\n",
+                       (Layout == GlyphTableLayout_OpenAddressed) ? "open-addressed" : "chained",
+                       UsePageTable ? "page table" : "hash only",
+                       100.0*(double)Stats.HitCount / LookupCount,
+                       100.0*(double)Stats.DirectHitCount / LookupCount,
+                       1e9*(End - Start) / ((double)RunFrameCount*CellCount), Sink & 0xf);
+
+                FreeBenchTable(Table);
+            }
+        }
+    }
+
+    free(Codepoints);
+}
+
+typedef struct
+{
+    uint32_t Count;
+    uint32_t MaxCount;
+    uint32_t ScalarCount; // NOTE: The first ScalarCount clusters are single scalar values, the rest are sequences
+    uint32_t ByteCount;
+    uint32_t MaxByteCount;
+    char unsigned *Bytes; // NOTE: The UTF-8 of every cluster, back to back
+    uint32_t *Starts; // NOTE: Count + 1 starts, in bytes
+} hash_corpus;
+
+static uint32_t EncodeBenchUTF8(uint32_t Codepoint, char unsigned *Dest)
+{
+    uint32_t Result = 0;
+    if(Codepoint < 0x80)
+    {
+        Dest[Result++] = (char unsigned)Codepoint;
+    }
+    else if(Codepoint < 0x800)
+    {
+        Dest[Result++] = (char unsigned)(0xC0 | (Codepoint >> 6));
+        Dest[Result++] = (char unsigned)(0x80 | (Codepoint & 0x3F));
+    }
+    else if(Codepoint < 0x10000)
+    {
+        Dest[Result++] = (char unsigned)(0xE0 | (Codepoint >> 12));
+        Dest[Result++] = (char unsigned)(0x80 | ((Codepoint >> 6) & 0x3F));
+        Dest[Result++] = (char unsigned)(0x80 | (Codepoint & 0x3F));
+    }
+    else
+    {
+        Dest[Result++] = (char unsigned)(0xF0 | (Codepoint >> 18));
+        Dest[Result++] = (char unsigned)(0x80 | ((Codepoint >> 12) & 0x3F));
+        Dest[Result++] = (char unsigned)(0x80 | ((Codepoint >> 6) & 0x3F));
+        Dest[Result++] = (char unsigned)(0x80 | (Codepoint & 0x3F));
+    }
+
+    return Result;
+}
+
+static void AppendCorpusCodepoint(hash_corpus *Corpus, uint32_t Codepoint)
+{
+    if((Corpus->ByteCount + 4) > Corpus->MaxByteCount)
+    {
+        Corpus->MaxByteCount = 2*Corpus->MaxByteCount + 4096;
+        Corpus->Bytes = (char unsigned *)realloc(Corpus->Bytes, Corpus->MaxByteCount);
+    }
+
+    Corpus->ByteCount += EncodeBenchUTF8(Codepoint, Corpus->Bytes + Corpus->ByteCount);
+}
+
+static void EndCorpusCluster(hash_corpus *Corpus)
+{
+    if((Corpus->Count + 2) > Corpus->MaxCount)
+    {
+        Corpus->MaxCount = 2*Corpus->MaxCount + 1024;
+        Corpus->Starts = (uint32_t *)realloc(Corpus->Starts, Corpus->MaxCount*sizeof(uint32_t));
+        Corpus->Starts[0] = 0;
+    }
+
+    Corpus->Starts[++Corpus->Count] = Corpus->ByteCount;
+}
+
+static hash_corpus MakeHashCorpus(void)
+{
+    /* NOTE: Every Unicode scalar value on its own, plus the kinds of multi-codepoint
+       clusters terminals actually see: letters with one and two combining marks, Hangul
+       syllables spelled as jamo, Devanagari conjuncts, emoji with skin tones, emoji ZWJ
+       pairs and flags.  About 2.4 million distinct clusters, hashed as UTF-8 the way the
+       terminal does. */
+    hash_corpus Corpus = {0};
+
+    for(uint32_t Codepoint = 0; Codepoint <= 0x10FFFF; ++Codepoint)
+    {
+        if((Codepoint < 0xD800) || (Codepoint > 0xDFFF))
+        {
+            AppendCorpusCodepoint(&Corpus, Codepoint);
+            EndCorpusCluster(&Corpus);
+        }
+    }
+    Corpus.ScalarCount = Corpus.Count;
+
+    uint32_t Bases[52 + 25 + 32];
+    uint32_t BaseCount = 0;
+    for(uint32_t Letter = 0; Letter < 26; ++Letter)
+    {
+        Bases[BaseCount++] = 'A' + Letter;
+        Bases[BaseCount++] = 'a' + Letter;
+    }
+    for(uint32_t Letter = 0; Letter < 25; ++Letter)
+    {
+        Bases[BaseCount++] = 0x03B1 + Letter;
+    }
+    for(uint32_t Letter = 0; Letter < 32; ++Letter)
+    {
+        Bases[BaseCount++] = 0x0430 + Letter;
+    }
+
+    for(uint32_t BaseIndex = 0; BaseIndex < BaseCount; ++BaseIndex)
+    {
+        for(uint32_t Mark = 0x0300; Mark < 0x0370; ++Mark)
+        {
+            AppendCorpusCodepoint(&Corpus, Bases[BaseIndex]);
+            AppendCorpusCodepoint(&Corpus, Mark);
+            EndCorpusCluster(&Corpus);
+        }
+    }
+
+    for(uint32_t BaseIndex = 0; BaseIndex < 52; ++BaseIndex)
+    {
+        for(uint32_t Mark0 = 0x0300; Mark0 < 0x0370; ++Mark0)
+        {
+            for(uint32_t Mark1 = 0x0300; Mark1 < 0x0370; ++Mark1)
+            {
+                AppendCorpusCodepoint(&Corpus, Bases[BaseIndex]);
+                AppendCorpusCodepoint(&Corpus, Mark0);
+                AppendCorpusCodepoint(&Corpus, Mark1);
+                EndCorpusCluster(&Corpus);
+            }
+        }
+    }
+
+    for(uint32_t Lead = 0x1100; Lead < 0x1113; ++Lead)
+    {
+        for(uint32_t Vowel = 0x1161; Vowel < 0x1176; ++Vowel)
+        {
+            for(uint32_t Trail = 0x11A7; Trail < 0x11C3; ++Trail)
+            {
+                AppendCorpusCodepoint(&Corpus, Lead);
+                AppendCorpusCodepoint(&Corpus, Vowel);
+                if(Trail != 0x11A7)
+                {
+                    AppendCorpusCodepoint(&Corpus, Trail);
+                }
+                EndCorpusCluster(&Corpus);
+            }
+        }
+    }
+
+    for(uint32_t Consonant0 = 0x0915; Consonant0 <= 0x0939; ++Consonant0)
+    {
+        for(uint32_t Consonant1 = 0x0915; Consonant1 <= 0x0939; ++Consonant1)
+        {
+            for(uint32_t Vowel = 0x093E; Vowel <= 0x094C; ++Vowel)
+            {
+                AppendCorpusCodepoint(&Corpus, Consonant0);
+                AppendCorpusCodepoint(&Corpus, 0x094D);
+                AppendCorpusCodepoint(&Corpus, Consonant1);
+                AppendCorpusCodepoint(&Corpus, Vowel);
+                EndCorpusCluster(&Corpus);
+            }
+        }
+    }
+
+    for(uint32_t Emoji = 0x1F300; Emoji < 0x1F700; ++Emoji)
+    {
+        for(uint32_t Tone = 0x1F3FB; Tone <= 0x1F3FF; ++Tone)
+        {
+            AppendCorpusCodepoint(&Corpus, Emoji);
+            AppendCorpusCodepoint(&Corpus, Tone);
+            EndCorpusCluster(&Corpus);
+        }
+    }
+
+    for(uint32_t Emoji0 = 0x1F300; Emoji0 < 0x1F600; ++Emoji0)
+    {
+        for(uint32_t Emoji1 = 0x1F300; Emoji1 < 0x1F600; ++Emoji1)
+        {
+            AppendCorpusCodepoint(&Corpus, Emoji0);
+            AppendCorpusCodepoint(&Corpus, 0x200D);
+            AppendCorpusCodepoint(&Corpus, Emoji1);
+            EndCorpusCluster(&Corpus);
+        }
+    }
+
+    for(uint32_t Flag0 = 0x1F1E6; Flag0 <= 0x1F1FF; ++Flag0)
+    {
+        for(uint32_t Flag1 = 0x1F1E6; Flag1 <= 0x1F1FF; ++Flag1)
+        {
+            AppendCorpusCodepoint(&Corpus, Flag0);
+            AppendCorpusCodepoint(&Corpus, Flag1);
+            EndCorpusCluster(&Corpus);
+        }
+    }
+
+    return Corpus;
+}
+
+static int CompareHashes(const void *AInit, const void *BInit)
+{
+    uint64_t *A = (uint64_t *)AInit;
+    uint64_t *B = (uint64_t *)BInit;
+    int Result = (A[1] < B[1]) ? -1 : (A[1] > B[1]) ? 1 : (A[0] < B[0]) ? -1 : (A[0] > B[0]) ? 1 : 0;
+    return Result;
+}
+
+static int CompareU32(const void *AInit, const void *BInit)
+{
+    uint32_t A = *(uint32_t *)AInit;
+    uint32_t B = *(uint32_t *)BInit;
+    int Result = (A < B) ? -1 : (A > B) ? 1 : 0;
+    return Result;
+}
+
+static void BenchHashThroughput(char unsigned *Data, size_t DataSize, size_t RunSize)
+{
+    // NOTE: Independent runs back to back for GB/s, and then each run's start picked from
+    // the previous hash, which measures the latency a single glyph lookup waits on.
+    size_t RunCount = DataSize / RunSize;
+    size_t RepeatCount = (size_t)(64*1024*1024) / DataSize;
+    uint32_t Sink = 0;
+
+    double Start = GetSeconds();
+    for(size_t Repeat = 0; Repeat < RepeatCount; ++Repeat)
+    {
+        char unsigned *At = Data;
+        for(size_t RunIndex = 0; RunIndex < RunCount; ++RunIndex)
+        {
+            Sink += (uint32_t)_mm_cvtsi128_si32(ComputeGlyphHash(RunSize, At, DefaultSeed).Value);
+            At += RunSize;
+        }
+    }
+    double Middle = GetSeconds();
+
+    size_t Offset = 0;
+    for(size_t Repeat = 0; Repeat < RepeatCount; ++Repeat)
+    {
+        for(size_t RunIndex = 0; RunIndex < RunCount; ++RunIndex)
+        {
+            uint32_t Value = (uint32_t)_mm_cvtsi128_si32(ComputeGlyphHash(RunSize, Data + Offset, DefaultSeed).Value);
+            Offset = (Value % RunCount)*RunSize;
+        }
+    }
+    double End = GetSeconds();
+
+    double HashCount = (double)RepeatCount*RunCount;
+    printf("  %5u-byte runs: %6.2f GB/s  %5.2f ns/hash  %5.2f ns latency  (%x)\n",
+           (uint32_t)RunSize, (HashCount*RunSize) / (1e9*(Middle - Start)),
+           1e9*(Middle - Start) / HashCount, 1e9*(End - Middle) / HashCount, (Sink + (uint32_t)Offset) & 0xf);
+}
+
+static void BenchHashRows(hash_corpus *Corpus)
+{
+    // NOTE: Rows of 256 clusters picked from the corpus and copied next to each other, like
+    // the terminal's glyph_run_batch, hashed one ComputeGlyphHash at a time like the terminal
+    // used to, and then a row per ComputeGlyphHashes.  Few enough rows to stay in the cache,
+    // since that's where the terminal's are.
+    uint32_t RowLength = 256;
+    uint32_t RowCount = 16;
+    uint32_t InputCount = RowLength*RowCount;
+    glyph_hash_input *Inputs = (glyph_hash_input *)malloc(InputCount*sizeof(glyph_hash_input));
+    glyph_hash *Single = (glyph_hash *)malloc(InputCount*sizeof(glyph_hash));
+    glyph_hash *Batched = (glyph_hash *)malloc(InputCount*sizeof(glyph_hash));
+    char unsigned *Bytes = (char unsigned *)malloc(InputCount*16);
+    uint32_t ByteCount = 0;
+    for(uint32_t Index = 0; Index < InputCount; ++Index)
+    {
+        uint32_t Cluster = (uint32_t)(RandomU64() % Corpus->Count);
+        uint32_t ClusterByteCount = Corpus->Starts[Cluster + 1] - Corpus->Starts[Cluster];
+        memcpy(Bytes + ByteCount, Corpus->Bytes + Corpus->Starts[Cluster], ClusterByteCount);
+        Inputs[Index].At = Bytes + ByteCount;
+        Inputs[Index].Count = ClusterByteCount;
+        ByteCount += ClusterByteCount;
+    }
+
+    // NOTE: Best of several tries, since a single try is easily disturbed
+    uint32_t RepeatCount = 64;
+    double SingleTime = 1e9;
+    double BatchedTime = 1e9;
+    for(uint32_t Try = 0; Try < 8; ++Try)
+    {
+        double Start = GetSeconds();
+        for(uint32_t Repeat = 0; Repeat < RepeatCount; ++Repeat)
+        {
+            for(uint32_t Index = 0; Index < InputCount; ++Index)
+            {
+                Single[Index] = ComputeGlyphHash(Inputs[Index].Count, Inputs[Index].At, DefaultSeed);
+            }
+        }
+        double Middle = GetSeconds();
+        for(uint32_t Repeat = 0; Repeat < RepeatCount; ++Repeat)
+        {
+            for(uint32_t Row = 0; Row < RowCount; ++Row)
+            {
+                ComputeGlyphHashes(RowLength, Inputs + Row*RowLength, DefaultSeed, Batched + Row*RowLength);
+            }
+        }
+        double End = GetSeconds();
+
+        SingleTime = ((Middle - Start) < SingleTime) ? (Middle - Start) : SingleTime;
+        BatchedTime = ((End - Middle) < BatchedTime) ? (End - Middle) : BatchedTime;
+    }
+
+    uint32_t MismatchCount = 0;
+    for(uint32_t Index = 0; Index < InputCount; ++Index)
+    {
+        MismatchCount += !GlyphHashesAreEqual(Single[Index], Batched[Index]);
+    }
+
+    double HashCount = (double)RepeatCount*InputCount;
+    printf("  %u-cluster rows: %5.2f ns/cluster one at a time, %5.2f ns/cluster batched (%u mismatches)\n",
+           RowLength, 1e9*SingleTime / HashCount, 1e9*BatchedTime / HashCount, MismatchCount);
+
+    free(Bytes);
+    free(Batched);
+    free(Single);
+    free(Inputs);
+}
+
+static void BenchHash(void)
+{
+    size_t DataSize = 64*1024;
+    char unsigned *Data = (char unsigned *)malloc(DataSize);
+    for(size_t Index = 0; Index < DataSize; ++Index)
+    {
+        Data[Index] = (char unsigned)RandomU64();
+    }
+
+    hash_corpus Corpus = MakeHashCorpus();
+    glyph_hash *Hashes = (glyph_hash *)malloc(Corpus.Count*sizeof(glyph_hash));
+    uint32_t *Slots = (uint32_t *)malloc(Corpus.Count*sizeof(uint32_t));
+    memset(Hashes, 0, Corpus.Count*sizeof(glyph_hash));
+    memset(Slots, 0, Corpus.Count*sizeof(uint32_t));
+
+    uint32_t BucketCount = 65536;
+    uint32_t *Buckets = (uint32_t *)malloc(BucketCount*sizeof(uint32_t));
+
+    // NOTE: For n uniformly random 32-bit values, about n^2/2^33 pairs share a value
+    double ExpectedSlotCollisions = ((double)Corpus.Count*(double)Corpus.Count) / 8589934592.0;
+    printf("Corpus: %u clusters, %u UTF-8 bytes; a random 32-bit slot would have ~%.0f collisions\n",
+           Corpus.Count, Corpus.ByteCount, ExpectedSlotCollisions);
+
+    glyph_hash_backend Original = GetGlyphHashBackend();
+    for(uint32_t Backend = 0; Backend < GlyphHashBackend_Count; ++Backend)
+    {
+        if(!SetGlyphHashBackend((glyph_hash_backend)Backend))
+        {
+            printf("%s: not supported here\n", GetGlyphHashBackendName((glyph_hash_backend)Backend));
+            continue;
+        }
+
+        printf("%s:\n", GetGlyphHashBackendName((glyph_hash_backend)Backend));
+        BenchHashThroughput(Data, DataSize, 2);
+        BenchHashThroughput(Data, DataSize, 8);
+        BenchHashThroughput(Data, DataSize, 64);
+        BenchHashThroughput(Data, DataSize, 4096);
+
+        double Start = GetSeconds();
+        for(uint32_t Index = 0; Index < Corpus.Count; ++Index)
+        {
+            uint32_t First = Corpus.Starts[Index];
+            Hashes[Index] = ComputeGlyphHash(Corpus.Starts[Index + 1] - First, Corpus.Bytes + First, DefaultSeed);
+        }
+        double End = GetSeconds();
+
+        memset(Buckets, 0, BucketCount*sizeof(uint32_t));
+        for(uint32_t Index = 0; Index < Corpus.Count; ++Index)
+        {
+            Slots[Index] = (uint32_t)_mm_cvtsi128_si32(Hashes[Index].Value);
+            ++Buckets[Slots[Index] & (BucketCount - 1)];
+        }
+
+        qsort(Hashes, Corpus.Count, sizeof(glyph_hash), CompareHashes);
+        qsort(Slots, Corpus.Count, sizeof(uint32_t), CompareU32);
+
+        uint32_t HashCollisions = 0;
+        uint32_t SlotCollisions = 0;
+        for(uint32_t Index = 1; Index < Corpus.Count; ++Index)
+        {
+            HashCollisions += (CompareHashes(Hashes + Index - 1, Hashes + Index) == 0);
+            SlotCollisions += (Slots[Index - 1] == Slots[Index]);
+        }
+
+        // NOTE: Sum of squared bucket loads over what a uniform hash would give, so ~1.0 is
+        // as good as it gets, and anything well above means longer hash chains
+        double Expected = (double)Corpus.Count / BucketCount;
+        double SquareSum = 0;
+        uint32_t MaxLoad = 0;
+        for(uint32_t Bucket = 0; Bucket < BucketCount; ++Bucket)
+        {
+            SquareSum += (double)Buckets[Bucket]*(double)Buckets[Bucket];
+            MaxLoad = (Buckets[Bucket] > MaxLoad) ? Buckets[Bucket] : MaxLoad;
+        }
+        double Uniformity = SquareSum / ((double)BucketCount*(Expected*Expected + Expected));
+
+        BenchHashRows(&Corpus);
+
+        printf("  corpus: %5.2f ns/cluster, %u full 128-bit collisions, %u low 32-bit collisions, %u-slot chains %.3fx uniform (max %u, mean %.1f)\n",
+               1e9*(End - Start) / Corpus.Count, HashCollisions, SlotCollisions,
+               BucketCount, Uniformity, MaxLoad, Expected);
+    }
+    SetGlyphHashBackend(Original);
+
+    free(Buckets);
+    free(Slots);
+    free(Hashes);
+    free(Corpus.Starts);
+    free(Corpus.Bytes);
+    free(Data);
+}
+
+static uint32_t ConvertBenchUTF8ToUTF16(char unsigned *At, uint32_t Count, uint16_t *Dest, uint32_t MaxCount)
+{
+    // NOTE: What ParseWithKB used to do for every run, hit or miss
+#if _WIN32
+    uint32_t Result = (uint32_t)MultiByteToWideChar(CP_UTF8, 0, (char *)At, (int)Count, (wchar_t *)Dest, (int)MaxCount);
+#else
+    // NOTE: No MultiByteToWideChar here, so a plain decoder stands in for it
+    uint32_t Result = 0;
+    uint32_t Index = 0;
+    while((Index < Count) && ((Result + 2) <= MaxCount))
+    {
+        uint32_t Codepoint;
+        Index += DecodeTraceUTF8(At + Index, Count - Index, &Codepoint);
+        if(Codepoint >= 0x10000)
+        {
+            Codepoint -= 0x10000;
+            Dest[Result++] = (uint16_t)(0xD800 + (Codepoint >> 10));
+            Dest[Result++] = (uint16_t)(0xDC00 + (Codepoint & 0x3FF));
+        }
+        else
+        {
+            Dest[Result++] = (uint16_t)Codepoint;
+        }
+    }
+#endif
+    return Result;
+}
+
+static uint32_t RunUTF8Rows(glyph_table *Table, uint32_t RowCount, uint32_t RowLength, glyph_hash_input *Runs,
+                            int ConvertToUTF16, int Lookup)
+{
+    /* NOTE: The hit path of ParseWithKB and FlushGlyphRunBatch: with ConvertToUTF16, every run
+       is converted and its UTF-16 hashed, like before; without, the UTF-8 is hashed where it
+       is.  Lookup = 0 stops after hashing, to see how much of the time is the hash itself. */
+    uint32_t Sink = 0;
+
+    glyph_hash_input Inputs[256];
+    glyph_hash Hashes[256];
+    glyph_state States[256];
+    uint16_t UTF16[4096];
+    Assert(RowLength <= ArrayCount(Inputs));
+
+    for(uint32_t RowIndex = 0; RowIndex < RowCount; ++RowIndex)
+    {
+        glyph_hash_input *Row = Runs + (size_t)RowIndex*RowLength;
+        glyph_hash_input *RowInputs = Row;
+        if(ConvertToUTF16)
+        {
+            uint32_t UTF16Used = 0;
+            for(uint32_t RunIndex = 0; RunIndex < RowLength; ++RunIndex)
+            {
+                uint32_t UTF16Count = ConvertBenchUTF8ToUTF16(Row[RunIndex].At, (uint32_t)Row[RunIndex].Count,
+                                                              UTF16 + UTF16Used, ArrayCount(UTF16) - UTF16Used);
+                Inputs[RunIndex].At = (char unsigned *)(UTF16 + UTF16Used);
+                Inputs[RunIndex].Count = 2*UTF16Count;
+                UTF16Used += UTF16Count;
+            }
+            RowInputs = Inputs;
+        }
+
+        ComputeGlyphHashes(RowLength, RowInputs, DefaultSeed, Hashes);
+        if(Lookup)
+        {
+            FindGlyphEntriesByHashBatch(Table, RowLength, Hashes, States);
+            for(uint32_t RunIndex = 0; RunIndex < RowLength; ++RunIndex)
+            {
+                if(States[RunIndex].FilledState != BENCH_FILLED_STATE)
+                {
+                    UpdateGlyphCacheEntry(Table, States[RunIndex].ID, BENCH_FILLED_STATE, 1, 1);
+                }
+                Sink += States[RunIndex].GPUIndex.Value;
+            }
+        }
+        else
+        {
+            Sink += (uint32_t)_mm_cvtsi128_si32(Hashes[RowLength - 1].Value);
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchUTF8(uint32_t EntryCount)
+{
+    /* NOTE: Rows of complex-script clusters (the corpus's combining sequences, jamo,
+       conjuncts and emoji sequences, never single codepoints, since those mostly go through
+       the codepoint page table instead) drawn from a vocabulary that fits in the table, so
+       after the first pass every lookup is a hit.  The UTF-8 of each row is back to back, the
+       way it sits in the source buffer. */
+    uint32_t RowLength = 256;
+    uint32_t RowCount = 4096;
+    uint32_t VocabularyCount = EntryCount / 2;
+
+    hash_corpus Corpus = MakeHashCorpus();
+    uint32_t SequenceCount = Corpus.Count - Corpus.ScalarCount;
+    uint32_t *Vocabulary = (uint32_t *)malloc(VocabularyCount*sizeof(uint32_t));
+    for(uint32_t Index = 0; Index < VocabularyCount; ++Index)
+    {
+        Vocabulary[Index] = Corpus.ScalarCount + (uint32_t)(RandomU64() % SequenceCount);
+    }
+
+    uint32_t RunCount = RowLength*RowCount;
+    glyph_hash_input *Runs = (glyph_hash_input *)malloc(RunCount*sizeof(glyph_hash_input));
+    char unsigned *Bytes = (char unsigned *)malloc((size_t)RunCount*16);
+    size_t ByteCount = 0;
+    size_t UTF16ByteCount = 0;
+    uint32_t LongUTF8Count = 0;
+    uint32_t LongUTF16Count = 0;
+    for(uint32_t Index = 0; Index < RunCount; ++Index)
+    {
+        uint32_t Cluster = Vocabulary[RandomU64() % VocabularyCount];
+        uint32_t ClusterByteCount = Corpus.Starts[Cluster + 1] - Corpus.Starts[Cluster];
+        memcpy(Bytes + ByteCount, Corpus.Bytes + Corpus.Starts[Cluster], ClusterByteCount);
+        Runs[Index].At = Bytes + ByteCount;
+        Runs[Index].Count = ClusterByteCount;
+        ByteCount += ClusterByteCount;
+
+        uint16_t UTF16[16];
+        uint32_t ClusterUTF16Count = ConvertBenchUTF8ToUTF16(Runs[Index].At, ClusterByteCount, UTF16, ArrayCount(UTF16));
+        UTF16ByteCount += 2*ClusterUTF16Count;
+        LongUTF8Count += (ClusterByteCount > 16);
+        LongUTF16Count += ((2*ClusterUTF16Count) > 16);
+    }
+
+    printf("EntryCount=%u, %u rows of %u clusters from %u distinct ones, %s hash\n",
+           EntryCount, RowCount, RowLength, VocabularyCount, GetGlyphHashBackendName(GetGlyphHashBackend()));
+    printf("  %.2f UTF-8 bytes/cluster (%u over one block), %.2f UTF-16 bytes/cluster (%u over one block)\n",
+           (double)ByteCount / RunCount, LongUTF8Count, (double)UTF16ByteCount / RunCount, LongUTF16Count);
+
+    glyph_table_params Params = {0};
+    Params.EntryCount = EntryCount;
+    Params.HashCount = 4096;
+    Params.MaxHashCount = 65536; // NOTE: What the terminal uses
+    Params.ReservedTileCount = 96;
+    Params.CacheTileCountInX = 256;
+
+    for(int ConvertToUTF16 = 1; ConvertToUTF16 >= 0; --ConvertToUTF16)
+    {
+        glyph_table *Table = AllocateBenchTable(Params);
+        if(Table)
+        {
+            uint32_t Sink = RunUTF8Rows(Table, RowCount, RowLength, Runs, ConvertToUTF16, 1);
+            GetAndClearStats(Table);
+
+            // NOTE: Best of several tries, since a single try is easily disturbed
+            double HashTime = 1e9;
+            double TotalTime = 1e9;
+            for(uint32_t Try = 0; Try < 4; ++Try)
+            {
+                double Start = GetSeconds();
+                Sink += RunUTF8Rows(Table, RowCount, RowLength, Runs, ConvertToUTF16, 0);
+                double Middle = GetSeconds();
+                Sink += RunUTF8Rows(Table, RowCount, RowLength, Runs, ConvertToUTF16, 1);
+                double End = GetSeconds();
+
+                HashTime = ((Middle - Start) < HashTime) ? (Middle - Start) : HashTime;
+                TotalTime = ((End - Middle) < TotalTime) ? (End - Middle) : TotalTime;
+            }
+
+            glyph_table_stats Stats = GetAndClearStats(Table);
+            printf("  %-24s hit %5.1f%%  %5.2f ns/cluster to hash, %5.2f ns/cluster with lookup, %6.1f MB/s of UTF-8  (%x)\n",
+                   ConvertToUTF16 ? "UTF-16 (convert, hash)" : "UTF-8 (hash in place)",
+                   100.0*(double)Stats.HitCount / (double)(Stats.HitCount + Stats.MissCount),
+                   1e9*HashTime / RunCount, 1e9*TotalTime / RunCount,
+                   (double)ByteCount / (1e6*TotalTime), Sink & 0xf);
+
+            FreeBenchTable(Table);
+        }
+    }
+
+    free(Bytes);
+    free(Runs);
+    free(Vocabulary);
+    free(Corpus.Starts);
+    free(Corpus.Bytes);
+}
+
+static uint32_t RunFloodFrames(glyph_table *Table, uint32_t FrameCount, uint64_t *Hot, uint32_t HotCount,
+                               uint64_t *Flood, uint32_t FloodCount, char unsigned *Seedx16, size_t *HotHitCount)
+{
+    // NOTE: Every frame draws 64 glyphs the table has seen before and 64 flood strings
+    uint32_t Sink = 0;
+    uint32_t FloodIndex = 0;
+    for(uint32_t FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        BeginGlyphTableFrame(Table);
+        for(uint32_t Index = 0; Index < 64; ++Index)
+        {
+            uint64_t *Text = Hot + (RandomU64() % HotCount);
+            glyph_state State = FindGlyphEntryByHash(Table, ComputeGlyphHash(sizeof(*Text), (char unsigned *)Text, Seedx16));
+            if(State.FilledState != BENCH_FILLED_STATE)
+            {
+                UpdateGlyphCacheEntry(Table, State.ID, BENCH_FILLED_STATE, 1, 1);
+            }
+            else
+            {
+                ++*HotHitCount;
+            }
+            Sink += State.GPUIndex.Value;
+
+            Text = Flood + (FloodIndex++ % FloodCount);
+            State = FindGlyphEntryByHash(Table, ComputeGlyphHash(sizeof(*Text), (char unsigned *)Text, Seedx16));
+            if(State.FilledState != BENCH_FILLED_STATE)
+            {
+                UpdateGlyphCacheEntry(Table, State.ID, BENCH_FILLED_STATE, 1, 1);
+            }
+            Sink += State.GPUIndex.Value;
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchFlood(uint32_t EntryCount)
+{
+    /* NOTE: Output made to collide: 8-byte strings brute-forced so that their hashes with the
+       fixed DefaultSeed all have the same low 16 bits, which is the slot even after the hash
+       table has grown all the way to 65536.  They are drawn along with a hot set of ordinary
+       glyphs, against tables hashed with DefaultSeed and with their own seed
+       (GetGlyphTableSeed), with and without the MaxChainLength guard. */
+    uint32_t FloodCount = 2048;
+    uint32_t HotCount = 2048;
+    uint32_t FrameCount = 20000;
+    uint64_t *Flood = (uint64_t *)malloc(FloodCount*sizeof(uint64_t));
+    uint64_t *Hot = (uint64_t *)malloc(HotCount*sizeof(uint64_t));
+
+    double SearchStart = GetSeconds();
+    uint64_t Candidate = 0;
+    for(uint32_t Index = 0; Index < FloodCount; ++Index)
+    {
+        for(;;)
+        {
+            ++Candidate;
+            glyph_hash Hash = ComputeGlyphHash(sizeof(Candidate), (char unsigned *)&Candidate, DefaultSeed);
+            if((_mm_cvtsi128_si32(Hash.Value) & 0xffff) == 0)
+            {
+                break;
+            }
+        }
+        Flood[Index] = Candidate;
+    }
+    double SearchEnd = GetSeconds();
+
+    for(uint32_t Index = 0; Index < HotCount; ++Index)
+    {
+        Hot[Index] = RandomU64();
+    }
+
+    printf("EntryCount=%u, %u frames of 64 hot glyphs and 64 flood strings (%u flood strings found in %.1fs)\n",
+           EntryCount, FrameCount, FloodCount, SearchEnd - SearchStart);
+
+    for(int OwnSeed = 0; OwnSeed <= 1; ++OwnSeed)
+    {
+        for(int Guard = 0; Guard <= 1; ++Guard)
+        {
+            glyph_table_params Params = {0};
+            Params.EntryCount = EntryCount;
+            Params.HashCount = 4096;
+            Params.MaxHashCount = 65536;
+            Params.ReservedTileCount = 96;
+            Params.CacheTileCountInX = 256;
+            Params.MaxChainLength = Guard ? 0 : 0xffffffff;
+
+            glyph_table *Table = AllocateBenchTable(Params);
+            if(Table)
+            {
+                char unsigned *Seedx16 = OwnSeed ? GetGlyphTableSeed(Table) : DefaultSeed;
+
+                size_t HotHitCount = 0;
+                uint32_t Sink = RunFloodFrames(Table, FrameCount / 4, Hot, HotCount, Flood, FloodCount, Seedx16, &HotHitCount);
+                GetAndClearStats(Table);
+
+                HotHitCount = 0;
+                double Start = GetSeconds();
+                Sink += RunFloodFrames(Table, FrameCount, Hot, HotCount, Flood, FloodCount, Seedx16, &HotHitCount);
+                double End = GetSeconds();
+
+                glyph_table_stats Stats = GetAndClearStats(Table);
+                double LookupCount = (double)(Stats.HitCount + Stats.MissCount);
+                printf("%-12s %-9s  %8.1f ns/lookup  hot hit %5.1f%%  %6.1f%% of lookups probed 7+  %8u chain evictions  (%x)\n",
+                       OwnSeed ? "table seed" : "DefaultSeed", Guard ? "guard" : "no guard",
+                       1e9*(End - Start) / LookupCount, 100.0*(double)HotHitCount / (64.0*FrameCount),
+                       100.0*(double)Stats.ProbeLengthHistogram[GLYPH_TABLE_PROBE_HISTOGRAM_COUNT - 1] / LookupCount,
+                       (uint32_t)Stats.ChainEvictionCount, Sink & 0xf);
+
+                FreeBenchTable(Table);
+            }
+        }
+    }
+
+    free(Hot);
+    free(Flood);
+}
+
+static void BenchGrow(uint32_t EntryCount)
+{
+    // NOTE: Starts from an empty table and keeps filling it with new glyphs, like a session
+    // that gets into more and more of Unicode.
+    size_t Count = 4*1024*1024;
+    glyph_hash *Hashes = MakeHitRateStream(Count, EntryCount, 0.9);
+
+    uint32_t GrownHashCount = RoundUpToPowerOfTwo(EntryCount);
+    uint32_t HashCounts[] = {4096, 4096, GrownHashCount};
+    uint32_t MaxHashCounts[] = {0, GrownHashCount, 0};
+
+    printf("EntryCount=%u, %u lookups per run\n", EntryCount, (uint32_t)Count);
+    for(uint32_t RunIndex = 0; RunIndex < ArrayCount(HashCounts); ++RunIndex)
+    {
+        glyph_table_params Params = {0};
+        Params.HashCount = HashCounts[RunIndex];
+        Params.MaxHashCount = MaxHashCounts[RunIndex];
+        Params.EntryCount = EntryCount;
+        Params.ReservedTileCount = 96;
+        Params.CacheTileCountInX = 256;
+
+        glyph_table *Table = AllocateBenchTable(Params);
+        if(Table)
+        {
+            double Start = GetSeconds();
+            uint32_t Sink = RunLookups(Table, Count / 2, Hashes);
+            double Middle = GetSeconds();
+            Sink += RunLookups(Table, Count / 2, Hashes + Count / 2);
+            double End = GetSeconds();
+
+            glyph_table_stats Stats = GetAndClearStats(Table);
+            printf("HashCount=%6u MaxHashCount=%6u  grows %2u  first half %6.1f ns/lookup  second half %6.1f ns/lookup  (%x)\n",
+                   Params.HashCount, Params.MaxHashCount, (uint32_t)Stats.GrowCount,
+                   1e9*(Middle - Start) / (double)(Count / 2), 1e9*(End - Middle) / (double)(Count / 2),
+                   Sink & 0xf);
+
+            FreeBenchTable(Table);
+        }
+    }
+
+    free(Hashes);
+}
+
+static void BenchLayouts(uint32_t EntryCount)
+{
+    double HitRates[] = {0.5, 0.9, 0.99};
+    size_t Count = 4*1024*1024;
+
+    glyph_table_params Params = {0};
+    Params.EntryCount = EntryCount;
+    Params.ReservedTileCount = 96;
+    Params.CacheTileCountInX = 256;
+
+    printf("EntryCount=%u, %u lookups per run\n", EntryCount, (uint32_t)(Count / 2));
+    for(uint32_t RateIndex = 0; RateIndex < ArrayCount(HitRates); ++RateIndex)
+    {
+        glyph_hash *Hashes = MakeHitRateStream(Count, EntryCount, HitRates[RateIndex]);
+
+        // NOTE: 4096 is what refterm itself uses today
+        Params.Layout = GlyphTableLayout_Chained;
+        Params.HashCount = 4096;
+        BenchLayout(Params, "chained", Count, Hashes, HitRates[RateIndex]);
+
+        Params.HashCount = RoundUpToPowerOfTwo(2*EntryCount);
+        BenchLayout(Params, "chained", Count, Hashes, HitRates[RateIndex]);
+
+        Params.Layout = GlyphTableLayout_OpenAddressed;
+        BenchLayout(Params, "open-addressed", Count, Hashes, HitRates[RateIndex]);
+
+        free(Hashes);
+    }
+}
+
+int main(int ArgCount, char **Args)
+{
+    uint32_t EntryCount = 256*120 - 96;
+
+    char *Mode = (ArgCount > 1) ? Args[1] : "-layout";
+    if(strcmp(Mode, "-trace") == 0)
+    {
+        for(int ArgIndex = 2; ArgIndex < ArgCount; ++ArgIndex)
+        {
+            BenchTrace(Args[ArgIndex]);
+        }
+
+        return 0;
+    }
+
+    if(ArgCount > 2)
+    {
+        EntryCount = (uint32_t)atoi(Args[2]);
+    }
+
+    if(strcmp(Mode, "-layout") == 0)
+    {
+        BenchLayouts(EntryCount);
+    }
+    else if(strcmp(Mode, "-threads") == 0)
+    {
+        BenchThreads(EntryCount);
+    }
+    else if(strcmp(Mode, "-batch") == 0)
+    {
+        BenchBatch(EntryCount);
+    }
+    else if(strcmp(Mode, "-spans") == 0)
+    {
+        BenchSpans(EntryCount);
+    }
+    else if(strcmp(Mode, "-grow") == 0)
+    {
+        BenchGrow(EntryCount);
+    }
+    else if(strcmp(Mode, "-front") == 0)
+    {
+        BenchFront(EntryCount);
+    }
+    else if(strcmp(Mode, "-codepoints") == 0)
+    {
+        BenchCodepoints(EntryCount);
+    }
+    else if(strcmp(Mode, "-hash") == 0)
+    {
+        BenchHash();
+    }
+    else if(strcmp(Mode, "-utf8") == 0)
+    {
+        BenchUTF8(EntryCount);
+    }
+    else if(strcmp(Mode, "-flood") == 0)
+    {
+        BenchFlood(EntryCount);
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [-layout|-threads|-batch|-spans|-grow|-front|-codepoints|-hash|-utf8|-flood] [EntryCount]\n", Args[0]);
+        fprintf(stderr, "       %s -trace File [File...]\n", Args[0]);
+        return 1;
+    }
+
+    return 0;
+}
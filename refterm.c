@@ -10,11 +10,13 @@
 #include <windows.h>
 #include <shlwapi.h>
 #include <d3d11_1.h>
+#include <d3dcompiler.h>
 #include <dxgi1_3.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <intrin.h>
 #include <strsafe.h>
+#include <bcrypt.h>
 
 #define KB_TEXT_SHAPE_STATIC
 #define KB_TEXT_SHAPE_IMPLEMENTATION
@@ -27,18 +29,23 @@
 
 #include "refterm_glyph_cache.h"
 #include "refterm_glyph_cache.c"
+#include "refterm_glyph_hash.h"
+#include "refterm_glyph_hash.c"
 
-#include "refterm_vs.h"
-#include "refterm_ps.h"
-#include "refterm_cs.h"
 #include "refterm_example_source_buffer.h"
+#include "refterm_example_cold_scrollback.h"
+#include "refterm_example_line_index.h"
 #include "refterm_example_dwrite.h"
 #include "refterm_example_d3d11.h"
 #include "refterm_example_glyph_generator.h"
+#include "refterm_example_glyph_snapshot.h"
 #include "refterm_example_terminal.h"
 #include "refterm_example_source_buffer.c"
+#include "refterm_example_cold_scrollback.c"
+#include "refterm_example_line_index.c"
 #include "refterm_example_glyph_generator.c"
 #include "refterm_example_d3d11.c"
+#include "refterm_example_glyph_snapshot.c"
 #include "refterm_example_terminal.c"
 
 #pragma comment (lib, "kernel32")
@@ -47,6 +54,8 @@
 #pragma comment (lib, "dwrite")
 #pragma comment (lib, "d2d1")
 #pragma comment (lib, "mincore")
+#pragma comment (lib, "bcrypt")
+#pragma comment (lib, "advapi32")
 
 DWORD RenderThreadID = 0;
 
@@ -20,7 +20,7 @@ cbuffer ConstBuffer : register(b0)
 };
 
 StructuredBuffer<TerminalCell> Cells : register(t0);
-Texture2D<float4> GlyphTexture : register(t1);
+Texture2DArray<float4> GlyphTexture : register(t1);
 
 float3 UnpackColor(uint Packed)
 {
@@ -33,11 +33,16 @@ float3 UnpackColor(uint Packed)
 
 uint2 UnpackGlyphXY(uint GlyphIndex)
 {
-    int x = (GlyphIndex & 0xffff);
-    int y = (GlyphIndex >> 16);
+    int x = (GlyphIndex & 0xfff);
+    int y = ((GlyphIndex >> 12) & 0xfff);
     return uint2(x, y);
 }
 
+uint UnpackGlyphPage(uint GlyphIndex)
+{
+    return (GlyphIndex >> 24);
+}
+
 float4 ComputeOutputColor(uint2 ScreenPos)
 {
     uint2 CellIndex = (ScreenPos - TopLeftMargin) / CellSize;
@@ -53,7 +58,13 @@ float4 ComputeOutputColor(uint2 ScreenPos)
         uint2 GlyphPos = UnpackGlyphXY(Cell.GlyphIndex)*CellSize;
 
         uint2 PixelPos = GlyphPos + CellPos;
-        float4 GlyphTexel = GlyphTexture[PixelPos];
+        // NOTE: Glyph index 0 is always empty.  It isn't read from the texture, because with a
+        // glyph table per font, tile 0 of page 0 is sized for whichever font owns page 0.
+        float4 GlyphTexel = 0;
+        if(Cell.GlyphIndex)
+        {
+            GlyphTexel = GlyphTexture[uint3(PixelPos, UnpackGlyphPage(Cell.GlyphIndex))];
+        }
 
         float3 Background = UnpackColor(Cell.Background);
         float3 Foreground = UnpackColor(Cell.Foreground);
@@ -79,7 +90,7 @@ float4 ComputeOutputColor(uint2 ScreenPos)
     }
 
     // NOTE(casey): Uncomment this to view the cache texture
-    // Result = GlyphTexture[ScreenPos].rgb;
+    // Result = GlyphTexture[uint3(ScreenPos, 0)].rgb;
 
     return float4(Result, 1);
 }
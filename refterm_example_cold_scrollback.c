@@ -0,0 +1,499 @@
+#define COLD_MIN_MATCH 4
+#define COLD_MATCH_TABLE_BITS 12
+#define COLD_LAST_LITERAL_COUNT 5 // NOTE: Matches stop this far from the end, so a block always ends in literals
+#define COLD_MATCH_SEARCH_END 12
+
+static uint32_t FindLowestSetBit64(uint64_t Value)
+{
+    // NOTE: Value can't be 0.  _tzcnt_u64 would need BMI enabled (-mbmi) to build with gcc or clang.
+#if _MSC_VER
+    unsigned long Result;
+    _BitScanForward64(&Result, Value);
+#else
+    uint32_t Result = __builtin_ctzll(Value);
+#endif
+    return (uint32_t)Result;
+}
+
+static void *AllocateColdMemory(size_t Size)
+{
+#if _WIN32
+    void *Result = VirtualAlloc(0, Size, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+#else
+    void *Result = mmap(0, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+#endif
+    return Result;
+}
+
+static void FreeColdMemory(void *Memory, size_t Size)
+{
+#if _WIN32
+    VirtualFree(Memory, 0, MEM_RELEASE);
+#else
+    munmap(Memory, Size);
+#endif
+}
+
+static size_t GetColdMemorySize(uint32_t MaxBlockCount)
+{
+    size_t Result = (MaxBlockCount*sizeof(cold_block) +
+                     (COLD_CACHE_COUNT + 1)*COLD_BLOCK_SIZE +
+                     (1 << COLD_MATCH_TABLE_BITS)*sizeof(uint32_t));
+    return Result;
+}
+
+static cold_scrollback AllocateColdScrollback(size_t StoreSize, uint32_t MaxBlockCount)
+{
+    /* NOTE: If anything can't be allocated, Store.Data is 0 and the cold scrollback just
+       never holds anything, so the terminal works the same as it did without one. */
+    cold_scrollback Result = {0};
+
+    Assert(IsPowerOfTwo(MaxBlockCount));
+    Assert(StoreSize >= 2*COLD_BLOCK_BOUND);
+
+    source_buffer Store = AllocateQuietSourceBuffer(StoreSize, 0);
+    char *Memory = (char *)AllocateColdMemory(GetColdMemorySize(MaxBlockCount));
+    if(Store.Data && Memory)
+    {
+        Result.Store = Store;
+        Result.MaxBlockCount = MaxBlockCount;
+
+        Result.Blocks = (cold_block *)Memory;
+        Memory += MaxBlockCount*sizeof(cold_block);
+
+        for(uint32_t SlotIndex = 0; SlotIndex < COLD_CACHE_COUNT; ++SlotIndex)
+        {
+            Result.Cache[SlotIndex].BlockP = COLD_NO_BLOCK;
+            Result.Cache[SlotIndex].Data = Memory;
+            Memory += COLD_BLOCK_SIZE;
+        }
+
+        Result.Straddle = Memory;
+        Memory += COLD_BLOCK_SIZE;
+
+        Result.MatchTable = (uint32_t *)Memory;
+    }
+    else
+    {
+        FreeSourceBuffer(&Store);
+        if(Memory)
+        {
+            FreeColdMemory(Memory, GetColdMemorySize(MaxBlockCount));
+        }
+    }
+
+    return Result;
+}
+
+static void FreeColdScrollback(cold_scrollback *Cold)
+{
+    if(Cold->Store.Data)
+    {
+        FreeSourceBuffer(&Cold->Store);
+        FreeColdMemory(Cold->Blocks, GetColdMemorySize(Cold->MaxBlockCount));
+    }
+
+    cold_scrollback Zero = {0};
+    *Cold = Zero;
+}
+
+static uint32_t ReadColdU32(char unsigned *At)
+{
+    uint32_t Result;
+    memcpy(&Result, At, sizeof(Result));
+    return Result;
+}
+
+static uint32_t HashColdSequence(uint32_t Sequence)
+{
+    uint32_t Result = (Sequence*2654435761u) >> (32 - COLD_MATCH_TABLE_BITS);
+    return Result;
+}
+
+static char unsigned *WriteColdLength(char unsigned *Out, size_t Length)
+{
+    // NOTE: Whatever didn't fit in the token's nibble, in bytes of 255 ending with one under 255
+    while(Length >= 255)
+    {
+        *Out++ = 255;
+        Length -= 255;
+    }
+    *Out++ = (char unsigned)Length;
+
+    return Out;
+}
+
+static char unsigned *WriteColdSequence(char unsigned *Out, char unsigned *Literals, size_t LiteralCount,
+                                        size_t Offset, size_t MatchLength)
+{
+    // NOTE: MatchLength 0 is the last sequence of a block, which is only literals and has no offset
+    size_t MatchCode = MatchLength ? (MatchLength - COLD_MIN_MATCH) : 0;
+
+    char unsigned *Token = Out++;
+    *Token = (char unsigned)(((LiteralCount < 15) ? LiteralCount : 15) << 4);
+    if(LiteralCount >= 15)
+    {
+        Out = WriteColdLength(Out, LiteralCount - 15);
+    }
+
+    memcpy(Out, Literals, LiteralCount);
+    Out += LiteralCount;
+
+    if(MatchLength)
+    {
+        *Out++ = (char unsigned)(Offset & 0xff);
+        *Out++ = (char unsigned)(Offset >> 8);
+
+        *Token |= (char unsigned)((MatchCode < 15) ? MatchCode : 15);
+        if(MatchCode >= 15)
+        {
+            Out = WriteColdLength(Out, MatchCode - 15);
+        }
+    }
+
+    return Out;
+}
+
+static size_t CompressColdBlock(uint32_t *MatchTable, char unsigned *In, size_t Count, char unsigned *Out)
+{
+    /* NOTE: Greedy LZ77 with one candidate per hash of the next 4 bytes, like LZ4's fast
+       mode.  The search steps further ahead the longer it goes without a match, so
+       incompressible output goes through quickly instead of being searched at every byte.
+       Out needs room for COLD_BLOCK_BOUND. */
+    char unsigned *OutStart = Out;
+    char unsigned *Literals = In;
+    char unsigned *At = In;
+    char unsigned *End = In + Count;
+
+    // NOTE: Stale entries are fine, since every candidate is checked, but they must point inside this block
+    memset(MatchTable, 0, (1 << COLD_MATCH_TABLE_BITS)*sizeof(uint32_t));
+
+    if(Count > COLD_MATCH_SEARCH_END)
+    {
+        char unsigned *MatchLimit = End - COLD_LAST_LITERAL_COUNT;
+        char unsigned *SearchEnd = End - COLD_MATCH_SEARCH_END;
+        uint32_t MissCount = 0;
+        while(At < SearchEnd)
+        {
+            uint32_t Sequence = ReadColdU32(At);
+            uint32_t Hash = HashColdSequence(Sequence);
+            char unsigned *Candidate = In + MatchTable[Hash];
+            MatchTable[Hash] = (uint32_t)(At - In);
+
+            if((Candidate < At) && ((At - Candidate) <= 0xffff) && (ReadColdU32(Candidate) == Sequence))
+            {
+                // NOTE: Compares 8 bytes at a time, and the lowest differing bit says how many of those 8 matched
+                size_t Length = COLD_MIN_MATCH;
+                size_t MaxLength = MatchLimit - At;
+                while((Length + 8) <= MaxLength)
+                {
+                    uint64_t A, B;
+                    memcpy(&A, At + Length, 8);
+                    memcpy(&B, Candidate + Length, 8);
+                    if(A != B)
+                    {
+                        Length += FindLowestSetBit64(A ^ B) >> 3;
+                        MaxLength = Length;
+                        break;
+                    }
+
+                    Length += 8;
+                }
+
+                while((Length < MaxLength) && (At[Length] == Candidate[Length]))
+                {
+                    ++Length;
+                }
+
+                char unsigned *MatchEnd = At + Length;
+                Out = WriteColdSequence(Out, Literals, At - Literals, At - Candidate, MatchEnd - At);
+
+                // NOTE: The match skipped over these, so without this a repeat of the bytes just before MatchEnd couldn't be found
+                if(MatchEnd - 2 < SearchEnd)
+                {
+                    MatchTable[HashColdSequence(ReadColdU32(MatchEnd - 2))] = (uint32_t)(MatchEnd - 2 - In);
+                }
+
+                At = MatchEnd;
+                Literals = At;
+                MissCount = 0;
+            }
+            else
+            {
+                At += 1 + (MissCount++ >> 6);
+            }
+        }
+    }
+
+    Out = WriteColdSequence(Out, Literals, End - Literals, 0, 0);
+
+    size_t Result = Out - OutStart;
+    Assert(Result <= COLD_BLOCK_BOUND);
+    return Result;
+}
+
+static size_t DecompressColdBlock(char unsigned *In, size_t Count, char unsigned *Out, size_t OutCount)
+{
+    // NOTE: Returns how many bytes were decoded, or 0 if the input would read or write out of bounds
+    char unsigned *InEnd = In + Count;
+    char unsigned *OutStart = Out;
+    char unsigned *OutEnd = Out + OutCount;
+
+    while(In < InEnd)
+    {
+        uint32_t Token = *In++;
+
+        size_t LiteralCount = Token >> 4;
+        if(LiteralCount == 15)
+        {
+            uint32_t Extra;
+            do
+            {
+                if(In >= InEnd) return 0;
+                Extra = *In++;
+                LiteralCount += Extra;
+            } while(Extra == 255);
+        }
+
+        if((LiteralCount > (size_t)(InEnd - In)) || (LiteralCount > (size_t)(OutEnd - Out))) return 0;
+        memcpy(Out, In, LiteralCount);
+        In += LiteralCount;
+        Out += LiteralCount;
+
+        if(In == InEnd)
+        {
+            break;
+        }
+
+        if((InEnd - In) < 2) return 0;
+        size_t Offset = In[0] | ((size_t)In[1] << 8);
+        In += 2;
+        if((Offset == 0) || (Offset > (size_t)(Out - OutStart))) return 0;
+
+        size_t MatchLength = Token & 15;
+        if(MatchLength == 15)
+        {
+            uint32_t Extra;
+            do
+            {
+                if(In >= InEnd) return 0;
+                Extra = *In++;
+                MatchLength += Extra;
+            } while(Extra == 255);
+        }
+        MatchLength += COLD_MIN_MATCH;
+
+        if(MatchLength > (size_t)(OutEnd - Out)) return 0;
+        char unsigned *From = Out - Offset;
+        if(Offset >= MatchLength)
+        {
+            memcpy(Out, From, MatchLength);
+            Out += MatchLength;
+        }
+        else
+        {
+            // NOTE: Overlapping, so it repeats the last Offset bytes, which has to go a byte at a time
+            while(MatchLength--)
+            {
+                *Out++ = *From++;
+            }
+        }
+    }
+
+    size_t Result = Out - OutStart;
+    return Result;
+}
+
+static cold_block *GetColdBlock(cold_scrollback *Cold, size_t BlockP)
+{
+    cold_block *Result = Cold->Blocks + ((BlockP / COLD_BLOCK_SIZE) & (Cold->MaxBlockCount - 1));
+    return Result;
+}
+
+static size_t GetMaxColdWriteCount(source_buffer *Source)
+{
+    Assert(Source->DataSize > COLD_BLOCK_SIZE);
+    size_t Result = Source->DataSize - COLD_BLOCK_SIZE;
+    return Result;
+}
+
+static void ArchiveColdScrollback(cold_scrollback *Cold, source_buffer *Source, size_t WriteCount)
+{
+    if(Cold->Store.Data)
+    {
+        Assert(WriteCount <= GetMaxColdWriteCount(Source));
+
+        // NOTE: The oldest byte ReadSourceAt will still have once WriteCount more bytes are committed
+        size_t NewEndP = Source->AbsoluteFilledSize + WriteCount;
+        size_t KeepP = (NewEndP >= Source->DataSize) ? (NewEndP - (Source->DataSize - 1)) : 0;
+
+        while(Cold->OnePastLastP < KeepP)
+        {
+            size_t BlockP = Cold->OnePastLastP;
+            source_buffer_range Raw = ReadSourceAt(Source, BlockP, COLD_BLOCK_SIZE);
+            Assert(Raw.Count == COLD_BLOCK_SIZE);
+
+            // NOTE: Compressing writes up to COLD_BLOCK_BOUND bytes into the Store, whatever it ends up
+            // committing, so any block whose compressed bytes that could touch has to go first.  So does
+            // the block whose directory entry this one is about to take.
+            source_buffer *Store = &Cold->Store;
+            while((Cold->FirstP < Cold->OnePastLastP) &&
+                  (((GetColdBlock(Cold, Cold->FirstP)->StoreP + Store->DataSize) < (Store->AbsoluteFilledSize + COLD_BLOCK_BOUND)) ||
+                   (((BlockP - Cold->FirstP) / COLD_BLOCK_SIZE) >= Cold->MaxBlockCount)))
+            {
+                Cold->FirstP += COLD_BLOCK_SIZE;
+            }
+
+            source_buffer_range Dest = GetNextWritableRange(Store, COLD_BLOCK_BOUND);
+            size_t StoreCount = CompressColdBlock(Cold->MatchTable, (char unsigned *)Raw.Data, Raw.Count, (char unsigned *)Dest.Data);
+            if(StoreCount >= COLD_BLOCK_SIZE)
+            {
+                memcpy(Dest.Data, Raw.Data, COLD_BLOCK_SIZE);
+                StoreCount = COLD_BLOCK_SIZE;
+            }
+            CommitWrite(Store, StoreCount);
+
+            cold_block *Block = GetColdBlock(Cold, BlockP);
+            Block->StoreP = Dest.AbsoluteP;
+            Block->StoreCount = (uint32_t)StoreCount;
+
+            Cold->OnePastLastP = BlockP + COLD_BLOCK_SIZE;
+            ++Cold->ArchivedCount;
+            Cold->CompressedSize += StoreCount;
+        }
+    }
+}
+
+static void ResetColdScrollback(cold_scrollback *Cold, source_buffer *Source)
+{
+    /* NOTE: For when Source is swapped for another buffer (a scrollback file), whose positions
+       have nothing to do with what was archived.  Archiving picks up at the first whole block
+       Source still has, and whatever of Source is older than that is never archived. */
+    size_t EndP = Source->AbsoluteFilledSize;
+    size_t OldestP = (EndP >= Source->DataSize) ? (EndP - (Source->DataSize - 1)) : 0;
+    size_t StartP = (OldestP + COLD_BLOCK_SIZE - 1) & ~(size_t)(COLD_BLOCK_SIZE - 1);
+
+    Cold->FirstP = StartP;
+    Cold->OnePastLastP = StartP;
+    for(uint32_t SlotIndex = 0; SlotIndex < COLD_CACHE_COUNT; ++SlotIndex)
+    {
+        Cold->Cache[SlotIndex].BlockP = COLD_NO_BLOCK;
+    }
+}
+
+static char *GetColdBlockData(cold_scrollback *Cold, size_t BlockP)
+{
+    char *Result = 0;
+
+    ++Cold->CacheClock;
+
+    cold_cache_slot *Victim = Cold->Cache;
+    for(uint32_t SlotIndex = 0; SlotIndex < COLD_CACHE_COUNT; ++SlotIndex)
+    {
+        cold_cache_slot *Slot = Cold->Cache + SlotIndex;
+        if(Slot->BlockP == BlockP)
+        {
+            Victim = Slot;
+            Result = Slot->Data;
+            break;
+        }
+
+        if(Slot->LastUse < Victim->LastUse)
+        {
+            Victim = Slot;
+        }
+    }
+
+    if(Result)
+    {
+        ++Cold->CacheHitCount;
+    }
+    else
+    {
+        cold_block *Block = GetColdBlock(Cold, BlockP);
+        source_buffer_range Packed = ReadSourceAt(&Cold->Store, Block->StoreP, Block->StoreCount);
+
+        size_t DecodedCount = 0;
+        if(Packed.Count == Block->StoreCount)
+        {
+            if(Block->StoreCount == COLD_BLOCK_SIZE)
+            {
+                memcpy(Victim->Data, Packed.Data, COLD_BLOCK_SIZE);
+                DecodedCount = COLD_BLOCK_SIZE;
+            }
+            else
+            {
+                DecodedCount = DecompressColdBlock((char unsigned *)Packed.Data, Packed.Count,
+                                                   (char unsigned *)Victim->Data, COLD_BLOCK_SIZE);
+            }
+        }
+
+        // NOTE: A block that doesn't decode reads as empty rather than as garbage
+        Victim->BlockP = COLD_NO_BLOCK;
+        if(DecodedCount == COLD_BLOCK_SIZE)
+        {
+            Victim->BlockP = BlockP;
+            Result = Victim->Data;
+        }
+
+        ++Cold->DecompressCount;
+    }
+
+    Victim->LastUse = Cold->CacheClock;
+
+    return Result;
+}
+
+static source_buffer_range ReadColdScrollbackAt(cold_scrollback *Cold, source_buffer *Source, size_t AbsoluteP, size_t Count)
+{
+    source_buffer_range Result = {0};
+
+    if(Cold->Store.Data && (AbsoluteP >= Cold->FirstP) && (AbsoluteP < Cold->OnePastLastP))
+    {
+        size_t BlockP = AbsoluteP & ~(size_t)(COLD_BLOCK_SIZE - 1);
+        size_t Offset = AbsoluteP - BlockP;
+        char *Data = GetColdBlockData(Cold, BlockP);
+        if(Data)
+        {
+            Result.AbsoluteP = AbsoluteP;
+            Result.Data = Data + Offset;
+            Result.Count = COLD_BLOCK_SIZE - Offset;
+
+            if(Result.Count < Count)
+            {
+                // NOTE: The rest is in the next block, which is either archived too or still in Source.
+                // Stitching the two together has to fit in the scratch block.
+                size_t RestCount = Count - Result.Count;
+                if(RestCount > Offset)
+                {
+                    RestCount = Offset;
+                }
+
+                memcpy(Cold->Straddle, Result.Data, Result.Count);
+
+                size_t NextP = BlockP + COLD_BLOCK_SIZE;
+                source_buffer_range Next = (NextP < Cold->OnePastLastP) ?
+                    ReadColdScrollbackAt(Cold, Source, NextP, RestCount) :
+                    ReadSourceAt(Source, NextP, RestCount);
+                if(Next.Count)
+                {
+                    memcpy(Cold->Straddle + Result.Count, Next.Data, Next.Count);
+                }
+
+                Result.Data = Cold->Straddle;
+                Result.Count += Next.Count;
+            }
+
+            if(Result.Count > Count)
+            {
+                Result.Count = Count;
+            }
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,79 @@
+/* NOTE:
+
+   The cold scrollback keeps what falls off the back of the scrollback source_buffer, so
+   scrolling up isn't limited to the last PipeSize bytes.
+
+   Output is archived in COLD_BLOCK_SIZE blocks of absolute source positions.  A block is
+   only compressed when the next write to the scrollback would overwrite its first byte, so
+   as long as output fits in the ring, nothing is compressed at all.  Blocks are compressed
+   with a small LZ77 codec (LZ4-style sequences of literals and matches, with 16-bit offsets,
+   which is all a 64KB block needs) and appended to the Store, which is itself a
+   double-mapped source_buffer - so the compressed bytes are a ring too, and the oldest
+   blocks fall off the back of it the same way.
+
+   Nothing in example_line changes: lines already hold absolute source positions, and
+   ReadColdScrollbackAt takes the same positions ReadSourceAt does.  A read decompresses the
+   block it lands in into a small LRU cache of decompressed blocks, so laying out a screen
+   decompresses each block once, not once per line.  A read that crosses into the next
+   block is stitched together in a scratch block, so it is clamped to COLD_BLOCK_SIZE.
+
+   The range a read returns points into the cache (or the scratch), so it is only good
+   until the next read.
+*/
+
+#define COLD_BLOCK_SIZE (64*1024)
+#define COLD_CACHE_COUNT 4
+
+// NOTE: Worst case size of a compressed block, for incompressible input (which is then stored raw)
+#define COLD_BLOCK_BOUND (COLD_BLOCK_SIZE + COLD_BLOCK_SIZE/255 + 16)
+
+typedef struct
+{
+    size_t StoreP; // NOTE: Absolute position of the compressed bytes in the Store
+    uint32_t StoreCount; // NOTE: COLD_BLOCK_SIZE means the block was stored raw
+} cold_block;
+
+typedef struct
+{
+    size_t BlockP; // NOTE: Absolute source position of the block in Data, or COLD_NO_BLOCK
+    uint32_t LastUse;
+    char *Data;
+} cold_cache_slot;
+
+#define COLD_NO_BLOCK ((size_t)-1)
+
+typedef struct
+{
+    source_buffer Store;
+
+    // NOTE: Indexed by block number (BlockP / COLD_BLOCK_SIZE) modulo MaxBlockCount, a power of two
+    uint32_t MaxBlockCount;
+    cold_block *Blocks;
+
+    // NOTE: Source positions in [FirstP, OnePastLastP) can be read back; both are multiples of COLD_BLOCK_SIZE
+    size_t FirstP;
+    size_t OnePastLastP;
+
+    uint32_t CacheClock;
+    cold_cache_slot Cache[COLD_CACHE_COUNT];
+    char *Straddle;
+    uint32_t *MatchTable;
+
+    // NOTE: Running totals, for "status"
+    size_t ArchivedCount; // NOTE: Blocks ever archived
+    size_t CompressedSize; // NOTE: Bytes they compressed to
+    size_t DecompressCount;
+    size_t CacheHitCount;
+} cold_scrollback;
+
+static cold_scrollback AllocateColdScrollback(size_t StoreSize, uint32_t MaxBlockCount);
+static void FreeColdScrollback(cold_scrollback *Cold);
+
+/* NOTE: Must be called before each write of up to WriteCount bytes to Source, and
+   WriteCount must be at most GetMaxColdWriteCount(Source), so that every block the write
+   overwrites has been completely written (and can be archived) beforehand. */
+static size_t GetMaxColdWriteCount(source_buffer *Source);
+static void ArchiveColdScrollback(cold_scrollback *Cold, source_buffer *Source, size_t WriteCount);
+static void ResetColdScrollback(cold_scrollback *Cold, source_buffer *Source);
+
+static source_buffer_range ReadColdScrollbackAt(cold_scrollback *Cold, source_buffer *Source, size_t AbsoluteP, size_t Count);
@@ -5,6 +5,7 @@
 
 #pragma comment (lib, "d3d11.lib")
 #pragma comment (lib, "dxguid.lib")
+#pragma comment (lib, "d3dcompiler.lib")
 
 static int D3D11RendererIsValid(d3d11_renderer *Renderer)
 {
@@ -183,29 +184,185 @@ static void ReleaseD3DGlyphTransfer(d3d11_renderer *Renderer)
     }
 }
 
-static void SetD3D11GlyphCacheDim(d3d11_renderer *Renderer, uint32_t Width, uint32_t Height)
+static int CreateD3D11GlyphPages(d3d11_renderer *Renderer, uint32_t PageCount,
+                                 ID3D11Texture2D **TextureResult, ID3D11ShaderResourceView **ViewResult)
+{
+    int Result = 0;
+
+    D3D11_TEXTURE2D_DESC TextureDesc =
+    {
+        .Width = Renderer->GlyphCacheWidth,
+        .Height = Renderer->GlyphCacheHeight,
+        .MipLevels = 1,
+        .ArraySize = PageCount,
+        .Format = DXGI_FORMAT_B8G8R8A8_UNORM,
+        .SampleDesc = { 1, 0 },
+        .Usage = D3D11_USAGE_DEFAULT,
+        .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+    };
+
+    // NOTE: The view has to be spelled out, because a one-page array would otherwise get a plain 2D view
+    D3D11_SHADER_RESOURCE_VIEW_DESC ViewDesc =
+    {
+        .Format = TextureDesc.Format,
+        .ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY,
+        .Texture2DArray.MostDetailedMip = 0,
+        .Texture2DArray.MipLevels = 1,
+        .Texture2DArray.FirstArraySlice = 0,
+        .Texture2DArray.ArraySize = PageCount,
+    };
+
+    ID3D11Texture2D *Texture = 0;
+    ID3D11ShaderResourceView *View = 0;
+    if(SUCCEEDED(ID3D11Device_CreateTexture2D(Renderer->Device, &TextureDesc, 0, &Texture)))
+    {
+        if(SUCCEEDED(ID3D11Device_CreateShaderResourceView(Renderer->Device, (ID3D11Resource *)Texture, &ViewDesc, &View)))
+        {
+            *TextureResult = Texture;
+            *ViewResult = View;
+            Result = 1;
+        }
+        else
+        {
+            ID3D11Texture2D_Release(Texture);
+        }
+    }
+
+    return Result;
+}
+
+static void SetD3D11GlyphCacheDim(d3d11_renderer *Renderer, uint32_t Width, uint32_t Height, uint32_t MaxPageCount)
 {
     ReleaseD3DGlyphCache(Renderer);
 
-    if(Renderer->Device)
+    // NOTE: Only the first page is created up front, the rest come from EnsureD3D11GlyphPageCount
+    Renderer->GlyphCacheWidth = Width;
+    Renderer->GlyphCacheHeight = Height;
+    Renderer->GlyphPageCount = 0;
+    Renderer->MaxGlyphPageCount = MaxPageCount;
+
+    if(Renderer->Device && MaxPageCount)
+    {
+        if(CreateD3D11GlyphPages(Renderer, 1, &Renderer->GlyphTexture, &Renderer->GlyphTextureView))
+        {
+            Renderer->GlyphPageCount = 1;
+        }
+    }
+}
+
+static int EnsureD3D11GlyphPageCount(d3d11_renderer *Renderer, uint32_t PageCount)
+{
+    /* NOTE: A texture array can't be resized, so adding pages means making a bigger one and
+       copying the old pages over on the GPU.  It grows by doubling (up to the max), so this
+       happens a handful of times at most, and only when the glyph table first fills a page. */
+    int Result = (PageCount <= Renderer->GlyphPageCount);
+
+    if(!Result && Renderer->Device && Renderer->GlyphTexture && (PageCount <= Renderer->MaxGlyphPageCount))
     {
+        uint32_t NewPageCount = 2*Renderer->GlyphPageCount;
+        if(NewPageCount < PageCount)
+        {
+            NewPageCount = PageCount;
+        }
+        if(NewPageCount > Renderer->MaxGlyphPageCount)
+        {
+            NewPageCount = Renderer->MaxGlyphPageCount;
+        }
+
+        ID3D11Texture2D *Texture = 0;
+        ID3D11ShaderResourceView *View = 0;
+        if(CreateD3D11GlyphPages(Renderer, NewPageCount, &Texture, &View))
+        {
+            for(uint32_t PageIndex = 0; PageIndex < Renderer->GlyphPageCount; ++PageIndex)
+            {
+                ID3D11DeviceContext_CopySubresourceRegion(Renderer->DeviceContext,
+                                                          (ID3D11Resource *)Texture, PageIndex, 0, 0, 0,
+                                                          (ID3D11Resource *)Renderer->GlyphTexture, PageIndex, 0);
+            }
+
+            ReleaseD3DGlyphCache(Renderer);
+            Renderer->GlyphTexture = Texture;
+            Renderer->GlyphTextureView = View;
+            Renderer->GlyphPageCount = NewPageCount;
+
+            Result = 1;
+        }
+    }
+
+    return Result;
+}
+
+static int ReadD3D11GlyphCachePixels(d3d11_renderer *Renderer, uint32_t FirstPage, uint32_t PageCount, uint32_t Pitch, void *Pixels)
+{
+    // NOTE: The glyph cache texture isn't CPU-readable, so it has to go through a staging copy.
+    // The pages are read one below the other.
+    int Result = 0;
+
+    if(Renderer->Device && Renderer->GlyphTexture && PageCount && ((FirstPage + PageCount) <= Renderer->GlyphPageCount))
+    {
+        uint32_t Width = Renderer->GlyphCacheWidth;
+        uint32_t Height = Renderer->GlyphCacheHeight;
+
         D3D11_TEXTURE2D_DESC TextureDesc =
         {
             .Width = Width,
             .Height = Height,
             .MipLevels = 1,
-            .ArraySize = 1,
+            .ArraySize = PageCount,
             .Format = DXGI_FORMAT_B8G8R8A8_UNORM,
             .SampleDesc = { 1, 0 },
-            .Usage = D3D11_USAGE_DEFAULT,
-            .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+            .Usage = D3D11_USAGE_STAGING,
+            .CPUAccessFlags = D3D11_CPU_ACCESS_READ,
         };
 
-        if(SUCCEEDED(ID3D11Device_CreateTexture2D(Renderer->Device, &TextureDesc, NULL, &Renderer->GlyphTexture)))
+        ID3D11Texture2D *Staging = 0;
+        if(SUCCEEDED(ID3D11Device_CreateTexture2D(Renderer->Device, &TextureDesc, 0, &Staging)))
+        {
+            for(uint32_t PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+            {
+                ID3D11DeviceContext_CopySubresourceRegion(Renderer->DeviceContext,
+                                                          (ID3D11Resource *)Staging, PageIndex, 0, 0, 0,
+                                                          (ID3D11Resource *)Renderer->GlyphTexture, FirstPage + PageIndex, 0);
+            }
+
+            Result = 1;
+            for(uint32_t PageIndex = 0; Result && (PageIndex < PageCount); ++PageIndex)
+            {
+                D3D11_MAPPED_SUBRESOURCE Mapped;
+                Result = SUCCEEDED(ID3D11DeviceContext_Map(Renderer->DeviceContext, (ID3D11Resource *)Staging, PageIndex, D3D11_MAP_READ, 0, &Mapped));
+                if(Result)
+                {
+                    char *Dest = (char *)Pixels + (size_t)PageIndex*Height*Pitch;
+                    for(uint32_t Y = 0; Y < Height; ++Y)
+                    {
+                        memcpy(Dest + Y*Pitch, (char *)Mapped.pData + Y*Mapped.RowPitch, Width*4);
+                    }
+
+                    ID3D11DeviceContext_Unmap(Renderer->DeviceContext, (ID3D11Resource *)Staging, PageIndex);
+                }
+            }
+
+            ID3D11Texture2D_Release(Staging);
+        }
+    }
+
+    return Result;
+}
+
+static int WriteD3D11GlyphCachePixels(d3d11_renderer *Renderer, uint32_t FirstPage, uint32_t PageCount, uint32_t Pitch, void *Pixels)
+{
+    // NOTE: PageCount pages, one below the other, the way ReadD3D11GlyphCachePixels wrote them
+    int Result = EnsureD3D11GlyphPageCount(Renderer, FirstPage + PageCount);
+    if(Result && Renderer->DeviceContext)
+    {
+        for(uint32_t PageIndex = 0; PageIndex < PageCount; ++PageIndex)
         {
-            ID3D11Device_CreateShaderResourceView(Renderer->Device, (ID3D11Resource*)Renderer->GlyphTexture, NULL, &Renderer->GlyphTextureView);
+            char *Source = (char *)Pixels + (size_t)PageIndex*Renderer->GlyphCacheHeight*Pitch;
+            ID3D11DeviceContext_UpdateSubresource(Renderer->DeviceContext, (ID3D11Resource *)Renderer->GlyphTexture, FirstPage + PageIndex, 0, Source, Pitch, 0);
         }
     }
+
+    return Result;
 }
 
 static void SetD3D11GlyphTransferDim(d3d11_renderer *Renderer, uint32_t Width, uint32_t Height)
@@ -280,7 +437,71 @@ static void ReleaseD3D11Renderer(d3d11_renderer *Renderer)
     *Renderer = ZeroRenderer;
 }
 
-static d3d11_renderer AcquireD3D11Renderer(HWND Window, int EnableDebugging)
+static ID3DBlob *CompileD3D11Shader(wchar_t *Path, char *EntryPoint, char *Target)
+{
+    ID3DBlob *Result = 0;
+    ID3DBlob *Errors = 0;
+
+    // NOTE: The same options build.bat used to give fxc (/O3 /WX)
+    HRESULT hr = D3DCompileFromFile(Path, 0, 0, EntryPoint, Target,
+                                    D3DCOMPILE_OPTIMIZATION_LEVEL3|D3DCOMPILE_WARNINGS_ARE_ERRORS, 0, &Result, &Errors);
+    if(FAILED(hr))
+    {
+        if(Result)
+        {
+            ID3D10Blob_Release(Result);
+            Result = 0;
+        }
+
+        char *Message = Errors ? (char *)ID3D10Blob_GetBufferPointer(Errors) : "Unable to read refterm.hlsl, which has to be next to the executable";
+        MessageBoxA(0, Message, "Unable to compile shaders", MB_OK|MB_ICONSTOP);
+    }
+
+    if(Errors)
+    {
+        ID3D10Blob_Release(Errors);
+    }
+
+    return Result;
+}
+
+static d3d11_shader_code CompileD3D11Shaders(void)
+{
+    /* NOTE: The shaders are compiled from refterm.hlsl when the terminal starts, instead of
+       being built into headers with fxc, so the build only needs a C compiler and the
+       shaders can never be out of date with the source.  It costs some startup time, and
+       d3dcompiler_47.dll, which Windows has had since 8.1.  If it fails, the message box
+       says why, and the renderer is made without shaders and only presents blank frames. */
+    d3d11_shader_code Result = {0};
+
+    wchar_t Path[MAX_PATH + 16];
+    DWORD Length = GetModuleFileNameW(0, Path, MAX_PATH);
+    while(Length && (Path[Length - 1] != L'\\'))
+    {
+        --Length;
+    }
+
+    wchar_t *FileName = L"refterm.hlsl";
+    while(*FileName)
+    {
+        Path[Length++] = *FileName++;
+    }
+    Path[Length] = 0;
+
+    Result.ComputeShader = CompileD3D11Shader(Path, "ComputeMain", "cs_5_0");
+    if(Result.ComputeShader)
+    {
+        Result.PixelShader = CompileD3D11Shader(Path, "PixelMain", "ps_5_0");
+    }
+    if(Result.PixelShader)
+    {
+        Result.VertexShader = CompileD3D11Shader(Path, "VertexMain", "vs_5_0");
+    }
+
+    return Result;
+}
+
+static d3d11_renderer AcquireD3D11Renderer(HWND Window, int EnableDebugging, d3d11_shader_code *Code)
 {
     d3d11_renderer Result = {0};
 
@@ -322,9 +543,15 @@ static d3d11_renderer AcquireD3D11Renderer(HWND Window, int EnableDebugging)
                 };
                 ID3D11Device_CreateBuffer(Result.Device, &ConstantBufferDesc, 0, &Result.ConstantBuffer);
 
-                ID3D11Device_CreateComputeShader(Result.Device, ReftermCSShaderBytes, sizeof(ReftermCSShaderBytes), 0, &Result.ComputeShader);
-                ID3D11Device_CreatePixelShader(Result.Device, ReftermPSShaderBytes, sizeof(ReftermPSShaderBytes), 0, &Result.PixelShader);
-                ID3D11Device_CreateVertexShader(Result.Device, ReftermVSShaderBytes, sizeof(ReftermVSShaderBytes), 0, &Result.VertexShader);
+                if(Code->ComputeShader && Code->PixelShader && Code->VertexShader)
+                {
+                    ID3D11Device_CreateComputeShader(Result.Device, ID3D10Blob_GetBufferPointer(Code->ComputeShader),
+                                                     ID3D10Blob_GetBufferSize(Code->ComputeShader), 0, &Result.ComputeShader);
+                    ID3D11Device_CreatePixelShader(Result.Device, ID3D10Blob_GetBufferPointer(Code->PixelShader),
+                                                   ID3D10Blob_GetBufferSize(Code->PixelShader), 0, &Result.PixelShader);
+                    ID3D11Device_CreateVertexShader(Result.Device, ID3D10Blob_GetBufferPointer(Code->VertexShader),
+                                                    ID3D10Blob_GetBufferSize(Code->VertexShader), 0, &Result.VertexShader);
+                }
             }
         }
     }
@@ -398,7 +625,8 @@ static void RendererDraw(example_terminal *Terminal, uint32_t Width, uint32_t He
         SetD3D11MaxCellCount(Renderer, CellCount);
     }
         
-    if(Renderer->RenderView || Renderer->RenderTarget)
+    // NOTE: The shaders are all there or none are (see CompileD3D11Shaders)
+    if((Renderer->RenderView || Renderer->RenderTarget) && Renderer->ComputeShader)
     {
         D3D11_MAPPED_SUBRESOURCE Mapped;
         hr = ID3D11DeviceContext_Map(Renderer->DeviceContext, (ID3D11Resource*)Renderer->ConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &Mapped);
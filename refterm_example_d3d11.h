@@ -19,6 +19,14 @@ typedef struct
     uint32_t Background; // NOTE(casey): The top bit of the background flag indicates blinking
 } renderer_cell;
 
+typedef struct
+{
+    // NOTE: Compiled from refterm.hlsl once, when the terminal starts, and used for every device after that
+    ID3DBlob *ComputeShader;
+    ID3DBlob *PixelShader;
+    ID3DBlob *VertexShader;
+} d3d11_shader_code;
+
 typedef struct
 {
     ID3D11Device *Device;
@@ -39,8 +47,13 @@ typedef struct
     ID3D11Buffer *CellBuffer;
     ID3D11ShaderResourceView *CellView;
 
+    // NOTE: The glyph cache is a texture array, and GlyphPageCount of its pages exist so far
     ID3D11Texture2D *GlyphTexture;
     ID3D11ShaderResourceView *GlyphTextureView;
+    uint32_t GlyphCacheWidth;
+    uint32_t GlyphCacheHeight;
+    uint32_t GlyphPageCount;
+    uint32_t MaxGlyphPageCount;
 
     ID3D11Texture2D *GlyphTransfer;
     ID3D11ShaderResourceView *GlyphTransferView;
@@ -57,7 +70,11 @@ typedef struct
     int UseComputeShader;
 } d3d11_renderer;
 
-static d3d11_renderer AcquireD3D11Renderer(HWND Window, int EnableDebugging);
+static d3d11_shader_code CompileD3D11Shaders(void);
+static d3d11_renderer AcquireD3D11Renderer(HWND Window, int EnableDebugging, d3d11_shader_code *Code);
 
 static void SetD3D11MaxCellCount(d3d11_renderer *Renderer, uint32_t Count);
-static void SetD3D11GlyphCacheDim(d3d11_renderer *Renderer, uint32_t Width, uint32_t Height);
+static void SetD3D11GlyphCacheDim(d3d11_renderer *Renderer, uint32_t Width, uint32_t Height, uint32_t MaxPageCount);
+static int EnsureD3D11GlyphPageCount(d3d11_renderer *Renderer, uint32_t PageCount);
+static int ReadD3D11GlyphCachePixels(d3d11_renderer *Renderer, uint32_t FirstPage, uint32_t PageCount, uint32_t Pitch, void *Pixels);
+static int WriteD3D11GlyphCachePixels(d3d11_renderer *Renderer, uint32_t FirstPage, uint32_t PageCount, uint32_t Pitch, void *Pixels);
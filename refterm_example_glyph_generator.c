@@ -32,7 +32,7 @@ static glyph_dim GetSingleTileUnitDim(void)
     return Result;
 }
 
-static glyph_dim GetGlyphDim(glyph_generator *GlyphGen, glyph_table *Table, size_t Count, wchar_t *String, glyph_hash RunHash)
+static glyph_dim GetGlyphDimForEntry(glyph_generator *GlyphGen, glyph_table *Table, glyph_state *Entry, size_t Count, wchar_t *String)
 {
     /* TODO(casey): Windows can only 2^31 glyph runs - which
        seems fine, but... technically Unicode can have more than two
@@ -45,20 +45,25 @@ static glyph_dim GetGlyphDim(glyph_generator *GlyphGen, glyph_table *Table, size
     Assert(StringLen == Count);
 
     SIZE Size = {0};
-    glyph_state Entry = FindGlyphEntryByHash(Table, RunHash);
-    if(Entry.FilledState == GlyphState_None)
+    if(Entry->FilledState == GlyphState_None)
     {
         if(StringLen)
         {
             Size = DWriteGetTextExtent(GlyphGen, StringLen, String);
         }
+        ++GlyphGen->SizeCount;
 
-        UpdateGlyphCacheEntry(Table, Entry.ID, GlyphState_Sized, (uint16_t)Size.cx, (uint16_t)Size.cy);
+        UpdateGlyphCacheEntry(Table, Entry->ID, GlyphState_Sized, (uint16_t)Size.cx, (uint16_t)Size.cy);
+
+        // NOTE: Keep the caller's copy of the state in sync with what was just stored
+        Entry->FilledState = GlyphState_Sized;
+        Entry->DimX = (uint16_t)Size.cx;
+        Entry->DimY = (uint16_t)Size.cy;
     }
     else
     {
-        Size.cx = Entry.DimX;
-        Size.cy = Entry.DimY;
+        Size.cx = Entry->DimX;
+        Size.cy = Entry->DimY;
     }
 
     Result.TileCount = SafeRatio1((uint16_t)(Size.cx + GlyphGen->FontWidth/2), GlyphGen->FontWidth);
@@ -86,10 +91,12 @@ static void PrepareTilesForTransfer(glyph_generator *GlyphGen, d3d11_renderer *R
 
     DWriteDrawText(GlyphGen, StringLen, String, 0, 0, GlyphGen->TransferWidth, GlyphGen->TransferHeight,
                    Renderer->DWriteRenderTarget, Renderer->DWriteFillBrush, Dim.XScale, Dim.YScale);
+    ++GlyphGen->RasterizeCount;
 }
 
-static void TransferTile(glyph_generator *GlyphGen, d3d11_renderer *Renderer, uint32_t TileIndex, gpu_glyph_index DestIndex)
+static void TransferTile(glyph_generator *GlyphGen, d3d11_renderer *Renderer, uint32_t TileIndex, uint32_t TileCount, gpu_glyph_index DestIndex)
 {
+    // NOTE: TileCount tiles starting at TileIndex go to TileCount tiles starting at DestIndex, which must all be in one row
     /* TODO(casey):
 
        Regardless of whether DirectWrite or GDI is used, rasterizing glyphs via Windows' libraries is extremely slow.
@@ -116,16 +123,17 @@ static void TransferTile(glyph_generator *GlyphGen, d3d11_renderer *Renderer, ui
        we should warn about that and revert the font size to something smaller?
     */
 
-    if(Renderer->DeviceContext)
+    // NOTE: The first glyph to land on a page is what creates that page of the cache texture
+    glyph_cache_point Point = UnpackGlyphCachePoint(DestIndex);
+    if(Renderer->DeviceContext && EnsureD3D11GlyphPageCount(Renderer, Point.Page + 1))
     {
-        glyph_cache_point Point = UnpackGlyphCachePoint(DestIndex);
         uint32_t X = Point.X*GlyphGen->FontWidth;
         uint32_t Y = Point.Y*GlyphGen->FontHeight;
 
         D3D11_BOX SourceBox =
         {
             .left = (TileIndex)*GlyphGen->FontWidth,
-            .right = (TileIndex + 1)*GlyphGen->FontWidth,
+            .right = (TileIndex + TileCount)*GlyphGen->FontWidth,
             .top = 0,
             .bottom = GlyphGen->FontHeight,
             .front = 0,
@@ -133,7 +141,7 @@ static void TransferTile(glyph_generator *GlyphGen, d3d11_renderer *Renderer, ui
         };
 
         ID3D11DeviceContext_CopySubresourceRegion(Renderer->DeviceContext,
-                                                  (ID3D11Resource *)Renderer->GlyphTexture, 0, X, Y, 0,
+                                                  (ID3D11Resource *)Renderer->GlyphTexture, Point.Page, X, Y, 0,
                                                   (ID3D11Resource *)Renderer->GlyphTransfer, 0, &SourceBox);
     }
 }
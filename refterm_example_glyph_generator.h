@@ -23,6 +23,10 @@ struct glyph_generator
     uint32_t TransferWidth;
     uint32_t TransferHeight;
     
+    // NOTE: Running totals of the DirectWrite work done for glyph cache misses, for "status"
+    size_t SizeCount;
+    size_t RasterizeCount;
+    
     // NOTE(casey): For DWrite-based generation:
     struct IDWriteFactory *DWriteFactory;
     struct IDWriteFontFace *FontFace;
@@ -0,0 +1,235 @@
+static int BytesAreEqual(size_t Count, void *AInit, void *BInit)
+{
+    char unsigned *A = (char unsigned *)AInit;
+    char unsigned *B = (char unsigned *)BInit;
+    while(Count--)
+    {
+        if(*A++ != *B++)
+        {
+            return(0);
+        }
+    }
+
+    return(1);
+}
+
+static uint64_t AlignSnapshotOffset(uint64_t Offset, uint64_t Alignment)
+{
+    uint64_t Result = (Offset + Alignment - 1) & ~(Alignment - 1);
+    return Result;
+}
+
+static void GetGlyphSnapshotPath(glyph_snapshot_key *Key, wchar_t *Path, DWORD MaxCount)
+{
+    // NOTE: Each key gets its own file, named after a hash of the key
+    glyph_hash KeyHash = ComputeGlyphHash(sizeof(*Key), (char unsigned *)Key, DefaultSeed);
+    DWORD Count = GetTempPathW(MaxCount - 32, Path);
+    if(Count >= (MaxCount - 32))
+    {
+        Count = 0;
+    }
+    wsprintfW(Path + Count, L"refterm_glyphs_%08x.bin", (uint32_t)_mm_cvtsi128_si32(KeyHash.Value));
+}
+
+static uint64_t GetGlyphSnapshotTime(void)
+{
+    FILETIME Time;
+    GetSystemTimeAsFileTime(&Time);
+    uint64_t Result = ((uint64_t)Time.dwHighDateTime << 32) | Time.dwLowDateTime;
+    return Result;
+}
+
+static int IsGlyphSnapshotSeedExpired(uint64_t SeedTime)
+{
+    // NOTE: A seed from the future (the clock was set back) doesn't get to live longer either
+    uint64_t Now = GetGlyphSnapshotTime();
+    int Result = ((SeedTime > Now) || ((Now - SeedTime) > GLYPH_SNAPSHOT_SEED_LIFETIME));
+    return Result;
+}
+
+static glyph_hash ComputeGlyphSnapshotChecksum(char unsigned *View, uint64_t FileSize)
+{
+    glyph_hash Result = ComputeGlyphHash(FileSize - sizeof(glyph_snapshot_header), View + sizeof(glyph_snapshot_header), DefaultSeed);
+    return Result;
+}
+
+static int SaveGlyphSnapshot(glyph_snapshot_key *Key, glyph_table *Table, d3d11_renderer *Renderer, uint32_t FirstPage, uint64_t SeedTime)
+{
+    int Result = 0;
+
+    if(!Table || !Renderer->GlyphTexture || (FirstPage >= Renderer->GlyphPageCount))
+    {
+        return(Result);
+    }
+
+    // NOTE: A seed that has been around too long, or that something has been colliding hashes
+    // under, isn't kept - and neither is the last snapshot made with it, so the next run re-seeds
+    if(IsGlyphSnapshotSeedExpired(SeedTime) || GetGlyphTableStats(Table).ChainEvictionCount)
+    {
+        wchar_t OldPath[MAX_PATH + 32];
+        GetGlyphSnapshotPath(Key, OldPath, ArrayCount(OldPath));
+        DeleteFileW(OldPath);
+        return(Result);
+    }
+
+    uint32_t EntryCapacity = GetGlyphTableSnapshotCapacity(Key->Params);
+    uint64_t EntryOffset = AlignSnapshotOffset(sizeof(glyph_snapshot_header), 64);
+    uint64_t PixelPitch = 4*Key->TextureWidth;
+    uint64_t PixelOffset = AlignSnapshotOffset(EntryOffset + EntryCapacity*sizeof(glyph_snapshot_entry), 4096);
+    uint32_t PageCount = Renderer->GlyphPageCount - FirstPage;
+    if(PageCount > GetGlyphTablePageCount(Key->Params))
+    {
+        PageCount = GetGlyphTablePageCount(Key->Params);
+    }
+    uint64_t FileSize = PixelOffset + PixelPitch*Key->TextureHeight*PageCount;
+
+    // NOTE: Written to a temporary file first and then moved over the old one, so a snapshot
+    // that didn't finish writing never replaces a good one.
+    wchar_t Path[MAX_PATH + 32];
+    wchar_t TempPath[MAX_PATH + 48];
+    GetGlyphSnapshotPath(Key, Path, ArrayCount(Path));
+    wsprintfW(TempPath, L"%s.tmp", Path);
+
+    HANDLE File = CreateFileW(TempPath, GENERIC_READ|GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(File != INVALID_HANDLE_VALUE)
+    {
+        HANDLE Mapping = CreateFileMappingW(File, 0, PAGE_READWRITE, (DWORD)(FileSize >> 32), (DWORD)FileSize, 0);
+        if(Mapping)
+        {
+            char unsigned *View = (char unsigned *)MapViewOfFile(Mapping, FILE_MAP_WRITE, 0, 0, FileSize);
+            if(View)
+            {
+                if(ReadD3D11GlyphCachePixels(Renderer, FirstPage, PageCount, (uint32_t)PixelPitch, View + PixelOffset))
+                {
+                    glyph_snapshot_header *Header = (glyph_snapshot_header *)View;
+                    Header->Magic = GLYPH_SNAPSHOT_MAGIC;
+                    Header->Version = GLYPH_SNAPSHOT_VERSION;
+                    Header->HeaderSize = sizeof(glyph_snapshot_header);
+                    Header->EntryCount = SaveGlyphTableSnapshot(Table, EntryCapacity, (glyph_snapshot_entry *)(View + EntryOffset));
+                    Header->PageCount = PageCount;
+                    Header->Key = *Key;
+                    Header->EntryOffset = EntryOffset;
+                    Header->PixelOffset = PixelOffset;
+                    Header->PixelPitch = PixelPitch;
+                    Header->FileSize = FileSize;
+                    CopyMemory(Header->HashSeed, GetGlyphTableSeed(Table), sizeof(Header->HashSeed));
+                    Header->SeedTime = SeedTime;
+                    Header->Checksum = ComputeGlyphSnapshotChecksum(View, FileSize);
+
+                    Result = 1;
+                }
+
+                UnmapViewOfFile(View);
+            }
+
+            CloseHandle(Mapping);
+        }
+
+        CloseHandle(File);
+
+        if(Result)
+        {
+            Result = MoveFileExW(TempPath, Path, MOVEFILE_REPLACE_EXISTING);
+        }
+
+        if(!Result)
+        {
+            DeleteFileW(TempPath);
+        }
+    }
+
+    return Result;
+}
+
+static int IsGlyphSnapshotValid(glyph_snapshot_key *Key, char unsigned *View, uint64_t FileSize)
+{
+    // NOTE: Everything in the file is checked before any of it is used, since it could be
+    // left over from another version, or just be damaged.
+    glyph_snapshot_header *Header = (glyph_snapshot_header *)View;
+    uint64_t EntrySize = (uint64_t)Header->EntryCount*sizeof(glyph_snapshot_entry);
+
+    int Result = ((Header->Magic == GLYPH_SNAPSHOT_MAGIC) &&
+                  (Header->Version == GLYPH_SNAPSHOT_VERSION) &&
+                  (Header->HeaderSize == sizeof(glyph_snapshot_header)) &&
+                  (Header->FileSize == FileSize) &&
+                  BytesAreEqual(sizeof(*Key), &Header->Key, Key) &&
+                  (Header->EntryCount <= GetGlyphTableSnapshotCapacity(Key->Params)) &&
+                  (Header->PageCount >= 1) &&
+                  (Header->PageCount <= GetGlyphTablePageCount(Key->Params)) &&
+                  (Header->EntryOffset >= sizeof(glyph_snapshot_header)) &&
+                  ((Header->EntryOffset % 64) == 0) &&
+                  (Header->EntryOffset <= FileSize) &&
+                  (EntrySize <= (FileSize - Header->EntryOffset)) &&
+                  (Header->PixelPitch == 4*Key->TextureWidth) &&
+                  (Header->PixelOffset >= (Header->EntryOffset + EntrySize)) &&
+                  (Header->PixelOffset <= FileSize) &&
+                  ((Header->PixelPitch*Key->TextureHeight*Header->PageCount) <= (FileSize - Header->PixelOffset)));
+    if(Result)
+    {
+        glyph_hash Checksum = ComputeGlyphSnapshotChecksum(View, FileSize);
+        Result = GlyphHashesAreEqual(Checksum, Header->Checksum);
+    }
+
+    return Result;
+}
+
+static int LoadGlyphSnapshot(glyph_snapshot_key *Key, glyph_table *Table, d3d11_renderer *Renderer, uint32_t FirstPage, uint64_t *SeedTime)
+{
+    // NOTE: Table must have just been placed with Key->Params (apart from FirstCachePage, which
+    // is FirstPage), with nothing looked up in it yet
+    int Result = 0;
+
+    if(!Table || !Renderer->GlyphTexture)
+    {
+        return(Result);
+    }
+
+    wchar_t Path[MAX_PATH + 32];
+    GetGlyphSnapshotPath(Key, Path, ArrayCount(Path));
+
+    int Expired = 0;
+    HANDLE File = CreateFileW(Path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(File != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER FileSize;
+        if(GetFileSizeEx(File, &FileSize) && (FileSize.QuadPart >= (LONGLONG)sizeof(glyph_snapshot_header)))
+        {
+            HANDLE Mapping = CreateFileMappingW(File, 0, PAGE_READONLY, 0, 0, 0);
+            if(Mapping)
+            {
+                char unsigned *View = (char unsigned *)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+                if(View)
+                {
+                    glyph_snapshot_header *Header = (glyph_snapshot_header *)View;
+                    if(IsGlyphSnapshotValid(Key, View, (uint64_t)FileSize.QuadPart))
+                    {
+                        Expired = IsGlyphSnapshotSeedExpired(Header->SeedTime);
+                        if(!Expired &&
+                           WriteD3D11GlyphCachePixels(Renderer, FirstPage, Header->PageCount, (uint32_t)Header->PixelPitch, View + Header->PixelOffset))
+                        {
+                            SetGlyphTableSeed(Table, Header->HashSeed);
+                            LoadGlyphTableSnapshot(Table, Header->EntryCount, (glyph_snapshot_entry *)(View + Header->EntryOffset));
+                            *SeedTime = Header->SeedTime;
+
+                            Result = 1;
+                        }
+                    }
+
+                    UnmapViewOfFile(View);
+                }
+
+                CloseHandle(Mapping);
+            }
+        }
+
+        CloseHandle(File);
+    }
+
+    // NOTE: The table keeps the seed it was just given, so nothing will ever load this one again
+    if(Expired)
+    {
+        DeleteFileW(Path);
+    }
+
+    return Result;
+}
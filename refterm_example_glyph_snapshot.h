@@ -0,0 +1,78 @@
+/* NOTE:
+
+   The glyph snapshot saves the glyph table and the pixels of the glyph cache texture
+   to a file when refterm exits (or drops a font's partition), and loads them back when
+   the same font is set up again, so glyphs that were on screen last time don't have to
+   go through DirectWrite again.
+
+   The file is only ever used if its key matches exactly - the same font, the same
+   cell size, the same texture, the same glyph_table_params and the same glyph hash
+   backend - because the table's hashes, its IDs and the tile positions in the texture
+   only mean anything for that exact setup.
+   There is one file per key in the temp directory, so switching between fonts keeps
+   a snapshot for each.  Only the pages of the cache texture that existed at the time
+   are saved, so a session that only ever used one page has a one-page file.
+
+   Every glyph table has its own random hash seed, and the saved hashes only mean anything
+   with that seed, so the seed is saved in the header (not the key) and put back into the
+   table when the snapshot is loaded.  That trades some of what the seed is for (text can't
+   be made to collide without knowing it) for a warm start: the longer one seed is kept, the
+   longer something that worked it out can keep using it.  So the header also holds when
+   the seed was made, and a snapshot whose seed is older than GLYPH_SNAPSHOT_SEED_LIFETIME
+   is deleted instead of loaded - the table gets a new seed and starts cold.  A table that
+   had to evict anything for chain length (see ChainEvictionCount) doesn't get saved at all,
+   and its old snapshot is deleted too, since a random seed never gets chains that long
+   unless something is colliding on purpose.
+
+   The table can be on any pages of the texture (see glyph_table_params.FirstCachePage),
+   so the key always has FirstCachePage zeroed, and the page the table actually starts
+   on is passed in separately.  A snapshot saved from one range of pages loads fine
+   into another.
+*/
+
+typedef struct
+{
+    // NOTE: Compared with memcmp, so always zero the whole thing before filling it in
+    wchar_t FontName[64];
+    uint32_t FontHeight;
+    uint32_t CellWidth;
+    uint32_t CellHeight;
+    uint32_t TextureWidth;
+    uint32_t TextureHeight;
+    glyph_table_params Params;
+    uint32_t HashBackend; // NOTE: The glyph_hash_backend the table's hashes came from
+} glyph_snapshot_key;
+
+#define GLYPH_SNAPSHOT_MAGIC 0x53475452 // NOTE: "RTGS"
+#define GLYPH_SNAPSHOT_VERSION 6 // NOTE: 4 hashes runs as UTF-8 instead of UTF-16, 5 saves the table's seed, 6 when it was made
+#define GLYPH_SNAPSHOT_SEED_LIFETIME (7ull*24*60*60*10000000) // NOTE: A week, in FILETIME units
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t HeaderSize;
+    uint32_t EntryCount;
+    uint32_t PageCount; // NOTE: How many of the table's pages of the cache texture there were, one below the other in the pixels
+
+    glyph_snapshot_key Key;
+
+    uint64_t EntryOffset;
+    uint64_t PixelOffset;
+    uint64_t PixelPitch;
+    uint64_t FileSize;
+
+    // NOTE: The table's hashes were made with this, so it goes back into the table on load (see SetGlyphTableSeed)
+    char unsigned HashSeed[16];
+    uint64_t SeedTime; // NOTE: When HashSeed was made (see GetGlyphSnapshotTime)
+
+    // NOTE: Hash of every byte after the header, so a torn or damaged file is never loaded
+    glyph_hash Checksum;
+} glyph_snapshot_header;
+
+static uint64_t GetGlyphSnapshotTime(void); // NOTE: The system time, as a FILETIME
+
+/* NOTE: SeedTime is when the table's seed was made.  Loading passes back the one the snapshot
+   was saved with, so it has to be saved again with that and not the time it was loaded. */
+static int SaveGlyphSnapshot(glyph_snapshot_key *Key, glyph_table *Table, d3d11_renderer *Renderer, uint32_t FirstPage, uint64_t SeedTime);
+static int LoadGlyphSnapshot(glyph_snapshot_key *Key, glyph_table *Table, d3d11_renderer *Renderer, uint32_t FirstPage, uint64_t *SeedTime);
@@ -0,0 +1,328 @@
+#define LINE_INDEX_COMMIT_STEP (1024*1024)
+
+static size_t GetLineIndexMemorySize(uint32_t MaxChunkCount, uint32_t MaxPropsCount)
+{
+    size_t Result = (size_t)MaxChunkCount*sizeof(line_chunk) + (size_t)MaxPropsCount*sizeof(glyph_props);
+    return Result;
+}
+
+static int IsUsableLineIndexState(line_index_state *State)
+{
+    size_t LineCount = State->OnePastLastLine - State->FirstLine;
+    int Result = (IsPowerOfTwo(State->MaxChunkCount) &&
+                  (State->MaxChunkCount >= 2) &&
+                  IsPowerOfTwo(State->MaxPropsCount) &&
+                  (State->MaxPropsCount >= 2*LINE_CHUNK_SIZE) &&
+                  ((State->FirstLine % LINE_CHUNK_SIZE) == 0) &&
+                  (State->FirstLine < State->OnePastLastLine) &&
+                  (LineCount <= (size_t)State->MaxChunkCount*LINE_CHUNK_SIZE));
+    return Result;
+}
+
+static void PlaceLineIndex(line_index *Index, char *Memory)
+{
+    Index->Chunks = (line_chunk *)Memory;
+    Index->Props = (glyph_props *)(Memory + (size_t)Index->State.MaxChunkCount*sizeof(line_chunk));
+    memset(Index->PropsSlots, 0, sizeof(Index->PropsSlots));
+}
+
+static line_index AllocateLineIndex(uint32_t MaxChunkCount, uint32_t MaxPropsCount)
+{
+    /* NOTE: Only the address space is taken here; chunks and props are committed as they
+       are first used, by CommitLineIndexMemory.  If even that fails, Chunks is 0 and nothing
+       can be appended, the same as if the memory ran out later. */
+    line_index Result = {0};
+
+    Assert(IsPowerOfTwo(MaxChunkCount) && (MaxChunkCount >= 2));
+    Assert(IsPowerOfTwo(MaxPropsCount) && (MaxPropsCount >= 2*LINE_CHUNK_SIZE));
+
+    size_t Size = GetLineIndexMemorySize(MaxChunkCount, MaxPropsCount);
+#if _WIN32
+    char *Memory = (char *)VirtualAlloc(0, Size, MEM_RESERVE, PAGE_READWRITE);
+#else
+    // NOTE: Linux only backs pages when they are touched anyway
+    char *Memory = (char *)mmap(0, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if(Memory == MAP_FAILED)
+    {
+        Memory = 0;
+    }
+#endif
+
+    if(Memory)
+    {
+        Result.State.MaxChunkCount = MaxChunkCount;
+        Result.State.MaxPropsCount = MaxPropsCount;
+        Result.CommitOnDemand = 1;
+        PlaceLineIndex(&Result, Memory);
+    }
+
+    return Result;
+}
+
+static void FreeLineIndex(line_index *Index)
+{
+    if(Index->CommitOnDemand && Index->Chunks)
+    {
+#if _WIN32
+        VirtualFree(Index->Chunks, 0, MEM_RELEASE);
+#else
+        munmap(Index->Chunks, GetLineIndexMemorySize(Index->State.MaxChunkCount, Index->State.MaxPropsCount));
+#endif
+    }
+
+    line_index NullIndex = {0};
+    *Index = NullIndex;
+}
+
+static int AttachLineIndex(line_index *Index, void *Memory, uint32_t MaxChunkCount, uint32_t MaxPropsCount, line_index_state State)
+{
+    int Result = ((State.MaxChunkCount == MaxChunkCount) &&
+                  (State.MaxPropsCount == MaxPropsCount) &&
+                  IsUsableLineIndexState(&State));
+    if(!Result)
+    {
+        line_index_state EmptyState = {0};
+        EmptyState.MaxChunkCount = MaxChunkCount;
+        EmptyState.MaxPropsCount = MaxPropsCount;
+        State = EmptyState;
+    }
+
+    line_index NullIndex = {0};
+    *Index = NullIndex;
+    Index->State = State;
+    Index->CommittedChunkSize = (size_t)MaxChunkCount*sizeof(line_chunk);
+    Index->CommittedPropsSize = (size_t)MaxPropsCount*sizeof(glyph_props);
+    PlaceLineIndex(Index, (char *)Memory);
+
+    return Result;
+}
+
+static int CommitLineIndexMemory(void *Base, size_t *CommittedSize, size_t NeededSize, size_t TotalSize)
+{
+    int Result = 1;
+    if(NeededSize > *CommittedSize)
+    {
+        size_t NewSize = (NeededSize + LINE_INDEX_COMMIT_STEP - 1) & ~(size_t)(LINE_INDEX_COMMIT_STEP - 1);
+        if(NewSize > TotalSize)
+        {
+            NewSize = TotalSize;
+        }
+
+#if _WIN32
+        Result = (VirtualAlloc((char *)Base + *CommittedSize, NewSize - *CommittedSize, MEM_COMMIT, PAGE_READWRITE) != 0);
+#else
+        // NOTE: The mmap reservation is readable and writable already, and backed on first touch
+        (void)Base;
+#endif
+        if(Result)
+        {
+            *CommittedSize = NewSize;
+        }
+    }
+
+    return Result;
+}
+
+static line_chunk *GetLineChunk(line_index *Index, size_t Line)
+{
+    line_chunk *Result = Index->Chunks + ((Line / LINE_CHUNK_SIZE) & (Index->State.MaxChunkCount - 1));
+    return Result;
+}
+
+static void DropOldestLineChunk(line_index *Index)
+{
+    // NOTE: Never the chunk a line is being appended to, which the callers make sure of
+    Index->State.FirstLine += LINE_CHUNK_SIZE;
+    Assert(Index->State.FirstLine <= Index->State.OnePastLastLine);
+}
+
+static int BeginLineChunk(line_index *Index, size_t Line, size_t BaseP)
+{
+    line_index_state *State = &Index->State;
+    size_t ChunkSlot = (Line / LINE_CHUNK_SIZE) & (State->MaxChunkCount - 1);
+
+    // NOTE: Slots and props are used in order until they wrap, so what is committed is always a prefix
+    int Result = 0;
+    if(Index->Chunks)
+    {
+        size_t PropsNeeded = State->PropsEnd + LINE_CHUNK_SIZE;
+        if(PropsNeeded > State->MaxPropsCount) PropsNeeded = State->MaxPropsCount;
+
+        Result = (CommitLineIndexMemory(Index->Chunks, &Index->CommittedChunkSize, (ChunkSlot + 1)*sizeof(line_chunk),
+                                        (size_t)State->MaxChunkCount*sizeof(line_chunk)) &&
+                  CommitLineIndexMemory(Index->Props, &Index->CommittedPropsSize, PropsNeeded*sizeof(glyph_props),
+                                        (size_t)State->MaxPropsCount*sizeof(glyph_props)));
+    }
+
+    if(Result)
+    {
+        if((Line - State->FirstLine) >= (size_t)State->MaxChunkCount*LINE_CHUNK_SIZE)
+        {
+            DropOldestLineChunk(Index);
+        }
+
+        line_chunk *Chunk = Index->Chunks + ChunkSlot;
+        Chunk->BaseP = BaseP;
+        Chunk->FirstProps = State->PropsEnd;
+        memset(Index->PropsSlots, 0, sizeof(Index->PropsSlots));
+    }
+
+    return Result;
+}
+
+static int PropsAreEqual(glyph_props A, glyph_props B)
+{
+    int Result = ((A.Foreground == B.Foreground) &&
+                  (A.Background == B.Background) &&
+                  (A.Flags == B.Flags));
+    return Result;
+}
+
+static uint16_t GetLinePropsIndex(line_index *Index, line_chunk *Chunk, glyph_props Props)
+{
+    line_index_state *State = &Index->State;
+    uint32_t PropsMask = State->MaxPropsCount - 1;
+
+    uint32_t Hash = ((Props.Foreground*0x9E3779B1u) ^ (Props.Background*0x85EBCA77u) ^ (Props.Flags*0xC2B2AE3Du));
+    uint32_t Slot = (Hash >> 16) & (LINE_PROPS_SLOT_COUNT - 1);
+
+    uint32_t Result = Index->PropsSlots[Slot];
+    if(Result && PropsAreEqual(Index->Props[(Chunk->FirstProps + Result - 1) & PropsMask], Props))
+    {
+        --Result;
+    }
+    else
+    {
+        /* NOTE: A chunk adds at most one props per line, so it needs at most LINE_CHUNK_SIZE of
+           the ring, which is at least twice that - dropping older chunks always makes room. */
+        while((State->PropsEnd - GetLineChunk(Index, State->FirstLine)->FirstProps) >= State->MaxPropsCount)
+        {
+            DropOldestLineChunk(Index);
+        }
+
+        Index->Props[State->PropsEnd & PropsMask] = Props;
+        Result = (uint32_t)(State->PropsEnd - Chunk->FirstProps);
+        ++State->PropsEnd;
+
+        // NOTE: A collision just replaces the slot, so at worst a props is added twice
+        Index->PropsSlots[Slot] = (uint16_t)(Result + 1);
+    }
+
+    return (uint16_t)Result;
+}
+
+static void AppendLine(line_index *Index, size_t FirstP, glyph_props StartingProps)
+{
+    line_index_state *State = &Index->State;
+    size_t Line = State->OnePastLastLine;
+
+    // NOTE: If a new chunk can't be committed, the next line just runs on into the current one
+    if(((Line % LINE_CHUNK_SIZE) != 0) || BeginLineChunk(Index, Line, FirstP))
+    {
+        if(State->CurrentContainsComplexChars && (Line > State->FirstLine))
+        {
+            GetLineChunk(Index, Line - 1)->Offsets[(Line - 1) % LINE_CHUNK_SIZE] |= LINE_COMPLEX_FLAG;
+        }
+
+        line_chunk *Chunk = GetLineChunk(Index, Line);
+        size_t Offset = FirstP - Chunk->BaseP;
+        if(Offset > LINE_OFFSET_MASK)
+        {
+            Offset = LINE_OFFSET_MASK;
+        }
+
+        Chunk->Offsets[Line % LINE_CHUNK_SIZE] = (uint32_t)Offset;
+        Chunk->PropsIndices[Line % LINE_CHUNK_SIZE] = GetLinePropsIndex(Index, Chunk, StartingProps);
+
+        State->OnePastLastLine = Line + 1;
+        State->CurrentEndP = FirstP;
+        State->CurrentContainsComplexChars = 0;
+    }
+}
+
+static void ResetLineIndex(line_index *Index, size_t FirstP, glyph_props StartingProps)
+{
+    // NOTE: Line numbers carry on, so a new first line gets a new chunk of its own
+    line_index_state *State = &Index->State;
+    size_t NextChunkLine = (State->OnePastLastLine + LINE_CHUNK_SIZE - 1) & ~(size_t)(LINE_CHUNK_SIZE - 1);
+    State->FirstLine = NextChunkLine;
+    State->OnePastLastLine = NextChunkLine;
+    State->CurrentContainsComplexChars = 0;
+
+    // NOTE: If nothing could be committed, there are no lines at all, and GetLine hands back empty ones
+    AppendLine(Index, FirstP, StartingProps);
+}
+
+static void SetCurrentLineEnd(line_index *Index, size_t OnePastLastP)
+{
+    Index->State.CurrentEndP = OnePastLastP;
+}
+
+static void MarkCurrentLineComplex(line_index *Index, uint32_t ContainsComplexChars)
+{
+    Index->State.CurrentContainsComplexChars |= ContainsComplexChars;
+}
+
+static size_t GetCurrentLine(line_index *Index)
+{
+    size_t Result = Index->State.OnePastLastLine - 1;
+    return Result;
+}
+
+static size_t GetLineIndexCount(line_index *Index)
+{
+    size_t Result = Index->State.OnePastLastLine - Index->State.FirstLine;
+    return Result;
+}
+
+static size_t GetLineFirstP(line_index *Index, size_t Line)
+{
+    line_chunk *Chunk = GetLineChunk(Index, Line);
+    size_t Result = Chunk->BaseP + (Chunk->Offsets[Line % LINE_CHUNK_SIZE] & LINE_OFFSET_MASK);
+    return Result;
+}
+
+static size_t GetCurrentLineLength(line_index *Index)
+{
+    size_t Result = 0;
+    if(GetLineIndexCount(Index))
+    {
+        Result = Index->State.CurrentEndP - GetLineFirstP(Index, GetCurrentLine(Index));
+    }
+
+    return Result;
+}
+
+static example_line GetLine(line_index *Index, size_t Line)
+{
+    line_index_state *State = &Index->State;
+
+    example_line Result = {0};
+    if((Line >= State->FirstLine) && (Line < State->OnePastLastLine))
+    {
+        line_chunk *Chunk = GetLineChunk(Index, Line);
+        uint32_t Offset = Chunk->Offsets[Line % LINE_CHUNK_SIZE];
+        Result.FirstP = Chunk->BaseP + (Offset & LINE_OFFSET_MASK);
+        Result.StartingProps = Index->Props[(Chunk->FirstProps + Chunk->PropsIndices[Line % LINE_CHUNK_SIZE]) &
+                                            (State->MaxPropsCount - 1)];
+
+        if((Line + 1) < State->OnePastLastLine)
+        {
+            Result.OnePastLastP = GetLineFirstP(Index, Line + 1);
+            Result.ContainsComplexChars = (Offset & LINE_COMPLEX_FLAG) ? 1 : 0;
+        }
+        else
+        {
+            Result.OnePastLastP = State->CurrentEndP;
+            Result.ContainsComplexChars = State->CurrentContainsComplexChars;
+        }
+
+        // NOTE: Only a saturated offset (or a damaged scrollback file) can get here
+        if(Result.OnePastLastP < Result.FirstP)
+        {
+            Result.OnePastLastP = Result.FirstP;
+        }
+    }
+
+    return Result;
+}
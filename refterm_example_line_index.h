@@ -0,0 +1,108 @@
+/* NOTE:
+
+   The line index is where the terminal keeps the lines it has parsed out of its scrollback,
+   by absolute line number, so scrolling can go back as far as the scrollback does instead of
+   as far as a fixed array of lines does.
+
+   Lines are kept in chunks of LINE_CHUNK_SIZE.  A chunk holds the absolute source position
+   its first line starts at, and every line in it is a 32-bit offset from there, so a line
+   costs 4 bytes instead of the 16 two size_t positions did.  A line doesn't store where it
+   ends either - every line ends where the next one starts (ParseLines never leaves a gap),
+   and the line still being parsed keeps its end in the index itself.  The top bit of the
+   offset says the line contains complex characters.
+
+   Starting props are kept by reference: each chunk appends the distinct props its lines
+   start with to a ring of props, and a line holds a 16-bit index from the chunk's first
+   one.  Output rarely changes its colors at the start of a line, so most chunks add one or
+   two props, and a line comes to a little over 6 bytes.
+
+   Both the chunks and the props are rings.  Chunks are found by line number (the chunk
+   number modulo MaxChunkCount, a power of two), so appending and looking up a line are
+   both O(1).  When the chunks or the props run out, the oldest chunk is dropped.  The
+   memory for both is reserved up front and committed as it is first used, so the index
+   only takes what the lines in it need.
+
+   A chunk's lines can only be 2GB apart (LINE_OFFSET_MASK).  ParseLines splits lines at
+   4096 bytes, so only output made of escape sequences megabytes long could get there; lines
+   past that point start at the 2GB mark, which reads back wrong but never out of bounds.
+*/
+
+#define LINE_CHUNK_SIZE 4096
+#define LINE_OFFSET_MASK 0x7fffffff
+#define LINE_COMPLEX_FLAG 0x80000000
+#define LINE_PROPS_SLOT_COUNT 64 // NOTE: Must be a power of two
+
+typedef struct
+{
+    uint32_t Foreground;
+    uint32_t Background;
+    uint32_t Flags;
+} glyph_props;
+
+typedef struct
+{
+    size_t FirstP;
+    size_t OnePastLastP;
+    uint32_t ContainsComplexChars;
+    glyph_props StartingProps;
+} example_line;
+
+typedef struct
+{
+    size_t BaseP; // NOTE: Where the chunk's first line starts
+    size_t FirstProps; // NOTE: Absolute index in the props ring of the first props the chunk added
+    uint32_t Offsets[LINE_CHUNK_SIZE]; // NOTE: FirstP - BaseP, and LINE_COMPLEX_FLAG
+    uint16_t PropsIndices[LINE_CHUNK_SIZE]; // NOTE: From FirstProps
+} line_chunk;
+
+/* NOTE: Everything about the index that isn't in its chunks and props, which is what a
+   scrollback file has to keep alongside them (see scrollback_file_state). */
+typedef struct
+{
+    uint32_t MaxChunkCount;
+    uint32_t MaxPropsCount;
+
+    // NOTE: Lines [FirstLine, OnePastLastLine) are in the index, and the last one is the one
+    // still being parsed.  FirstLine is always the first line of a chunk.
+    size_t FirstLine;
+    size_t OnePastLastLine;
+    size_t CurrentEndP;
+    uint32_t CurrentContainsComplexChars;
+
+    size_t PropsEnd; // NOTE: How many props were ever added
+} line_index_state;
+
+typedef struct
+{
+    line_index_state State;
+
+    line_chunk *Chunks;
+    glyph_props *Props;
+
+    // NOTE: Only when the index reserved its own memory; a scrollback file's is all there already
+    int CommitOnDemand;
+    size_t CommittedChunkSize;
+    size_t CommittedPropsSize;
+
+    // NOTE: The props the current chunk added, by hash, as index from its FirstProps plus one
+    uint16_t PropsSlots[LINE_PROPS_SLOT_COUNT];
+} line_index;
+
+static size_t GetLineIndexMemorySize(uint32_t MaxChunkCount, uint32_t MaxPropsCount);
+static line_index AllocateLineIndex(uint32_t MaxChunkCount, uint32_t MaxPropsCount);
+static void FreeLineIndex(line_index *Index);
+
+/* NOTE: Points Index at Memory (GetLineIndexMemorySize bytes, all usable) holding the index
+   State describes.  If State isn't an index of that size, returns 0 and leaves the index
+   empty, for ResetLineIndex to start over. */
+static int AttachLineIndex(line_index *Index, void *Memory, uint32_t MaxChunkCount, uint32_t MaxPropsCount, line_index_state State);
+
+static void ResetLineIndex(line_index *Index, size_t FirstP, glyph_props StartingProps);
+static void AppendLine(line_index *Index, size_t FirstP, glyph_props StartingProps);
+static void SetCurrentLineEnd(line_index *Index, size_t OnePastLastP);
+static void MarkCurrentLineComplex(line_index *Index, uint32_t ContainsComplexChars);
+
+static size_t GetCurrentLine(line_index *Index);
+static size_t GetLineIndexCount(line_index *Index);
+static size_t GetCurrentLineLength(line_index *Index);
+static example_line GetLine(line_index *Index, size_t Line); // NOTE: An empty line for lines not in the index
@@ -1,5 +1,162 @@
-static source_buffer AllocateSourceBuffer(size_t DataSize)
+static size_t GetSourceBufferFileHeaderSize(size_t ExtraSize, size_t Granularity)
 {
+    size_t Result = (sizeof(source_buffer_file_header) + ExtraSize + Granularity - 1) & ~(Granularity - 1);
+    return Result;
+}
+
+static int IsUsableSourceBufferFile(source_buffer_file_header *Header, uint64_t FileSize, size_t ExtraSize, size_t Granularity)
+{
+    // NOTE: HeaderSize only has to be a multiple of this system's granularity, since the file
+    // may have been made where the granularity is coarser
+    int Result = ((Header->Magic == SOURCE_BUFFER_FILE_MAGIC) &&
+                  (Header->Version == SOURCE_BUFFER_FILE_VERSION) &&
+                  (Header->ExtraSize == ExtraSize) &&
+                  (Header->HeaderSize >= (sizeof(source_buffer_file_header) + ExtraSize)) &&
+                  ((Header->HeaderSize & (Granularity - 1)) == 0) &&
+                  (Header->DataSize > 0) &&
+                  ((Header->DataSize & (Granularity - 1)) == 0) &&
+                  (FileSize == (Header->HeaderSize + Header->DataSize)));
+    return Result;
+}
+
+static source_buffer_file_header MakeSourceBufferFileHeader(size_t DataSize, size_t ExtraSize, size_t Granularity)
+{
+    source_buffer_file_header Result = {0};
+    Result.Magic = SOURCE_BUFFER_FILE_MAGIC;
+    Result.Version = SOURCE_BUFFER_FILE_VERSION;
+    Result.HeaderSize = GetSourceBufferFileHeaderSize(ExtraSize, Granularity);
+    Result.DataSize = (DataSize + Granularity - 1) & ~(Granularity - 1);
+    Result.ExtraSize = ExtraSize;
+    return Result;
+}
+
+static void AttachSourceBufferFile(source_buffer *Buffer, source_buffer_file_header *View, source_buffer_file_header *Header, int Fresh)
+{
+    // NOTE: A new file is all zeroes, so only the header needs writing - the caller's bytes start out zeroed
+    if(Fresh)
+    {
+        *View = *Header;
+    }
+
+    Buffer->File = View;
+    Buffer->AbsoluteFilledSize = View->AbsoluteFilledSize;
+    Buffer->RelativePoint = View->AbsoluteFilledSize % Buffer->DataSize;
+
+    // NOTE: What was in the file already counts as published and consumed
+    Buffer->PublishedFilledSize = Buffer->CachedPublishedSize = View->AbsoluteFilledSize;
+    Buffer->ConsumerP = Buffer->CachedConsumerP = View->AbsoluteFilledSize;
+}
+
+static void SaveSourceBufferFile(source_buffer *Buffer)
+{
+    /* NOTE: This is the only write a file-backed buffer ever needs - the ring and the caller's
+       bytes are already in the file's pages, which the OS writes back on its own schedule (and
+       still does if the process dies).  Until this is called, a reopen comes back at the last
+       saved position, and whatever was written after it is written over again. */
+    if(Buffer->File)
+    {
+        Buffer->File->AbsoluteFilledSize = Buffer->AbsoluteFilledSize;
+    }
+}
+
+static void *GetSourceBufferFileExtra(source_buffer *Buffer)
+{
+    void *Result = Buffer->File ? (Buffer->File + 1) : 0;
+    return Result;
+}
+
+#if _WIN32
+#ifdef MEM_REPLACE_PLACEHOLDER
+static int EnableLockMemoryPrivilege(void)
+{
+    int Result = 0;
+
+    HANDLE Token;
+    if(OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES|TOKEN_QUERY, &Token))
+    {
+        TOKEN_PRIVILEGES Privileges = {0};
+        Privileges.PrivilegeCount = 1;
+        Privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        // NOTE: Not SE_LOCK_MEMORY_NAME, which is TEXT() and so a char string when UNICODE isn't defined
+        if(LookupPrivilegeValueW(0, L"SeLockMemoryPrivilege", &Privileges.Privileges[0].Luid) &&
+           AdjustTokenPrivileges(Token, FALSE, &Privileges, 0, 0, 0))
+        {
+            // NOTE: AdjustTokenPrivileges also "succeeds" when the account was never granted the privilege
+            Result = (GetLastError() == ERROR_SUCCESS);
+        }
+
+        CloseHandle(Token);
+    }
+
+    return Result;
+}
+
+static source_buffer AllocateLargePageSourceBuffer(size_t DataSize)
+{
+    /* NOTE: Large pages on Windows need the "Lock pages in memory" privilege, which accounts
+       don't have unless someone granted it, and enough physically contiguous free memory at
+       the time.  The section is SEC_LARGE_PAGES, the placeholder is aligned to the large page
+       size so both views can be, and the views are mapped with MEM_LARGE_PAGES.  If any of it
+       fails, Data is 0 and AllocateSourceBuffer falls back to ordinary pages. */
+    source_buffer Result = {0};
+
+    size_t LargePageSize = GetLargePageMinimum();
+    if(LargePageSize && EnableLockMemoryPrivilege())
+    {
+        DataSize = (DataSize + LargePageSize - 1) & ~(LargePageSize - 1);
+        HANDLE Section = CreateFileMappingW(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE|SEC_COMMIT|SEC_LARGE_PAGES,
+                                           (DWORD)(DataSize >> 32), (DWORD)(DataSize & 0xffffffff), 0);
+        if(Section)
+        {
+            MEM_ADDRESS_REQUIREMENTS Requirements = {0};
+            Requirements.Alignment = LargePageSize;
+
+            MEM_EXTENDED_PARAMETER Parameter = {0};
+            Parameter.Type = MemExtendedParameterAddressRequirements;
+            Parameter.Pointer = &Requirements;
+
+            char *Placeholder = (char *)VirtualAlloc2(0, 0, 2*DataSize, MEM_RESERVE|MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, &Parameter, 1);
+            if(Placeholder)
+            {
+                VirtualFree(Placeholder, DataSize, MEM_RELEASE|MEM_PRESERVE_PLACEHOLDER);
+
+                void *View1 = MapViewOfFile3(Section, 0, Placeholder, 0, DataSize, MEM_REPLACE_PLACEHOLDER|MEM_LARGE_PAGES, PAGE_READWRITE, 0, 0);
+                void *View2 = MapViewOfFile3(Section, 0, Placeholder + DataSize, 0, DataSize, MEM_REPLACE_PLACEHOLDER|MEM_LARGE_PAGES, PAGE_READWRITE, 0, 0);
+                if(View1 && View2)
+                {
+                    Result.Data = Placeholder;
+                    Result.DataSize = DataSize;
+                    Result.PageSize = LargePageSize;
+                }
+                else
+                {
+                    // NOTE: A half that did map is a view, and a half that didn't is still a placeholder
+                    if(View1) UnmapViewOfFile(View1); else VirtualFree(Placeholder, 0, MEM_RELEASE);
+                    if(View2) UnmapViewOfFile(View2); else VirtualFree(Placeholder + DataSize, 0, MEM_RELEASE);
+                }
+            }
+
+            CloseHandle(Section);
+        }
+    }
+
+    return Result;
+}
+#endif
+
+static source_buffer AllocateRingSourceBuffer(size_t DataSize, int UseHugePages, int ShowErrors)
+{
+#ifdef MEM_REPLACE_PLACEHOLDER
+    if(UseHugePages)
+    {
+        source_buffer Large = AllocateLargePageSourceBuffer(DataSize);
+        if(Large.Data)
+        {
+            return Large;
+        }
+    }
+#endif
+
     source_buffer Result = {0};
 
     SYSTEM_INFO Info;
@@ -24,10 +181,22 @@ static source_buffer AllocateSourceBuffer(size_t DataSize)
     {
         Result.Data = View1;
         Result.DataSize = DataSize;
+        Result.PageSize = Info.dwPageSize;
     }
     else
     {
-        MessageBoxW(0, L"Unable to allocate scrollback buffer with placeholder", L"WARNING", MB_OK);
+        // NOTE: A half that did map is a view, and a half that didn't is still a placeholder -
+        // either way it has to go, or the probing below could run into it
+        if(Placeholder1)
+        {
+            if(View1) UnmapViewOfFile(View1); else VirtualFree(Placeholder1, 0, MEM_RELEASE);
+            if(View2) UnmapViewOfFile(View2); else VirtualFree(Placeholder2, 0, MEM_RELEASE);
+        }
+
+        if(ShowErrors)
+        {
+            MessageBoxW(0, L"Unable to allocate scrollback buffer with placeholder", L"WARNING", MB_OK);
+        }
 #endif
         for(size_t Offset = 0x40000000;
             Offset < 0x400000000;
@@ -41,6 +210,7 @@ static source_buffer AllocateSourceBuffer(size_t DataSize)
             {
                 Result.Data = View1;
                 Result.DataSize = DataSize;
+                Result.PageSize = Info.dwPageSize;
                 break;
             }
 
@@ -48,7 +218,7 @@ static source_buffer AllocateSourceBuffer(size_t DataSize)
             if(View2) UnmapViewOfFile(View2);
         }
 
-        if(!Result.Data)
+        if(!Result.Data && ShowErrors)
         {
             MessageBoxW(0, L"Unable to allocate scrollback buffer with probing", L"Fatal error", MB_OK|MB_ICONSTOP);
         }
@@ -56,9 +226,373 @@ static source_buffer AllocateSourceBuffer(size_t DataSize)
     }
 #endif
 
+    // NOTE: The views keep the section alive, so the handle isn't needed past this point
+    CloseHandle(Section);
+
+    return Result;
+}
+
+static source_buffer AllocateSourceBuffer(size_t DataSize, int UseHugePages)
+{
+    source_buffer Result = AllocateRingSourceBuffer(DataSize, UseHugePages, 1);
+    return Result;
+}
+
+static source_buffer AllocateQuietSourceBuffer(size_t DataSize, int UseHugePages)
+{
+    // NOTE: For buffers the program works fine without (the cold scrollback, or a replacement
+    // for a scrollback it already has), so failing shows nothing, and Data is just 0
+    source_buffer Result = AllocateRingSourceBuffer(DataSize, UseHugePages, 0);
+    return Result;
+}
+
+static void FreeSourceBuffer(source_buffer *Buffer)
+{
+    if(Buffer->Data)
+    {
+        UnmapViewOfFile(Buffer->Data);
+        UnmapViewOfFile(Buffer->Data + Buffer->DataSize);
+    }
+
+    if(Buffer->File)
+    {
+        SaveSourceBufferFile(Buffer);
+        UnmapViewOfFile(Buffer->File);
+        CloseHandle(Buffer->FileHandle);
+    }
+
+    source_buffer Zero = {0};
+    *Buffer = Zero;
+}
+
+static source_buffer MapSourceBufferSection(HANDLE Section, uint64_t Offset, size_t DataSize, size_t PageSize)
+{
+    // NOTE: The same back-to-back views as AllocateSourceBuffer, of part of a file's section
+    source_buffer Result = {0};
+
+#ifdef MEM_REPLACE_PLACEHOLDER
+    char *Placeholder = (char *)VirtualAlloc2(0, 0, 2*DataSize, MEM_RESERVE|MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, 0, 0);
+    if(Placeholder)
+    {
+        VirtualFree(Placeholder, DataSize, MEM_RELEASE|MEM_PRESERVE_PLACEHOLDER);
+
+        void *View1 = MapViewOfFile3(Section, 0, Placeholder, Offset, DataSize, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, 0, 0);
+        void *View2 = MapViewOfFile3(Section, 0, Placeholder + DataSize, Offset, DataSize, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, 0, 0);
+        if(View1 && View2)
+        {
+            Result.Data = Placeholder;
+            Result.DataSize = DataSize;
+            Result.PageSize = PageSize;
+        }
+        else
+        {
+            if(View1) UnmapViewOfFile(View1); else VirtualFree(Placeholder, 0, MEM_RELEASE);
+            if(View2) UnmapViewOfFile(View2); else VirtualFree(Placeholder + DataSize, 0, MEM_RELEASE);
+        }
+    }
+#else
+    for(size_t Address = 0x40000000;
+        Address < 0x400000000;
+        Address += 0x1000000)
+    {
+        void *View1 = (char *)MapViewOfFileEx(Section, FILE_MAP_ALL_ACCESS, (DWORD)(Offset >> 32), (DWORD)(Offset & 0xffffffff),
+                                              DataSize, (void *)Address);
+        void *View2 = MapViewOfFileEx(Section, FILE_MAP_ALL_ACCESS, (DWORD)(Offset >> 32), (DWORD)(Offset & 0xffffffff),
+                                      DataSize, ((char *)View1 + DataSize));
+
+        if(View1 && View2)
+        {
+            Result.Data = View1;
+            Result.DataSize = DataSize;
+            Result.PageSize = PageSize;
+            break;
+        }
+
+        if(View1) UnmapViewOfFile(View1);
+        if(View2) UnmapViewOfFile(View2);
+    }
+#endif
+
     return Result;
 }
 
+static source_buffer AllocateFileSourceBuffer(char *Path, size_t DataSize, size_t ExtraSize)
+{
+    /* NOTE: Backs the ring with the file at Path (UTF-8) instead of anonymous memory, so it can
+       be far bigger than RAM - the OS pages it in and out like any mapped file - and reopening
+       the file gives back the buffer as it was at the last SaveSourceBufferFile.
+
+       A missing or empty file is made DataSize big.  An existing file keeps its own DataSize,
+       but it has to be one of these with the same ExtraSize, or Data is 0 and the file is
+       left alone.  The file is opened without write sharing, so a second refterm can't open
+       the same one while this one has it. */
+    source_buffer Result = {0};
+
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    size_t Granularity = Info.dwAllocationGranularity;
+
+    wchar_t WidePath[MAX_PATH + 1];
+    if(MultiByteToWideChar(CP_UTF8, 0, Path, -1, WidePath, ArrayCount(WidePath)))
+    {
+        HANDLE File = CreateFileW(WidePath, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+        if(File != INVALID_HANDLE_VALUE)
+        {
+            source_buffer_file_header Header = {0};
+            LARGE_INTEGER FileSize = {0};
+            int Fresh = 0;
+            if(GetFileSizeEx(File, &FileSize))
+            {
+                Fresh = (FileSize.QuadPart == 0);
+                if(Fresh)
+                {
+                    Header = MakeSourceBufferFileHeader(DataSize, ExtraSize, Granularity);
+                    FileSize.QuadPart = Header.HeaderSize + Header.DataSize;
+                }
+                else
+                {
+                    DWORD ReadCount = 0;
+                    ReadFile(File, &Header, sizeof(Header), &ReadCount, 0);
+                }
+            }
+
+            if(IsUsableSourceBufferFile(&Header, FileSize.QuadPart, ExtraSize, Granularity))
+            {
+                // NOTE: Making the section grows a new file to FileSize
+                HANDLE Section = CreateFileMappingW(File, 0, PAGE_READWRITE, FileSize.HighPart, FileSize.LowPart, 0);
+                if(Section)
+                {
+                    Result = MapSourceBufferSection(Section, Header.HeaderSize, Header.DataSize, Info.dwPageSize);
+                    if(Result.Data)
+                    {
+                        source_buffer_file_header *View = (source_buffer_file_header *)MapViewOfFile(Section, FILE_MAP_ALL_ACCESS, 0, 0, Header.HeaderSize);
+                        if(View)
+                        {
+                            AttachSourceBufferFile(&Result, View, &Header, Fresh);
+                            Result.FileHandle = File;
+                        }
+                        else
+                        {
+                            FreeSourceBuffer(&Result);
+                        }
+                    }
+
+                    CloseHandle(Section);
+                }
+
+                if(Fresh && !Result.Data)
+                {
+                    // NOTE: Back to empty, so it is still a new file the next time, not a broken one
+                    LARGE_INTEGER Zero = {0};
+                    SetFilePointerEx(File, Zero, 0, FILE_BEGIN);
+                    SetEndOfFile(File);
+                }
+            }
+
+            if(!Result.Data)
+            {
+                CloseHandle(File);
+            }
+        }
+    }
+
+    return Result;
+}
+#else
+#ifndef MFD_HUGE_2MB
+#define MFD_HUGE_2MB (21 << 26) // NOTE: Page size log2 in the top bits, from linux/memfd.h
+#endif
+#define SOURCE_BUFFER_HUGE_PAGE_SIZE (2*1024*1024)
+
+static source_buffer MapSourceBufferFile(int File, off_t Offset, size_t DataSize, size_t Alignment)
+{
+    /* NOTE: Maps DataSize bytes of File at Offset twice, MAP_FIXED, over the two halves of one
+       PROT_NONE reservation - so, like the placeholder path on Windows, nothing else can grab
+       the second half in between, and there's no address probing.  The reservation is
+       over-allocated by Alignment and trimmed, so both views start on an Alignment boundary
+       (huge pages have to).  File can be closed as soon as both views exist. */
+    source_buffer Result = {0};
+
+    size_t ReserveSize = 2*DataSize + Alignment;
+    char *Reserve = (char *)mmap(0, ReserveSize, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if(Reserve != MAP_FAILED)
+    {
+        char *Base = (char *)(((size_t)Reserve + Alignment - 1) & ~(Alignment - 1));
+        if(Base > Reserve)
+        {
+            munmap(Reserve, Base - Reserve);
+        }
+        if(Base + 2*DataSize < Reserve + ReserveSize)
+        {
+            munmap(Base + 2*DataSize, (Reserve + ReserveSize) - (Base + 2*DataSize));
+        }
+
+        void *View1 = mmap(Base, DataSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, File, Offset);
+        void *View2 = mmap(Base + DataSize, DataSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, File, Offset);
+        if((View1 == Base) && (View2 == Base + DataSize))
+        {
+            Result.Data = Base;
+            Result.DataSize = DataSize;
+            Result.PageSize = Alignment;
+        }
+        else
+        {
+            // NOTE: Either view that did map replaced part of the reservation, so this unmaps everything
+            munmap(Base, 2*DataSize);
+        }
+    }
+
+    return Result;
+}
+
+static source_buffer MapSourceBufferMemFD(unsigned int Flags, size_t DataSize, size_t Alignment)
+{
+    // NOTE: A memfd is an anonymous file that only exists while something maps it
+    source_buffer Result = {0};
+
+    int File = memfd_create("refterm_scrollback", MFD_CLOEXEC|Flags);
+    if(File >= 0)
+    {
+        if(ftruncate(File, (off_t)DataSize) == 0)
+        {
+            Result = MapSourceBufferFile(File, 0, DataSize, Alignment);
+        }
+
+        close(File);
+    }
+
+    return Result;
+}
+
+static source_buffer AllocateSourceBuffer(size_t DataSize, int UseHugePages)
+{
+    /* NOTE: The same back-to-back mapping on Linux, of a memfd.  On failure Data is 0, and it's up to the caller to
+       report it.
+
+       With UseHugePages, it first tries a hugetlbfs memfd of 2MB pages.  Those come out of
+       the pool reserved in /proc/sys/vm/nr_hugepages, which is empty unless someone filled
+       it; a shared hugetlb mapping reserves its pages when it is mapped, so an empty pool
+       fails here instead of with a SIGBUS later.  Failing that, it uses an ordinary memfd
+       with the size and both views 2MB-aligned and asks for transparent huge pages with
+       madvise - which shmem only honors if /sys/kernel/mm/transparent_hugepage/shmem_enabled
+       allows it, so PageSize stays at the small page size, since there's no promise. */
+    source_buffer Result = {0};
+
+    size_t PageSize = (size_t)sysconf(_SC_PAGESIZE);
+    Assert(IsPowerOfTwo(PageSize));
+
+    if(UseHugePages)
+    {
+        size_t HugeDataSize = (DataSize + SOURCE_BUFFER_HUGE_PAGE_SIZE - 1) & ~(size_t)(SOURCE_BUFFER_HUGE_PAGE_SIZE - 1);
+        Result = MapSourceBufferMemFD(MFD_HUGETLB|MFD_HUGE_2MB, HugeDataSize, SOURCE_BUFFER_HUGE_PAGE_SIZE);
+        if(!Result.Data)
+        {
+            Result = MapSourceBufferMemFD(0, HugeDataSize, SOURCE_BUFFER_HUGE_PAGE_SIZE);
+            if(Result.Data)
+            {
+                madvise(Result.Data, 2*Result.DataSize, MADV_HUGEPAGE);
+                Result.PageSize = PageSize;
+            }
+        }
+    }
+
+    if(!Result.Data)
+    {
+        DataSize = (DataSize + PageSize - 1) & ~(PageSize - 1);
+        Result = MapSourceBufferMemFD(0, DataSize, PageSize);
+    }
+
+    return Result;
+}
+
+static source_buffer AllocateQuietSourceBuffer(size_t DataSize, int UseHugePages)
+{
+    // NOTE: Nothing here ever reports a failure, so this is the same as AllocateSourceBuffer
+    source_buffer Result = AllocateSourceBuffer(DataSize, UseHugePages);
+    return Result;
+}
+
+static void FreeSourceBuffer(source_buffer *Buffer)
+{
+    if(Buffer->Data)
+    {
+        munmap(Buffer->Data, 2*Buffer->DataSize);
+    }
+
+    if(Buffer->File)
+    {
+        SaveSourceBufferFile(Buffer);
+        munmap(Buffer->File, Buffer->File->HeaderSize);
+    }
+
+    source_buffer Zero = {0};
+    *Buffer = Zero;
+}
+
+static source_buffer AllocateFileSourceBuffer(char *Path, size_t DataSize, size_t ExtraSize)
+{
+    /* NOTE: The file-backed ring on Linux (see the Windows version for what it does).  Instead of
+       a sharing mode, the file gets an flock, which the mappings hold on to after the
+       descriptor is closed, so a second refterm can't open the same file while this one has it. */
+    source_buffer Result = {0};
+
+    size_t Granularity = (size_t)sysconf(_SC_PAGESIZE);
+
+    int File = open(Path, O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+    if(File >= 0)
+    {
+        struct stat Stat;
+        if((flock(File, LOCK_EX|LOCK_NB) == 0) &&
+           (fstat(File, &Stat) == 0))
+        {
+            source_buffer_file_header Header = {0};
+            uint64_t FileSize = (uint64_t)Stat.st_size;
+            int Fresh = (FileSize == 0);
+            if(Fresh)
+            {
+                Header = MakeSourceBufferFileHeader(DataSize, ExtraSize, Granularity);
+                FileSize = Header.HeaderSize + Header.DataSize;
+                if(ftruncate(File, (off_t)FileSize) != 0)
+                {
+                    Header.Magic = 0;
+                }
+            }
+            else if(pread(File, &Header, sizeof(Header), 0) != sizeof(Header))
+            {
+                Header.Magic = 0;
+            }
+
+            if(IsUsableSourceBufferFile(&Header, FileSize, ExtraSize, Granularity))
+            {
+                Result = MapSourceBufferFile(File, (off_t)Header.HeaderSize, Header.DataSize, Granularity);
+                if(Result.Data)
+                {
+                    void *View = mmap(0, Header.HeaderSize, PROT_READ|PROT_WRITE, MAP_SHARED, File, 0);
+                    if(View != MAP_FAILED)
+                    {
+                        AttachSourceBufferFile(&Result, (source_buffer_file_header *)View, &Header, Fresh);
+                    }
+                    else
+                    {
+                        FreeSourceBuffer(&Result);
+                    }
+                }
+            }
+
+            if(Fresh && !Result.Data)
+            {
+                // NOTE: Back to empty, so it is still a new file the next time, not a broken one
+                ftruncate(File, 0);
+            }
+        }
+
+        close(File);
+    }
+
+    return Result;
+}
+#endif
+
 static int IsInBuffer(source_buffer *Buffer, size_t AbsoluteP)
 {
     size_t BackwardOffset = Buffer->AbsoluteFilledSize - AbsoluteP;
@@ -139,6 +673,20 @@ static source_buffer_range GetNextWritableRange(source_buffer *Buffer, size_t Ma
     return Result;
 }
 
+static size_t GetWritableCountBefore(source_buffer *Buffer, size_t OldestNeededP)
+{
+    /* NOTE: How much can be committed without writing over OldestNeededP, for callers that pass
+       it to GetNextWritableRange to hold back from bytes something still reads.  A position that
+       is already gone (or not written yet) holds nothing back. */
+    size_t Result = Buffer->DataSize;
+    if(IsInBuffer(Buffer, OldestNeededP))
+    {
+        Result = (Buffer->DataSize - 1) - (Buffer->AbsoluteFilledSize - OldestNeededP);
+    }
+
+    return Result;
+}
+
 static void CommitWrite(source_buffer *Buffer, size_t Size)
 {
     Assert(Buffer->RelativePoint < Buffer->DataSize);
@@ -153,102 +701,105 @@ static void CommitWrite(source_buffer *Buffer, size_t Size)
     Assert(Buffer->RelativePoint < Buffer->DataSize);
 }
 
-static char unsigned OverhangMask[32] =
-{
-    255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,
-    0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0
-};
-static char unsigned DefaultSeed[16] =
-{
-    178, 201, 95, 240, 40, 41, 143, 216,
-    2, 209, 178, 114, 232, 4, 176, 188
-};
-static char unsigned ShuffleTable[32] =
+static size_t SourceBufferLoadAcquire(size_t volatile *Source)
 {
-  0, 1, 2, 3,  4, 5, 6, 7,  8, 9, 10, 11,  12, 13, 14, 15,
-  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF
-};
-static glyph_hash ComputeGlyphHash(size_t Count, char unsigned *At, char unsigned *Seedx16)
+#if _MSC_VER
+    // NOTE: An x64 load already has acquire semantics, so this only has to keep the compiler from moving later loads above it
+    size_t Result = *Source;
+    _ReadWriteBarrier();
+#else
+    size_t Result = __atomic_load_n(Source, __ATOMIC_ACQUIRE);
+#endif
+    return Result;
+}
+
+static void SourceBufferStoreRelease(size_t volatile *Dest, size_t Value)
 {
-    /* TODO(casey):
+#if _MSC_VER
+    // NOTE: Likewise, an x64 store already has release semantics
+    _ReadWriteBarrier();
+    *Dest = Value;
+#else
+    __atomic_store_n(Dest, Value, __ATOMIC_RELEASE);
+#endif
+}
 
-      Consider and test some alternate hash designs.  The hash here
-      was the simplest thing to type in, but it is not necessarily
-      the best hash for the job.  It may be that less AES rounds
-      would produce equivalently collision-free results for the
-      problem space.  It may be that non-AES hashing would be
-      better.  Some careful analysis would be nice.
-    */
+/* NOTE: The single-producer/single-consumer protocol, for filling the buffer on one thread
+   (say, a thread that does nothing but read the child's pipe) while another parses what has
+   come in.
+
+   The producer calls GetProducerWritableRange, fills what it gets, and PublishWrite makes it
+   visible: the bytes are written before PublishedFilledSize is stored with release, and the
+   consumer loads it with acquire before reading them.  The consumer calls GetPublishedRange
+   for what has come in from any position at or after ConsumerP, and ReleaseConsumed when it
+   is done with bytes, which the producer may then write over.  The producer never has more
+   than DataSize - 1 bytes past ConsumerP (what IsInBuffer can hold), so a writable range can
+   come back short, or empty, when the consumer falls behind - the producer decides whether
+   to wait for it.
+
+   Each side keeps its last look at the other's position and only loads it again when that
+   runs out, so a stream of small writes doesn't keep bouncing both cache lines between cores.
+
+   These don't mix with GetNextWritableRange/CommitWrite on the same buffer - those never
+   look at ConsumerP - and ReadSourceAt and IsInBuffer read the producer's fields, so they are
+   only for the producer's thread, or for when nothing else is writing. */
+static source_buffer_range GetProducerWritableRange(source_buffer *Buffer, size_t MaxCount)
+{
+    size_t Limit = Buffer->CachedConsumerP + (Buffer->DataSize - 1);
+    if((Limit - Buffer->AbsoluteFilledSize) < MaxCount)
+    {
+        Buffer->CachedConsumerP = SourceBufferLoadAcquire(&Buffer->ConsumerP);
+        Limit = Buffer->CachedConsumerP + (Buffer->DataSize - 1);
+    }
 
-    // TODO(casey): Does the result of a grapheme composition
-    // depend on whether or not it was RTL or LTR?  Or are there
-    // no fonts that ever get used in both directions, so it doesn't
-    // matter?
+    source_buffer_range Result = GetNextWritableRange(Buffer, Limit - Buffer->AbsoluteFilledSize);
+    if(Result.Count > MaxCount)
+    {
+        Result.Count = MaxCount;
+    }
 
-    // TODO(casey): Double-check exactly the pattern
-    // we want to use for the hash here
+    return Result;
+}
 
-    glyph_hash Result = {0};
+static void PublishWrite(source_buffer *Buffer, size_t Size)
+{
+    CommitWrite(Buffer, Size);
+    SourceBufferStoreRelease(&Buffer->PublishedFilledSize, Buffer->AbsoluteFilledSize);
+}
 
-    // TODO(casey): Should there be an IV?
-    __m128i HashValue = _mm_cvtsi64_si128(Count);
-    HashValue = _mm_xor_si128(HashValue, _mm_loadu_si128((__m128i *)Seedx16));
+static source_buffer_range GetPublishedRange(source_buffer *Buffer, size_t AbsoluteP, size_t MaxCount)
+{
+    Assert(AbsoluteP >= Buffer->ConsumerP);
 
-    size_t ChunkCount = Count / 16;
-    while(ChunkCount--)
+    if(Buffer->CachedPublishedSize <= AbsoluteP)
     {
-        __m128i In = _mm_loadu_si128((__m128i *)At);
-        At += 16;
-
-        HashValue = _mm_xor_si128(HashValue, In);
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        Buffer->CachedPublishedSize = SourceBufferLoadAcquire(&Buffer->PublishedFilledSize);
     }
 
-    size_t Overhang = Count % 16;
-    if(Overhang)
+    source_buffer_range Result = {0};
+    Result.AbsoluteP = AbsoluteP;
+    if(AbsoluteP < Buffer->CachedPublishedSize)
     {
-        size_t Overread = 16 - Overhang;
-    
-        size_t OverhangMaskOffset = 16 - Overhang;
-        size_t ShuffleTableOffset = 0;
-    
-        if(((uintptr_t)At ^ ((uintptr_t)At + 16)) & 4096) {
-          // The final read would cross a page boundary.
-          // Offset it so it doesn't.
-          At -= Overread;
-          OverhangMaskOffset = 0;
-          ShuffleTableOffset = Overread;
+        // NOTE: Never more than DataSize - 1 bytes, so this is one contiguous range thanks to the second view
+        Result.Count = Buffer->CachedPublishedSize - AbsoluteP;
+        Result.Data = Buffer->Data + (AbsoluteP % Buffer->DataSize);
+        if(Result.Count > MaxCount)
+        {
+            Result.Count = MaxCount;
         }
-    
-        __m128i In = _mm_loadu_si128((__m128i *)At);
-        In = _mm_shuffle_epi8(_mm_and_si128(In, _mm_loadu_si128((__m128i *)(OverhangMask + OverhangMaskOffset))), _mm_loadu_si128((__m128i *)(ShuffleTable + ShuffleTableOffset)));
-        HashValue = _mm_xor_si128(HashValue, In);
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
     }
 
-    Result.Value = HashValue;
-
     return Result;
 }
 
-static glyph_hash ComputeHashForTileIndex(glyph_hash Tile0Hash, uint32_t TileIndex)
+static void ReleaseConsumed(source_buffer *Buffer, size_t ToAbsoluteP)
 {
-    __m128i HashValue = Tile0Hash.Value;
-    if(TileIndex)
-    {
-        HashValue = _mm_xor_si128(HashValue, _mm_set1_epi32(TileIndex));
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
-    }
-
-    glyph_hash Result = {HashValue};
-    return Result;
+    Assert(ToAbsoluteP >= Buffer->ConsumerP);
+    SourceBufferStoreRelease(&Buffer->ConsumerP, ToAbsoluteP);
 }
+
+static char unsigned OverhangMask[32] =
+{
+    255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,
+    0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0
+};
@@ -5,15 +5,49 @@ typedef struct
     char *Data;
 } source_buffer_range;
 
+/* NOTE: A file-backed source_buffer (see AllocateFileSourceBuffer) starts with this header,
+   then the caller's ExtraSize bytes, then padding up to HeaderSize, which is where the ring
+   itself starts.  The caller's bytes are mapped along with the header, so anything the
+   caller keeps there is saved by the OS along with the output, without any writes. */
+#define SOURCE_BUFFER_FILE_MAGIC 0x42535452 // NOTE: "RTSB"
+#define SOURCE_BUFFER_FILE_VERSION 1
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t HeaderSize; // NOTE: Where the ring starts in the file, a multiple of the mapping granularity
+    uint64_t DataSize;
+    uint64_t ExtraSize;
+    uint64_t AbsoluteFilledSize; // NOTE: Only as current as the last SaveSourceBufferFile
+} source_buffer_file_header;
+
 typedef struct 
 {
     size_t DataSize;
     char *Data;
+    size_t PageSize; // NOTE: The page size the buffer is known to be on, so 2MB only when huge pages were actually granted
+    source_buffer_file_header *File; // NOTE: The mapped header of a file-backed buffer, 0 for anonymous memory
+#if _WIN32
+    HANDLE FileHandle; // NOTE: Held open only so its sharing mode keeps anyone else from writing the file
+#endif
 
     // NOTE(casey): For circular buffer
     size_t RelativePoint;
     
     // NOTE(casey): For cache checking
     size_t AbsoluteFilledSize;
+
+    /* NOTE: For the single-producer/single-consumer calls (see PublishWrite).  The producer
+       owns everything above, and PublishedFilledSize is how far of it the consumer may read.
+       The consumer owns ConsumerP, which the producer never writes over, on a cache line of
+       its own so each side's own writes don't keep taking the other side's line away. */
+    size_t volatile PublishedFilledSize;
+    size_t CachedConsumerP; // NOTE: The producer's last look at ConsumerP
+    char unsigned ProducerPad[64];
+
+    size_t volatile ConsumerP;
+    size_t CachedPublishedSize; // NOTE: The consumer's last look at PublishedFilledSize
+    char unsigned ConsumerPad[64];
 } source_buffer;
 
@@ -33,28 +33,14 @@ static DWORD GetPipePendingDataCount(HANDLE Pipe)
 
 static void UpdateLineEnd(example_terminal *Terminal, size_t ToP)
 {
-    Terminal->Lines[Terminal->CurrentLineIndex].OnePastLastP = ToP;
+    SetCurrentLineEnd(&Terminal->Lines, ToP);
 }
 
-static void LineFeed(example_terminal *Terminal, size_t AtP, size_t NextLineStart, glyph_props AtProps)
+static void LineFeed(example_terminal *Terminal, size_t AtP, glyph_props AtProps)
 {
+    // NOTE: The line index ends every line where the next one starts, so AtP is both
     UpdateLineEnd(Terminal, AtP);
-    ++Terminal->CurrentLineIndex;
-    if(Terminal->CurrentLineIndex >= Terminal->MaxLineCount)
-    {
-        Terminal->CurrentLineIndex = 0;
-    }
-
-    example_line *Line = Terminal->Lines + Terminal->CurrentLineIndex;
-    Line->FirstP = NextLineStart;
-    Line->OnePastLastP = NextLineStart;
-    Line->ContainsComplexChars = 0;
-    Line->StartingProps = AtProps;
-
-    if(Terminal->LineCount <= Terminal->CurrentLineIndex)
-    {
-        Terminal->LineCount = Terminal->CurrentLineIndex + 1;
-    }
+    AppendLine(&Terminal->Lines, AtP, AtProps);
 }
 
 static int IsInBounds(terminal_buffer *Buffer, terminal_point Point)
@@ -282,13 +268,6 @@ static int ParseEscape(example_terminal *Terminal, source_buffer_range *Range, c
     return MovedCursor;
 }
 
-static size_t GetLineLength(example_line *Line)
-{
-    Assert(Line->OnePastLastP >= Line->FirstP);
-    size_t Result = Line->OnePastLastP - Line->FirstP;
-    return Result;
-}
-
 static void ParseLines(example_terminal *Terminal, source_buffer_range Range, cursor_state *Cursor)
 {
     /* TODO(casey): Currently, if the commit of line data _straddles_ a control code boundary
@@ -337,15 +316,14 @@ static void ParseLines(example_terminal *Terminal, source_buffer_range Range, cu
 
         Range = ConsumeCount(Range, Data - Range.Data);
 
-        Terminal->Lines[Terminal->CurrentLineIndex].ContainsComplexChars |=
-            _mm_movemask_epi8(ContainsComplex);
+        MarkCurrentLineComplex(&Terminal->Lines, _mm_movemask_epi8(ContainsComplex));
 
         if(AtEscape(&Range))
         {
             size_t FeedAt = Range.AbsoluteP;
             if(ParseEscape(Terminal, &Range, Cursor))
             {
-                LineFeed(Terminal, FeedAt, FeedAt, Cursor->Props);
+                LineFeed(Terminal, FeedAt, Cursor->Props);
             }
         }
         else
@@ -353,18 +331,18 @@ static void ParseLines(example_terminal *Terminal, source_buffer_range Range, cu
             char Token = GetToken(&Range);
             if(Token == '\n')
             {
-                LineFeed(Terminal, Range.AbsoluteP, Range.AbsoluteP, Cursor->Props);
+                LineFeed(Terminal, Range.AbsoluteP, Cursor->Props);
             }
             else if(Token < 0) // TODO(casey): Not sure what is a "combining char" here, really, but this is a rough test
             {
-                Terminal->Lines[Terminal->CurrentLineIndex].ContainsComplexChars = 1;
+                MarkCurrentLineComplex(&Terminal->Lines, 1);
             }
         }
 
         UpdateLineEnd(Terminal, Range.AbsoluteP);
-        if(GetLineLength(&Terminal->Lines[Terminal->CurrentLineIndex]) > SplitLineAtCount)
+        if(GetCurrentLineLength(&Terminal->Lines) > SplitLineAtCount)
         {
-            LineFeed(Terminal, Range.AbsoluteP, Range.AbsoluteP, Cursor->Props);
+            LineFeed(Terminal, Range.AbsoluteP, Cursor->Props);
         }
     }
 }
@@ -389,6 +367,185 @@ static void WriteDebugLog(const char *format, ...)
     }
 }
 
+static uint32_t ConvertGlyphRunToUTF16(example_terminal *Terminal, glyph_run_batch *Batch, glyph_run *Run)
+{
+    // NOTE: Only a run DirectWrite has to size or rasterize ever needs its UTF-16, so this is
+    // called on a miss, never on a hit.  If it fails, the run comes out zero tiles wide.
+    DWORD Result = MultiByteToWideChar(CP_UTF8, 0, Run->UTF8, (DWORD)Run->UTF8Count, Batch->UTF16, ArrayCount(Batch->UTF16));
+    
+    if (Terminal->DebugHighlighting)
+    {
+        AppendOutput(Terminal, "[CONV] UTF-8 to UTF-16: %u bytes -> %u UTF-16 units\n", Run->UTF8Count, Result);
+        if (Result == 0)
+        {
+            DWORD Error = GetLastError();
+            AppendOutput(Terminal, "[CONV] ERROR: Conversion failed with error %u\n", Error);
+        }
+    }
+    
+    return Result;
+}
+
+static int DecodeDirectCodepoint(char *UTF8, size_t Count, uint32_t *Codepoint)
+{
+    /* NOTE: Whether UTF8 is exactly one BMP codepoint that the codepoint page table can stand
+       for.  kbts_DecodeUtf8 takes overlong forms, which hash differently from the shortest one
+       but decode to the same codepoint, so only the codepoint's own encoding counts (and never
+       a surrogate) - otherwise the same bytes would draw differently depending on whether the
+       codepoint happened to be mapped. */
+    kbts_decode Decode = kbts_DecodeUtf8(UTF8, Count);
+    uint32_t EncodedCount = (Decode.Codepoint < 0x80) ? 1 : (Decode.Codepoint < 0x800) ? 2 : 3;
+    int Result = (Decode.Valid && (Decode.SourceCharactersConsumed == Count) && (Decode.Codepoint <= 0xFFFF) &&
+                  (EncodedCount == Count) && ((Decode.Codepoint < 0xD800) || (Decode.Codepoint > 0xDFFF)));
+    *Codepoint = Decode.Codepoint;
+    return Result;
+}
+
+static void FlushGlyphRunBatch(example_terminal *Terminal, glyph_run_batch *Batch, cursor_state *Cursor)
+{
+    ComputeGlyphHashes(Batch->HashCount, Batch->HashInputs, GetGlyphTableSeed(Terminal->GlyphTable), Batch->Hashes);
+
+    // NOTE: The tile 0 hash of a run is the run hash itself, so the batch lookup
+    // is both the sizing lookup and the first tile's lookup.
+    FindGlyphEntriesByHashBatch(Terminal->GlyphTable, Batch->HashCount, Batch->Hashes, Batch->States);
+    
+    for (uint32_t RunIndex = 0; RunIndex < Batch->RunCount; ++RunIndex)
+    {
+        glyph_run *Run = Batch->Runs + RunIndex;
+        if (Run->UTF8Count == 0)
+        {
+            renderer_cell *Cell = GetCell(&Terminal->ScreenBuffer, Cursor->At);
+            if (Cell)
+            {
+                glyph_props Props = Cursor->Props;
+                if (Terminal->DebugHighlighting)
+                {
+                    Props.Background = 0x00800000;
+                }
+                SetCellDirect(Run->DirectIndex, Props, Cell);
+            }
+            AdvanceColumn(Terminal, &Cursor->At);
+        }
+        else
+        {
+            int Prepped = 0;
+            int Converted = 0;
+            wchar_t *UTF16Buffer = Batch->UTF16;
+            uint32_t UTF16Count = 0;
+            glyph_hash RunHash = Batch->Hashes[Run->HashIndex];
+            glyph_state RunEntry = Batch->States[Run->HashIndex];
+            if (RunEntry.FilledState == GlyphState_None)
+            {
+                UTF16Count = ConvertGlyphRunToUTF16(Terminal, Batch, Run);
+                Converted = 1;
+            }
+            glyph_dim GlyphDim = GetGlyphDimForEntry(&Terminal->GlyphGen, Terminal->GlyphTable, &RunEntry, UTF16Count, UTF16Buffer);
+            
+            // NOTE: Once a glyph turns out to be wide, move it into a span, so from then on it is
+            // a single entry with all its tiles side by side
+            if ((GlyphDim.TileCount > 1) && (RunEntry.TileSpan < GlyphDim.TileCount))
+            {
+                glyph_state Span = FindGlyphSpanByHash(Terminal->GlyphTable, RunHash, GlyphDim.TileCount);
+                if (Span.TileSpan >= GlyphDim.TileCount)
+                {
+                    UpdateGlyphCacheEntry(Terminal->GlyphTable, Span.ID, GlyphState_Sized, RunEntry.DimX, RunEntry.DimY);
+                    Span.FilledState = GlyphState_Sized;
+                    Span.DimX = RunEntry.DimX;
+                    Span.DimY = RunEntry.DimY;
+                    
+                    // NOTE: The entry the span replaced is gone, so later runs of the same glyph in this batch have to use the span
+                    for (uint32_t HashIndex = Run->HashIndex + 1; HashIndex < Batch->HashCount; ++HashIndex)
+                    {
+                        if (RunEntry.ID && (Batch->States[HashIndex].ID == RunEntry.ID))
+                        {
+                            Batch->States[HashIndex] = Span;
+                        }
+                    }
+                    
+                    RunEntry = Span;
+                }
+            }
+            
+            int UseSpan = (RunEntry.TileSpan >= GlyphDim.TileCount);
+            for (uint32_t TileIndex = 0; TileIndex < GlyphDim.TileCount; ++TileIndex)
+            {
+                renderer_cell *Cell = GetCell(&Terminal->ScreenBuffer, Cursor->At);
+                if (Cell)
+                {
+                    glyph_state Entry = RunEntry;
+                    if (UseSpan)
+                    {
+                        // NOTE: The tiles are side by side, so the whole glyph goes in with one copy
+                        if (RunEntry.FilledState != GlyphState_Rasterized)
+                        {
+                            if (!Converted)
+                            {
+                                UTF16Count = ConvertGlyphRunToUTF16(Terminal, Batch, Run);
+                                Converted = 1;
+                            }
+                            PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, UTF16Count, UTF16Buffer, GlyphDim);
+                            TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, GlyphDim.TileCount, RunEntry.GPUIndex);
+                            UpdateGlyphCacheEntry(Terminal->GlyphTable, RunEntry.ID, GlyphState_Rasterized, RunEntry.DimX, RunEntry.DimY);
+                            RunEntry.FilledState = GlyphState_Rasterized;
+                        }
+                        
+                        Entry.GPUIndex = GetGlyphSpanTile(RunEntry, TileIndex);
+                    }
+                    else
+                    {
+                        // NOTE: Too wide for any span (or the spans are all in use), so every tile is its own entry
+                        if (TileIndex)
+                        {
+                            glyph_hash TileHash = ComputeHashForTileIndex(RunHash, TileIndex);
+                            Entry = FindGlyphEntryByHash(Terminal->GlyphTable, TileHash);
+                        }
+                        
+                        // NOTE: On an atlas overflow, Entry.GPUIndex is the empty tile 0, which must not be overwritten
+                        if (!IsGlyphAtlasOverflow(Entry) && (Entry.FilledState != GlyphState_Rasterized))
+                        {
+                            if (!Prepped)
+                            {
+                                if (!Converted)
+                                {
+                                    UTF16Count = ConvertGlyphRunToUTF16(Terminal, Batch, Run);
+                                    Converted = 1;
+                                }
+                                PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, UTF16Count, UTF16Buffer, GlyphDim);
+                                Prepped = 1;
+                            }
+                            
+                            TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, TileIndex, 1, Entry.GPUIndex);
+                            UpdateGlyphCacheEntry(Terminal->GlyphTable, Entry.ID, GlyphState_Rasterized, Entry.DimX, Entry.DimY);
+                        }
+                    }
+                    
+                    glyph_props Props = Cursor->Props;
+                    if (Terminal->DebugHighlighting)
+                    {
+                        Props.Background = Batch->DebugToggle ? 0x0008080 : 0x00000080;
+                        Batch->DebugToggle = !Batch->DebugToggle;
+                    }
+                    SetCellDirect(Entry.GPUIndex, Props, Cell);
+                }
+                
+                AdvanceColumn(Terminal, &Cursor->At);
+            }
+            
+            // NOTE: A lone BMP codepoint that fits in one tile can skip hashing from now on (see ParseWithKB).
+            // It is decoded from the UTF-8 here, since on a hit there is no UTF-16.
+            uint32_t Codepoint;
+            if ((GlyphDim.TileCount == 1) && (RunEntry.TileSpan == 1) && !IsGlyphAtlasOverflow(RunEntry) &&
+                DecodeDirectCodepoint(Run->UTF8, Run->UTF8Count, &Codepoint))
+            {
+                MapGlyphCodepoint(Terminal->GlyphTable, Codepoint, RunEntry.ID);
+            }
+        }
+    }
+    
+    Batch->RunCount = 0;
+    Batch->HashCount = 0;
+}
+
 static void ParseWithKB(example_terminal *Terminal, source_buffer_range UTF8Range, cursor_state *Cursor)
 {
     kb_partitioner *KBPartitioner = &Terminal->KBPartitioner;
@@ -657,7 +814,41 @@ static void ParseWithKB(example_terminal *Terminal, source_buffer_range UTF8Rang
         }
     }
     
-    int Segment = 0;
+    // NOTE: Map every segment boundary to its byte offset in one pass over the UTF-8,
+    // rather than re-decoding from the start of the range for every segment
+    {
+        uint32_t BoundaryIndex = 0;
+        uint32_t CodepointCount = 0;
+        size_t ByteOffset = 0;
+        for(;;)
+        {
+            while ((BoundaryIndex < KBPartitioner->SegmentCount) &&
+                   (KBPartitioner->SegP[BoundaryIndex] <= CodepointCount))
+            {
+                KBPartitioner->SegByte[BoundaryIndex++] = ByteOffset;
+            }
+            
+            if ((BoundaryIndex >= KBPartitioner->SegmentCount) || (ByteOffset >= UTF8Range.Count))
+            {
+                break;
+            }
+            
+            kbts_decode Decode = kbts_DecodeUtf8(UTF8Range.Data + ByteOffset, UTF8Range.Count - ByteOffset);
+            ByteOffset += Decode.SourceCharactersConsumed;
+            if (Decode.Valid)
+                CodepointCount++;
+        }
+        
+        while (BoundaryIndex < KBPartitioner->SegmentCount)
+        {
+            KBPartitioner->SegByte[BoundaryIndex++] = ByteOffset;
+        }
+    }
+    
+    glyph_run_batch *Batch = &Terminal->RunBatch;
+    Batch->RunCount = 0;
+    Batch->HashCount = 0;
+    Batch->DebugToggle = 0;
     
     // RTL Support: When RTL is detected, reverse the segment processing order
     // This follows the original buffer run logic
@@ -707,134 +898,64 @@ static void ParseWithKB(example_terminal *Terminal, source_buffer_range UTF8Rang
         
         if (SegmentLength > 0)
         {
-            // Complex Script Detection: Use kbts_ScriptIsComplex() to detect complex scripts
-            // and apply different break strategies for complex vs simple scripts
-            int IsComplex = 0;
+            size_t UTF8Start = KBPartitioner->SegByte[SegIndex];
+            size_t UTF8End = KBPartitioner->SegByte[SegIndex + 1];
             
-            // Use proper script complexity detection instead of heuristic
-            if (CurrentScript != KBTS_SCRIPT_DONT_KNOW)
-            {
-                IsComplex = kbts_ScriptIsComplex(CurrentScript);
-            }
-            else
+            // NOTE: Invalid bytes at the boundary belong to neither segment
+            while (UTF8Start < UTF8End)
             {
-                // Fallback for unknown scripts - check if RTL or multi-codepoint
-                IsComplex = (HasRTL || SegmentLength > 1);
-            }
-            
-            size_t UTF8Start = 0;
-            size_t UTF8End = 0;
-            uint32_t CodepointCount = 0;
-            size_t ByteOffset = 0;
-            while (ByteOffset < UTF8Range.Count && CodepointCount <= End)
-            {
-                if (CodepointCount == Start)
-                    UTF8Start = ByteOffset;
-                if (CodepointCount == End)
-                {
-                    UTF8End = ByteOffset;
-                    break;
-                }
-                
-                kbts_decode Decode = kbts_DecodeUtf8(UTF8Range.Data + ByteOffset, UTF8Range.Count - ByteOffset);
-                ByteOffset += Decode.SourceCharactersConsumed;
+                kbts_decode Decode = kbts_DecodeUtf8(UTF8Range.Data + UTF8Start, UTF8End - UTF8Start);
                 if (Decode.Valid)
-                    CodepointCount++;
+                    break;
+                UTF8Start += Decode.SourceCharactersConsumed;
             }
             
-            if (CodepointCount == End)
-                UTF8End = ByteOffset;
-            
             size_t UTF8SegmentLength = UTF8End - UTF8Start;
             
             if (UTF8SegmentLength > 0)
             {
                 char *UTF8Segment = UTF8Range.Data + UTF8Start;
                 
-                int IsAllDirect = 1;
-                size_t CheckOffset = 0;
-                uint32_t DirectCodepoint = 0;
-                
-                if (UTF8SegmentLength == 1 && UTF8Segment[0] >= MinDirectCodepoint && UTF8Segment[0] <= MaxDirectCodepoint)
+                if (Batch->RunCount == MaxGlyphRunBatch)
                 {
-                    DirectCodepoint = UTF8Segment[0];
+                    FlushGlyphRunBatch(Terminal, Batch, Cursor);
                 }
-                else
+                
+                glyph_run *Run = Batch->Runs + Batch->RunCount;
+                Run->DirectIndex.Value = 0;
+                Run->UTF8 = UTF8Segment;
+                Run->UTF8Count = 0;
+                Run->HashIndex = 0;
+                
+                glyph_state DirectEntry = {0};
+                uint32_t Codepoint;
+                if (UTF8SegmentLength == 1 && UTF8Segment[0] >= MinDirectCodepoint && UTF8Segment[0] <= MaxDirectCodepoint)
                 {
-                    IsAllDirect = 0;
+                    Run->DirectIndex = Terminal->ReservedTileTable[UTF8Segment[0] - MinDirectCodepoint];
+                    ++Batch->RunCount;
                 }
-                
-                if (IsAllDirect && UTF8SegmentLength == 1)
+                else if (DecodeDirectCodepoint(UTF8Segment, UTF8SegmentLength, &Codepoint) &&
+                         FindGlyphEntryByCodepoint(Terminal->GlyphTable, Codepoint, GlyphState_Rasterized, &DirectEntry))
                 {
-                    renderer_cell *Cell = GetCell(&Terminal->ScreenBuffer, Cursor->At);
-                    if (Cell)
-                    {
-                        glyph_props Props = Cursor->Props;
-                        if (Terminal->DebugHighlighting)
-                        {
-                            Props.Background = 0x00800000;
-                        }
-                        SetCellDirect(Terminal->ReservedTileTable[DirectCodepoint - MinDirectCodepoint], Props, Cell);
-                    }
-                    AdvanceColumn(Terminal, &Cursor->At);
+                    // NOTE: Mapped by an earlier FlushGlyphRunBatch, and pinned for this frame by the lookup
+                    Run->DirectIndex = DirectEntry.GPUIndex;
+                    ++Batch->RunCount;
                 }
                 else
                 {
-                    wchar_t UTF16Buffer[1024];
-                    DWORD UTF16Count = MultiByteToWideChar(CP_UTF8, 0, UTF8Segment, (DWORD)UTF8SegmentLength, UTF16Buffer, ArrayCount(UTF16Buffer));
-                    
-                    if (Terminal->DebugHighlighting)
-                    {
-                        AppendOutput(Terminal, "[CONV] UTF-8 to UTF-16: %zu bytes -> %u UTF-16 units (segment %u)\n", 
-                                   UTF8SegmentLength, UTF16Count, SegIndex);
-                        if (UTF16Count == 0)
-                        {
-                            DWORD Error = GetLastError();
-                            AppendOutput(Terminal, "[CONV] ERROR: Conversion failed with error %u\n", Error);
-                        }
-                    }
-                    
-                    if (UTF16Count > 0)
-                    {
-                        int Prepped = 0;
-                        glyph_hash RunHash = ComputeGlyphHash(2 * UTF16Count, (char unsigned *)UTF16Buffer, DefaultSeed);
-                        glyph_dim GlyphDim = GetGlyphDim(&Terminal->GlyphGen, Terminal->GlyphTable, UTF16Count, UTF16Buffer, RunHash);
-                        
-                        for (uint32_t TileIndex = 0; TileIndex < GlyphDim.TileCount; ++TileIndex)
-                        {
-                            renderer_cell *Cell = GetCell(&Terminal->ScreenBuffer, Cursor->At);
-                            if (Cell)
-                            {
-                                glyph_hash TileHash = ComputeHashForTileIndex(RunHash, TileIndex);
-                                glyph_state Entry = FindGlyphEntryByHash(Terminal->GlyphTable, TileHash);
-                                if (Entry.FilledState != GlyphState_Rasterized)
-                                {
-                                    if (!Prepped)
-                                    {
-                                        PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, UTF16Count, UTF16Buffer, GlyphDim);
-                                        Prepped = 1;
-                                    }
-                                    
-                                    TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, TileIndex, Entry.GPUIndex);
-                                    UpdateGlyphCacheEntry(Terminal->GlyphTable, Entry.ID, GlyphState_Rasterized, Entry.DimX, Entry.DimY);
-                                }
-                                
-                                glyph_props Props = Cursor->Props;
-                                if (Terminal->DebugHighlighting)
-                                {
-                                    Props.Background = Segment ? 0x0008080 : 0x00000080;
-                                    Segment = !Segment;
-                                }
-                                SetCellDirect(Entry.GPUIndex, Props, Cell);
-                            }
-                            
-                            AdvanceColumn(Terminal, &Cursor->At);
-                        }
-                    }
+                    // NOTE: Hashed straight from the UTF-8, so a hit never converts to UTF-16 at all
+                    Run->UTF8Count = (uint32_t)UTF8SegmentLength;
+                    Run->HashIndex = Batch->HashCount;
+                    Batch->HashInputs[Batch->HashCount].At = (char unsigned *)UTF8Segment;
+                    Batch->HashInputs[Batch->HashCount].Count = UTF8SegmentLength;
+                    ++Batch->HashCount;
+                    ++Batch->RunCount;
                 }
             }
         }
     }
+    
+    FlushGlyphRunBatch(Terminal, Batch, Cursor);
 }
 
 static int ParseLineIntoGlyphs(example_terminal *Terminal, source_buffer_range Range,
@@ -902,13 +1023,15 @@ static int ParseLineIntoGlyphs(example_terminal *Terminal, source_buffer_range R
                 }
                 else
                 {
+                    // NOTE: Hashed as its one UTF-8 byte, the same as ParseWithKB would hash it
                     Assert(CodePoint <= 127);
-                    glyph_hash RunHash = ComputeGlyphHash(2, (char unsigned *)&CodePoint, DefaultSeed);
+                    char unsigned UTF8 = (char unsigned)CodePoint;
+                    glyph_hash RunHash = ComputeGlyphHash(1, &UTF8, GetGlyphTableSeed(Terminal->GlyphTable));
                     glyph_state Entry = FindGlyphEntryByHash(Terminal->GlyphTable, RunHash);
-                    if(Entry.FilledState != GlyphState_Rasterized)
+                    if(!IsGlyphAtlasOverflow(Entry) && (Entry.FilledState != GlyphState_Rasterized))
                     {
                         PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, 1, &CodePoint, GetSingleTileUnitDim());
-                        TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, Entry.GPUIndex);
+                        TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, 1, Entry.GPUIndex);
                         UpdateGlyphCacheEntry(Terminal->GlyphTable, Entry.ID, GlyphState_Rasterized, Entry.DimX, Entry.DimY);
                     }
                     GPUIndex = Entry.GPUIndex;
@@ -948,6 +1071,96 @@ static void KillProcess(example_terminal *Terminal)
     }
 }
 
+static source_buffer_range GetScrollBackWritableRange(example_terminal *Terminal, size_t MaxCount)
+{
+    // NOTE: Whatever this write is about to overwrite goes to the cold scrollback first
+    size_t MaxColdCount = GetMaxColdWriteCount(&Terminal->ScrollBackBuffer);
+    if(MaxCount > MaxColdCount)
+    {
+        MaxCount = MaxColdCount;
+    }
+
+    ArchiveColdScrollback(&Terminal->ColdScrollBack, &Terminal->ScrollBackBuffer, MaxCount);
+    source_buffer_range Result = GetNextWritableRange(&Terminal->ScrollBackBuffer, MaxCount);
+    return Result;
+}
+
+static source_buffer_range GetChildWritableRange(example_terminal *Terminal, size_t MaxCount)
+{
+    /* NOTE: Reads from the child's pipes hold back from writing over Terminal->OldestNeededP, so
+       however big a read is, it can't lap lines that are on screen or still being parsed.
+       Without flow control that only matters when there is no cold scrollback, since anything
+       overwritten is archived first and still reads back.  With flow control, it always holds
+       back, so once the ring is full of what's on screen, nothing more is read until the screen
+       moves on - the child blocks on its full pipe in the meantime, rather than pushing output
+       past a screen that is scrolled up (or drawing slower than the child writes).
+
+       AppendOutput doesn't go through this, since it writes the terminal's own short messages
+       and can't be told to write less. */
+    if(Terminal->FlowControl || !Terminal->ColdScrollBack.Store.Data)
+    {
+        size_t NeededCount = GetWritableCountBefore(&Terminal->ScrollBackBuffer, Terminal->OldestNeededP);
+        if(MaxCount > NeededCount)
+        {
+            MaxCount = NeededCount;
+        }
+    }
+
+    source_buffer_range Result = GetScrollBackWritableRange(Terminal, MaxCount);
+
+    if(!Result.Count || Terminal->StallStart)
+    {
+        LARGE_INTEGER Now;
+        QueryPerformanceCounter(&Now);
+        if(!Result.Count && !Terminal->StallStart)
+        {
+            Terminal->StallStart = Now.QuadPart;
+            ++Terminal->StallCount;
+        }
+        else if(Result.Count)
+        {
+            Terminal->StallTicks += Now.QuadPart - Terminal->StallStart;
+            Terminal->StallStart = 0;
+        }
+    }
+
+    return Result;
+}
+
+static source_buffer_range ReadScrollBackAt(example_terminal *Terminal, size_t AbsoluteP, size_t Count)
+{
+    // NOTE: The range is only good until the next read, since a cold one points into the cold scrollback's cache
+    source_buffer_range Result = {0};
+    if(IsInBuffer(&Terminal->ScrollBackBuffer, AbsoluteP))
+    {
+        Result = ReadSourceAt(&Terminal->ScrollBackBuffer, AbsoluteP, Count);
+    }
+    else
+    {
+        Result = ReadColdScrollbackAt(&Terminal->ColdScrollBack, &Terminal->ScrollBackBuffer, AbsoluteP, Count);
+    }
+
+    return Result;
+}
+
+static void SaveScrollBackFile(example_terminal *Terminal)
+{
+    scrollback_file_state *State = (scrollback_file_state *)GetSourceBufferFileExtra(&Terminal->ScrollBackBuffer);
+    if(State)
+    {
+        State->Lines = Terminal->Lines.State;
+        State->RunningCursor = Terminal->RunningCursor;
+        SaveSourceBufferFile(&Terminal->ScrollBackBuffer);
+    }
+}
+
+static void CommitScrollBackWrite(example_terminal *Terminal, source_buffer_range Dest)
+{
+    CommitWrite(&Terminal->ScrollBackBuffer, Dest.Count);
+    ParseLines(Terminal, Dest, &Terminal->RunningCursor);
+    SaveScrollBackFile(Terminal);
+}
+
 static void AppendOutput(example_terminal *Terminal, char *Format, ...)
 {
     // TODO(casey): This is all garbage code.  You need a checked printf here, and of
@@ -955,15 +1168,99 @@ static void AppendOutput(example_terminal *Terminal, char *Format, ...)
     // a real concatenator here, like with a #define system, but this is just
     // a hack for now to do basic printing from the internal code.
 
-    source_buffer_range Dest = GetNextWritableRange(&Terminal->ScrollBackBuffer, LARGEST_AVAILABLE);
+    // NOTE: wvsprintfA never writes more than 1024 characters plus the terminator
+    source_buffer_range Dest = GetScrollBackWritableRange(Terminal, 1025);
     va_list ArgList;
     va_start(ArgList, Format);
     int Used = wvsprintfA(Dest.Data, Format, ArgList);
     va_end(ArgList);
 
     Dest.Count = Used;
-    CommitWrite(&Terminal->ScrollBackBuffer, Dest.Count);
-    ParseLines(Terminal, Dest, &Terminal->RunningCursor);
+    CommitScrollBackWrite(Terminal, Dest);
+}
+
+static void OpenScrollBackFile(example_terminal *Terminal, char *Path)
+{
+    /* NOTE: Switches the scrollback over to the file at Path, so it can be as big as the disk
+       allows instead of as big as memory does, and outlives refterm.  A new file starts out
+       ScrollBackFileSize big and empty, like a new terminal.  A file from an earlier session
+       comes back with its output and its lines as they were, and since the lines are in the
+       file too, nothing has to be parsed again - only the lines that end up on screen are
+       ever read, and the OS pages in just those. */
+    size_t ExtraSize = (sizeof(scrollback_file_state) +
+                        GetLineIndexMemorySize(Terminal->MaxLineChunkCount, Terminal->MaxLinePropsCount));
+    source_buffer File = AllocateFileSourceBuffer(Path, Terminal->ScrollBackFileSize, ExtraSize);
+    // NOTE: The cold scrollback needs more than one of its blocks of ring to archive from
+    if(File.Data && (File.DataSize > COLD_BLOCK_SIZE))
+    {
+        scrollback_file_state *State = (scrollback_file_state *)GetSourceBufferFileExtra(&File);
+        line_index Lines;
+        if(!AttachLineIndex(&Lines, State + 1, Terminal->MaxLineChunkCount, Terminal->MaxLinePropsCount, State->Lines))
+        {
+            // NOTE: A new file (or one whose lines make no sense), so the lines start over, same as at startup
+            ClearCursor(Terminal, &State->RunningCursor);
+            ResetLineIndex(&Lines, GetCurrentAbsoluteP(&File), State->RunningCursor.Props);
+        }
+
+        if(Terminal->ScrollBackBuffer.File)
+        {
+            SaveScrollBackFile(Terminal);
+        }
+        FreeLineIndex(&Terminal->Lines);
+        FreeSourceBuffer(&Terminal->ScrollBackBuffer);
+
+        Terminal->ScrollBackBuffer = File;
+        Terminal->Lines = Lines;
+        Terminal->RunningCursor = State->RunningCursor;
+        Terminal->ViewingLineOffset = 0;
+        Terminal->OldestNeededP = GetCurrentAbsoluteP(&Terminal->ScrollBackBuffer);
+
+        // NOTE: What the cold scrollback had archived was from the old buffer
+        ResetColdScrollback(&Terminal->ColdScrollBack, &Terminal->ScrollBackBuffer);
+
+        AppendOutput(Terminal, "Scrollback: %s, %uMB\n", Path, (uint32_t)(File.DataSize >> 20));
+    }
+    else
+    {
+        FreeSourceBuffer(&File);
+        AppendOutput(Terminal, "Unable to use \"%s\" as a scrollback file\n", Path);
+    }
+}
+
+static void ToggleScrollBackHugePages(example_terminal *Terminal)
+{
+    /* NOTE: Huge pages are opt-in, since asking for them adjusts the process token to enable
+       SeLockMemoryPrivilege, which a terminal shouldn't do every time it starts just in case.
+       What the scrollback is on can only change by allocating it again, so it starts over
+       empty, like a new terminal.  The new one is allocated while the old one is still there,
+       so if that fails nothing changes.  A scrollback file is a mapping of the file, which is
+       never on huge pages. */
+    if(Terminal->ScrollBackBuffer.File)
+    {
+        AppendOutput(Terminal, "Huge pages: not for a scrollback file\n");
+        return;
+    }
+
+    int UseHugePages = !Terminal->ScrollBackHugePages;
+    source_buffer NewBuffer = AllocateQuietSourceBuffer(Terminal->PipeSize, UseHugePages);
+    if(!NewBuffer.Data)
+    {
+        AppendOutput(Terminal, "Huge pages: unable to switch, scrollback left as it was\n");
+        return;
+    }
+
+    Terminal->ScrollBackHugePages = UseHugePages;
+    FreeSourceBuffer(&Terminal->ScrollBackBuffer);
+    Terminal->ScrollBackBuffer = NewBuffer;
+
+    ClearCursor(Terminal, &Terminal->RunningCursor);
+    ResetLineIndex(&Terminal->Lines, GetCurrentAbsoluteP(&Terminal->ScrollBackBuffer), Terminal->RunningCursor.Props);
+    Terminal->ViewingLineOffset = 0;
+    Terminal->OldestNeededP = GetCurrentAbsoluteP(&Terminal->ScrollBackBuffer);
+    ResetColdScrollback(&Terminal->ColdScrollBack, &Terminal->ScrollBackBuffer);
+
+    AppendOutput(Terminal, "Huge pages: %s, scrollback on %uKB pages\n", Terminal->ScrollBackHugePages ? "ON" : "off",
+                 (uint32_t)(Terminal->ScrollBackBuffer.PageSize >> 10));
 }
 
 static int UpdateTerminalBuffer(example_terminal *Terminal, HANDLE FromPipe)
@@ -979,15 +1276,14 @@ static int UpdateTerminalBuffer(example_terminal *Terminal, HANDLE FromPipe)
         DWORD PendingCount = GetPipePendingDataCount(FromPipe);
         if(PendingCount)
         {
-            source_buffer_range Dest = GetNextWritableRange(&Terminal->ScrollBackBuffer, PendingCount);
+            source_buffer_range Dest = GetChildWritableRange(Terminal, PendingCount);
 
             DWORD ReadCount = 0;
-            if(ReadFile(FromPipe, Dest.Data, (DWORD)Dest.Count, &ReadCount, 0))
+            if(Dest.Count && ReadFile(FromPipe, Dest.Data, (DWORD)Dest.Count, &ReadCount, 0))
             {
                 Assert(ReadCount <= Dest.Count);
                 Dest.Count = ReadCount;
-                CommitWrite(&Terminal->ScrollBackBuffer, Dest.Count);
-                ParseLines(Terminal, Dest, &Terminal->RunningCursor);
+                CommitScrollBackWrite(Terminal, Dest);
             }
         }
         else
@@ -1006,6 +1302,9 @@ static int UpdateTerminalBuffer(example_terminal *Terminal, HANDLE FromPipe)
 
 static void LayoutLines(example_terminal *Terminal)
 {
+    // NOTE: Every glyph looked up from here on is on screen this frame, so it must not be recycled until the next one
+    BeginGlyphTableFrame(Terminal->GlyphTable);
+
     // TODO(casey): Probably want to do something better here - this over-clears, since we clear
     // the whole thing and then also each line, for no real reason other than to make line wrapping
     // simpler.
@@ -1017,22 +1316,33 @@ static void LayoutLines(example_terminal *Terminal)
 
     // TODO(casey): How do we know how far back to go, for control chars?
     int32_t LineCount = 2*Terminal->ScreenBuffer.DimY;
-    int32_t LineOffset = Terminal->CurrentLineIndex + Terminal->ViewingLineOffset - LineCount;
+    int64_t LineOffset = (int64_t)GetCurrentLine(&Terminal->Lines) + Terminal->ViewingLineOffset - LineCount;
 
     int CursorJumped = 0;
 
+    // NOTE: What the child's output has to hold back from until the next layout, see GetChildWritableRange
+    source_buffer *ScrollBack = &Terminal->ScrollBackBuffer;
+    size_t OldestNeededP = GetLine(&Terminal->Lines, GetCurrentLine(&Terminal->Lines)).FirstP;
+
     cursor_state Cursor = {0};
     ClearCursor(Terminal, &Cursor);
     for(int32_t LineIndexIndex = 0;
         LineIndexIndex < LineCount;
         ++LineIndexIndex)
     {
-        int32_t LineIndex = (LineOffset + LineIndexIndex) % Terminal->MaxLineCount;
-        if(LineIndex < 0) LineIndex += Terminal->MaxLineCount;
-
-        example_line Line = Terminal->Lines[LineIndex];
+        // NOTE: Lines before the first one in the index come back empty, the way they always did
+        int64_t LineIndex = LineOffset + LineIndexIndex;
+        example_line Line = {0};
+        if(LineIndex >= 0)
+        {
+            Line = GetLine(&Terminal->Lines, (size_t)LineIndex);
+        }
+        if((Line.FirstP < OldestNeededP) && IsInBuffer(ScrollBack, Line.FirstP))
+        {
+            OldestNeededP = Line.FirstP;
+        }
 
-        source_buffer_range Range = ReadSourceAt(&Terminal->ScrollBackBuffer, Line.FirstP, Line.OnePastLastP - Line.FirstP);
+        source_buffer_range Range = ReadScrollBackAt(Terminal, Line.FirstP, Line.OnePastLastP - Line.FirstP);
         Cursor.Props = Line.StartingProps;
         if(ParseLineIntoGlyphs(Terminal, Range, &Cursor, Line.ContainsComplexChars))
         {
@@ -1040,6 +1350,17 @@ static void LayoutLines(example_terminal *Terminal)
         }
     }
 
+    // NOTE: At the bottom, the screen only moves on when more output comes in, so if the lines
+    // on it (or one long line) took up the whole ring, holding back from them would never end.
+    // Half the ring is always left free there.  Scrolled up, it's up to the user to scroll back down.
+    size_t EndP = GetCurrentAbsoluteP(ScrollBack);
+    if((Terminal->ViewingLineOffset == 0) && ((EndP - OldestNeededP) > (ScrollBack->DataSize / 2)))
+    {
+        OldestNeededP = EndP - ScrollBack->DataSize / 2;
+    }
+
+    Terminal->OldestNeededP = OldestNeededP;
+
     if(CursorJumped)
     {
         Cursor.At.X = 0;
@@ -1174,6 +1495,62 @@ RevertToDefaultFont(example_terminal *Terminal)
 #endif
 }
 
+static void ReleaseFontPartition(example_terminal *Terminal, font_partition *Partition, int SaveSnapshot)
+{
+    if(Partition->GlyphTable)
+    {
+        // NOTE: Keep the font's glyphs on disk, in case it gets used again after all
+        if(SaveSnapshot)
+        {
+            SaveGlyphSnapshot(&Partition->Key, Partition->GlyphTable, &Terminal->Renderer, Partition->FirstPage, Partition->SeedTime);
+        }
+
+        VirtualFree(Partition->GlyphTableMem, 0, MEM_RELEASE);
+    }
+
+    uint32_t FirstPage = Partition->FirstPage;
+    ZeroMemory(Partition, sizeof(*Partition));
+    Partition->FirstPage = FirstPage;
+}
+
+static void ReleaseFontPartitions(example_terminal *Terminal, int SaveSnapshots)
+{
+    for(uint32_t PartitionIndex = 0; PartitionIndex < ArrayCount(Terminal->FontPartitions); ++PartitionIndex)
+    {
+        font_partition *Partition = Terminal->FontPartitions + PartitionIndex;
+        Partition->FirstPage = PartitionIndex*Terminal->REFTERM_FONT_TEXTURE_PAGES;
+        ReleaseFontPartition(Terminal, Partition, SaveSnapshots);
+    }
+
+    Terminal->GlyphTable = 0;
+}
+
+static uint32_t FindFontPartition(example_terminal *Terminal, glyph_snapshot_key *Key)
+{
+    // NOTE: The partition already set up for Key if there is one, otherwise an unused one, otherwise
+    // the least recently used one, which is released (the current one is the most recently used,
+    // so it is only ever picked if there is just the one partition).
+    uint32_t Result = 0;
+    for(uint32_t PartitionIndex = 0; PartitionIndex < ArrayCount(Terminal->FontPartitions); ++PartitionIndex)
+    {
+        font_partition *Partition = Terminal->FontPartitions + PartitionIndex;
+        if(Partition->GlyphTable && BytesAreEqual(sizeof(*Key), &Partition->Key, Key))
+        {
+            return(PartitionIndex);
+        }
+
+        if(Terminal->FontPartitions[Result].GlyphTable &&
+           (!Partition->GlyphTable || (Partition->LastUsed < Terminal->FontPartitions[Result].LastUsed)))
+        {
+            Result = PartitionIndex;
+        }
+    }
+
+    ReleaseFontPartition(Terminal, Terminal->FontPartitions + Result, 1);
+
+    return Result;
+}
+
 static int
 RefreshFont(example_terminal *Terminal)
 {
@@ -1197,12 +1574,39 @@ RefreshFont(example_terminal *Terminal)
         if(Result)
         {
             Params.CacheTileCountInX = SafeRatio1(Terminal->REFTERM_TEXTURE_WIDTH, Terminal->GlyphGen.FontWidth);
-            Params.EntryCount = GetExpectedTileCountForDimension(&Terminal->GlyphGen, Terminal->REFTERM_TEXTURE_WIDTH, Terminal->REFTERM_TEXTURE_HEIGHT);
+            Params.CacheTileCountInY = SafeRatio1(Terminal->REFTERM_TEXTURE_HEIGHT, Terminal->GlyphGen.FontHeight);
+            uint32_t PageTileCount = GetExpectedTileCountForDimension(&Terminal->GlyphGen, Terminal->REFTERM_TEXTURE_WIDTH, Terminal->REFTERM_TEXTURE_HEIGHT);
+            uint32_t TextureTileCount = PageTileCount*Terminal->REFTERM_FONT_TEXTURE_PAGES;
+            // NOTE: The hash table starts small and doubles as the chains get long, so a session
+            // that goes through a lot of Unicode keeps short chains without a flush.
             Params.HashCount = 4096;
+            Params.MaxHashCount = 65536;
+
+            // NOTE: Borders, meter bars and the like look up the same few glyphs cell after cell,
+            // which the front cache answers without going to the hash table at all.
+            Params.FrontCacheCount = 256;
+
+            // NOTE: Enough pages for the box-drawing, block, symbol and script blocks a session
+            // is likely to see, 64k in all
+            Params.DirectPageCount = 64;
+
+            // NOTE: About half of the first page's tiles go to 2-tile spans and a sixteenth to 4-tile
+            // spans, for wide glyphs like CJK and emoji.  Everything else, including every other
+            // page, is single-tile entries, so the extra pages only get created once the first
+            // one is full.
+            Params.EntryCount = 0;
+            Params.SpanEntryCounts[0] = 0;
+            Params.SpanEntryCounts[1] = 0;
+            if(Params.CacheTileCountInX >= 4)
+            {
+                Params.SpanEntryCounts[0] = PageTileCount / 4;
+                Params.SpanEntryCounts[1] = PageTileCount / 64;
+            }
 
-            if(Params.EntryCount > Params.ReservedTileCount)
+            uint32_t SpanTileEnd = GetGlyphTableTileCount(Params);
+            if(TextureTileCount > SpanTileEnd)
             {
-                Params.EntryCount -= Params.ReservedTileCount;
+                Params.EntryCount = TextureTileCount - SpanTileEnd;
                 break;
             }
         }
@@ -1210,44 +1614,147 @@ RefreshFont(example_terminal *Terminal)
         RevertToDefaultFont(Terminal);
     }
 
-    // TODO(casey): In theory, this VirtualAlloc could fail, so it may be a better idea to
-    // just use a reserved memory footprint here and always use the same size.  It is not
-    // a very large amount of memory, so picking a maximum and sticking with it is probably
-    // better.  You can cap the size of the cache and there is no real penalty for doing
-    // that, since it's a cache, so it'd just be a better idea all around.
-    if(Terminal->GlyphTableMem)
-    {
-        VirtualFree(Terminal->GlyphTableMem, 0, MEM_RELEASE);
-        Terminal->GlyphTableMem = 0;
-    }
-    Terminal->GlyphTableMem = VirtualAlloc(0, GetGlyphTableFootprint(Params), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-    Terminal->GlyphTable = PlaceGlyphTableInMemory(Params, Terminal->GlyphTableMem);
+    glyph_snapshot_key Key;
+    ZeroMemory(&Key, sizeof(Key));
+    wsprintfW(Key.FontName, L"%s", Terminal->RequestedFontName);
+    Key.FontHeight = Terminal->RequestedFontHeight;
+    Key.CellWidth = Terminal->GlyphGen.FontWidth;
+    Key.CellHeight = Terminal->GlyphGen.FontHeight;
+    Key.TextureWidth = Terminal->REFTERM_TEXTURE_WIDTH;
+    Key.TextureHeight = Terminal->REFTERM_TEXTURE_HEIGHT;
+    Key.Params = Params;
+    Key.HashBackend = GetGlyphHashBackend();
+
+    font_partition *Current = Terminal->FontPartitions + Terminal->FontPartitionIndex;
+    Current->SizeCount = Terminal->GlyphGen.SizeCount;
+    Current->RasterizeCount = Terminal->GlyphGen.RasterizeCount;
+
+    uint32_t PartitionIndex = FindFontPartition(Terminal, &Key);
+    font_partition *Partition = Terminal->FontPartitions + PartitionIndex;
+    if(!Partition->GlyphTable)
+    {
+        Params.FirstCachePage = Partition->FirstPage;
+
+        // TODO(casey): In theory, this VirtualAlloc could fail, so it may be a better idea to
+        // just use a reserved memory footprint here and always use the same size.  It is not
+        // a very large amount of memory, so picking a maximum and sticking with it is probably
+        // better.  You can cap the size of the cache and there is no real penalty for doing
+        // that, since it's a cache, so it'd just be a better idea all around.
+        Partition->GlyphTableMem = VirtualAlloc(0, GetGlyphTableFootprint(Params), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        Partition->GlyphTable = PlaceGlyphTableInMemory(Params, Partition->GlyphTableMem);
+        Partition->Key = Key;
+
+        // NOTE: Whatever is printed to the terminal goes through this table, so its hash seed comes
+        // from the OS, where nothing printed to the terminal can guess it.  A snapshot that loads
+        // below puts back the seed it was saved with, as long as that seed isn't too old.
+        char unsigned Seed[16];
+        Partition->SeedTime = 0;
+        if(Partition->GlyphTable &&
+           BCRYPT_SUCCESS(BCryptGenRandom(0, Seed, sizeof(Seed), BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+        {
+            SetGlyphTableSeed(Partition->GlyphTable, Seed);
+            Partition->SeedTime = GetGlyphSnapshotTime();
+        }
+        Partition->SizeCount = 0;
+        Partition->RasterizeCount = 0;
 
-    InitializeDirectGlyphTable(Params, Terminal->ReservedTileTable, 1);
+        InitializeDirectGlyphTable(Params, Partition->ReservedTileTable, 1);
 
-    //
-    // NOTE(casey): Pre-rasterize all the ASCII characters, since they are directly mapped rather than hash-mapped.
-    //
+        //
+        // NOTE: If this exact font and table were used before, the last run's glyphs (and the
+        // direct-mapped tiles) come back from the snapshot, and nothing has to be rasterized.
+        //
 
-    glyph_dim UnitDim = GetSingleTileUnitDim();
+        if(!LoadGlyphSnapshot(&Key, Partition->GlyphTable, &Terminal->Renderer, Partition->FirstPage, &Partition->SeedTime))
+        {
+            //
+            // NOTE(casey): Pre-rasterize all the ASCII characters, since they are directly mapped rather than hash-mapped.
+            //
 
-    for(uint32_t TileIndex = 0;
-        TileIndex < ArrayCount(Terminal->ReservedTileTable);
-        ++TileIndex)
-    {
-        wchar_t Letter = MinDirectCodepoint + TileIndex;
-        PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, 1, &Letter, UnitDim);
-        TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, Terminal->ReservedTileTable[TileIndex]);
+            glyph_dim UnitDim = GetSingleTileUnitDim();
+
+            for(uint32_t TileIndex = 0;
+                TileIndex < ArrayCount(Partition->ReservedTileTable);
+                ++TileIndex)
+            {
+                wchar_t Letter = MinDirectCodepoint + TileIndex;
+                PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, 1, &Letter, UnitDim);
+                TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, 1, Partition->ReservedTileTable[TileIndex]);
+            }
+
+            // NOTE: There's no need to rasterize an empty glyph into tile 0 anymore, since the shaders
+            // never read glyph index 0 from the texture.
+        }
     }
 
-    wchar_t Nothing = 0;
-    gpu_glyph_index ZeroTile = {0};
-    PrepareTilesForTransfer(&Terminal->GlyphGen, &Terminal->Renderer, 0, &Nothing, UnitDim);
-    TransferTile(&Terminal->GlyphGen, &Terminal->Renderer, 0, ZeroTile);
+    // NOTE: A font that already had a partition just becomes the current one again, glyphs and all
+    Partition->LastUsed = ++Terminal->FontPartitionClock;
+    Terminal->FontPartitionIndex = PartitionIndex;
+    Terminal->GlyphTable = Partition->GlyphTable;
+    CopyMemory(Terminal->ReservedTileTable, Partition->ReservedTileTable, sizeof(Terminal->ReservedTileTable));
 
+    // NOTE: The partition's stats only count since it was set up, so the miss work counted for "status" does too
+    Terminal->GlyphGen.SizeCount = Partition->SizeCount;
+    Terminal->GlyphGen.RasterizeCount = Partition->RasterizeCount;
+
+    return Result;
+}
+
+static uint32_t GetPercent(size_t Part, size_t Whole)
+{
+    uint32_t Result = Whole ? (uint32_t)((100*(uint64_t)Part) / Whole) : 0;
     return Result;
 }
 
+static void AppendGlyphCacheStatus(example_terminal *Terminal)
+{
+    // NOTE: These are totals since the current font was set up, so they don't disturb the
+    // per-interval numbers in the title bar
+    glyph_table_stats Stats = GetGlyphTableStats(Terminal->GlyphTable);
+    size_t LookupCount = Stats.HitCount + Stats.MissCount;
+
+    AppendOutput(Terminal, "Glyph hash: %s\n", GetGlyphHashBackendName(GetGlyphHashBackend()));
+    AppendOutput(Terminal, "Glyph cache: %u hits, %u misses (%u%% hit), %u recycled, %u overflows, %u spans, %u grows, %u chain evictions\n",
+                 (uint32_t)Stats.HitCount, (uint32_t)Stats.MissCount, GetPercent(Stats.HitCount, LookupCount),
+                 (uint32_t)Stats.RecycleCount, (uint32_t)Stats.OverflowCount, (uint32_t)Stats.SpanCount, (uint32_t)Stats.GrowCount,
+                 (uint32_t)Stats.ChainEvictionCount);
+    AppendOutput(Terminal, "Glyph front cache: %u hits (%u%% of lookups), codepoint table: %u hits (%u%%)\n",
+                 (uint32_t)Stats.FrontHitCount, GetPercent(Stats.FrontHitCount, LookupCount),
+                 (uint32_t)Stats.DirectHitCount, GetPercent(Stats.DirectHitCount, LookupCount));
+    AppendOutput(Terminal, "Glyph misses: %u sized (%u%%), %u rasterized (%u%%)\n",
+                 (uint32_t)Terminal->GlyphGen.SizeCount, GetPercent(Terminal->GlyphGen.SizeCount, Stats.MissCount),
+                 (uint32_t)Terminal->GlyphGen.RasterizeCount, GetPercent(Terminal->GlyphGen.RasterizeCount, Stats.MissCount));
+
+    AppendOutput(Terminal, "Glyph probe lengths:");
+    for(uint32_t Bucket = 0; Bucket < GLYPH_TABLE_PROBE_HISTOGRAM_COUNT; ++Bucket)
+    {
+        AppendOutput(Terminal, " %u%s:%u", Bucket, (Bucket == (GLYPH_TABLE_PROBE_HISTOGRAM_COUNT - 1)) ? "+" : "",
+                     (uint32_t)Stats.ProbeLengthHistogram[Bucket]);
+    }
+    AppendOutput(Terminal, "\n");
+
+    AppendOutput(Terminal, "Glyph eviction ages (frames):");
+    for(uint32_t Bucket = 0; Bucket < GLYPH_TABLE_AGE_HISTOGRAM_COUNT; ++Bucket)
+    {
+        if(Stats.EvictionAgeHistogram[Bucket])
+        {
+            uint32_t MinAge = Bucket ? (1u << (Bucket - 1)) : 0;
+            AppendOutput(Terminal, " %u%s:%u", MinAge, (Bucket == (GLYPH_TABLE_AGE_HISTOGRAM_COUNT - 1)) ? "+" : "",
+                         (uint32_t)Stats.EvictionAgeHistogram[Bucket]);
+        }
+    }
+    AppendOutput(Terminal, "\n");
+
+    uint32_t PartitionCount = 0;
+    for(uint32_t PartitionIndex = 0; PartitionIndex < ArrayCount(Terminal->FontPartitions); ++PartitionIndex)
+    {
+        PartitionCount += (Terminal->FontPartitions[PartitionIndex].GlyphTable != 0);
+    }
+    AppendOutput(Terminal, "Glyph font partitions: %u of %u in use, %u cache texture pages of %u\n",
+                 PartitionCount, (uint32_t)ArrayCount(Terminal->FontPartitions),
+                 Terminal->Renderer.GlyphPageCount, Terminal->Renderer.MaxGlyphPageCount);
+}
+
 static void ExecuteCommandLine(example_terminal *Terminal)
 {
     // TODO(casey): All of this is complete garbage and should never ever be used.
@@ -1286,12 +1793,39 @@ static void ExecuteCommandLine(example_terminal *Terminal)
         AppendOutput(Terminal, "Line Wrap: %s\n", Terminal->LineWrap ? "ON" : "off");
         AppendOutput(Terminal, "Debug: %s\n", Terminal->DebugHighlighting ? "ON" : "off");
         AppendOutput(Terminal, "Throttling: %s\n", !Terminal->NoThrottle ? "ON" : "off");
+        LARGE_INTEGER StallFrequency;
+        QueryPerformanceFrequency(&StallFrequency);
+        AppendOutput(Terminal, "Flow control: %s, output stalled %u times for %ums\n", Terminal->FlowControl ? "ON" : "off",
+                     (uint32_t)Terminal->StallCount, (uint32_t)(1000*Terminal->StallTicks / StallFrequency.QuadPart));
+        AppendOutput(Terminal, "Scrollback: %uMB on %uKB pages%s\n", (uint32_t)(Terminal->ScrollBackBuffer.DataSize >> 20),
+                     (uint32_t)(Terminal->ScrollBackBuffer.PageSize >> 10), Terminal->ScrollBackBuffer.File ? ", in a file" : "");
+        cold_scrollback *Cold = &Terminal->ColdScrollBack;
+        AppendOutput(Terminal, "Cold scrollback: %uMB held, %u blocks archived into %uMB, %u decompressed, %u cache hits\n",
+                     (uint32_t)((Cold->OnePastLastP - Cold->FirstP) >> 20), (uint32_t)Cold->ArchivedCount,
+                     (uint32_t)(Cold->CompressedSize >> 20), (uint32_t)Cold->DecompressCount, (uint32_t)Cold->CacheHitCount);
+        line_index *Lines = &Terminal->Lines;
+        AppendOutput(Terminal, "Lines: %u indexed, %u starting props, %uKB committed\n", (uint32_t)GetLineIndexCount(Lines),
+                     (uint32_t)Lines->State.PropsEnd, (uint32_t)((Lines->CommittedChunkSize + Lines->CommittedPropsSize) >> 10));
+        AppendGlyphCacheStatus(Terminal);
+    }
+    else if(StringsAreEqual(Terminal->CommandLine, "scrollback"))
+    {
+        OpenScrollBackFile(Terminal, B);
+    }
+    else if(StringsAreEqual(Terminal->CommandLine, "hugepages"))
+    {
+        ToggleScrollBackHugePages(Terminal);
     }
     else if(StringsAreEqual(Terminal->CommandLine, "fastpipe"))
     {
         Terminal->EnableFastPipe = !Terminal->EnableFastPipe;
         AppendOutput(Terminal, "Fast pipe: %s\n", Terminal->EnableFastPipe ? "ON" : "off");
     }
+    else if(StringsAreEqual(Terminal->CommandLine, "flowcontrol"))
+    {
+        Terminal->FlowControl = !Terminal->FlowControl;
+        AppendOutput(Terminal, "Flow control: %s\n", Terminal->FlowControl ? "ON" : "off");
+    }
     else if(StringsAreEqual(Terminal->CommandLine, "linewrap"))
     {
         Terminal->LineWrap = !Terminal->LineWrap;
@@ -1309,6 +1843,7 @@ static void ExecuteCommandLine(example_terminal *Terminal)
     }
     else if(StringsAreEqual(Terminal->CommandLine, "font"))
     {
+        // NOTE: The old font keeps its partition, so switching back is instant
         DWORD NullAt = MultiByteToWideChar(CP_UTF8, 0, B, (DWORD)(Terminal->CommandLineCount - ParamStart),
                                            Terminal->RequestedFontName, ArrayCount(Terminal->RequestedFontName) - 1);
         Terminal->RequestedFontName[NullAt] = 0;
@@ -1331,7 +1866,7 @@ static void ExecuteCommandLine(example_terminal *Terminal)
             (StringsAreEqual(Terminal->CommandLine, "cls")))
     {
         ClearCursor(Terminal, &Terminal->RunningCursor);
-        memset(Terminal->Lines, 0, Terminal->MaxLineCount*sizeof(example_line));
+        ResetLineIndex(&Terminal->Lines, GetCurrentAbsoluteP(&Terminal->ScrollBackBuffer), Terminal->RunningCursor.Props);
     }
     else if((StringsAreEqual(Terminal->CommandLine, "exit")) ||
             (StringsAreEqual(Terminal->CommandLine, "quit")))
@@ -1404,9 +1939,10 @@ static void ProcessMessages(example_terminal *Terminal)
                     Terminal->ViewingLineOffset = 0;
                 }
 
-                if(Terminal->ViewingLineOffset < -(int)Terminal->LineCount)
+                int32_t LineCount = (int32_t)GetLineIndexCount(&Terminal->Lines);
+                if(Terminal->ViewingLineOffset < -LineCount)
                 {
-                    Terminal->ViewingLineOffset = -(int)Terminal->LineCount;
+                    Terminal->ViewingLineOffset = -LineCount;
                 }
             } break;
 
@@ -1493,22 +2029,35 @@ static DWORD WINAPI TerminalThread(LPVOID Param)
     Terminal->FastPipeReady = CreateEventW(0, TRUE, FALSE, 0);
     Terminal->FastPipeTrigger.hEvent = Terminal->FastPipeReady;
     Terminal->PipeSize = 16*1024*1024;
+    Terminal->ScrollBackHugePages = 0; // NOTE: See ToggleScrollBackHugePages
+    Terminal->ScrollBackFileSize = (size_t)1 << 30;
     
     ZeroMemory(&Terminal->KBPartitioner, sizeof(kb_partitioner));
 
     ClearCursor(Terminal, &Terminal->RunningCursor);
 
-    // TODO(casey): I believe this should probably be sized to be the same
-    // as the window at a minimum, because if it isn't, you may run into
-    // pathological cases where the wrong glyph is rendered.  The alternative
-    // would be forcing flushes of the pipe when the total number of recycles
-    // in a frame reaches the total number of glyphs in the cache.  Since the
-    // basically never happens, you don't see any bugs with it, but it
-    // theoretically _could_ happen if the texture size isn't large enough
-    // to fit one whole screen of glyphs.
+    // NOTE: LayoutLines begins a new glyph table frame every time, and entries used in
+    // the current frame are never recycled, so this no longer has to fit one whole screen
+    // of glyphs.  If it doesn't, the glyphs that don't fit are drawn blank (and counted as
+    // overflows in the glyph table stats) instead of drawing the wrong glyph.
     Terminal->REFTERM_TEXTURE_WIDTH = 2048;
     Terminal->REFTERM_TEXTURE_HEIGHT = 2048;
 
+    // NOTE: The glyph cache starts as one page and adds pages as it fills them.  Each font
+    // partition gets up to 32MB of texture (2 pages at 2048x2048), so big fonts and CJK-heavy
+    // output don't thrash one page, and the texture only gets as far as the last partition
+    // that has actually been used.
+    uint32_t FontGlyphCacheBudget = 32*1024*1024;
+    Terminal->REFTERM_FONT_TEXTURE_PAGES = FontGlyphCacheBudget / (4*Terminal->REFTERM_TEXTURE_WIDTH*Terminal->REFTERM_TEXTURE_HEIGHT);
+    if(Terminal->REFTERM_FONT_TEXTURE_PAGES < 1)
+    {
+        Terminal->REFTERM_FONT_TEXTURE_PAGES = 1;
+    }
+    if(Terminal->REFTERM_FONT_TEXTURE_PAGES > (256 / REFTERM_FONT_PARTITION_COUNT))
+    {
+        Terminal->REFTERM_FONT_TEXTURE_PAGES = (256 / REFTERM_FONT_PARTITION_COUNT);
+    }
+
     // TODO(casey): Auto-size this, somehow?  The TransferHeight effectively restricts the maximum size of the
     // font, so it may want to be "grown" based on the font size selected.
     Terminal->TransferWidth = 1024;
@@ -1522,16 +2071,28 @@ static DWORD WINAPI TerminalThread(LPVOID Param)
     DebugD3D11 = 1;
 #endif
 
-    Terminal->Renderer = AcquireD3D11Renderer(Terminal->Window, DebugD3D11);
-    SetD3D11GlyphCacheDim(&Terminal->Renderer, Terminal->REFTERM_TEXTURE_WIDTH, Terminal->REFTERM_TEXTURE_HEIGHT);
+    Terminal->ShaderCode = CompileD3D11Shaders();
+    Terminal->Renderer = AcquireD3D11Renderer(Terminal->Window, DebugD3D11, &Terminal->ShaderCode);
+    SetD3D11GlyphCacheDim(&Terminal->Renderer, Terminal->REFTERM_TEXTURE_WIDTH, Terminal->REFTERM_TEXTURE_HEIGHT,
+                          REFTERM_FONT_PARTITION_COUNT*Terminal->REFTERM_FONT_TEXTURE_PAGES);
     SetD3D11GlyphTransferDim(&Terminal->Renderer, Terminal->TransferWidth, Terminal->TransferHeight);
 
     Terminal->GlyphGen = AllocateGlyphGenerator(Terminal->TransferWidth, Terminal->TransferHeight, Terminal->Renderer.GlyphTransferSurface);
-    Terminal->ScrollBackBuffer = AllocateSourceBuffer(Terminal->PipeSize);
+    Terminal->ScrollBackBuffer = AllocateSourceBuffer(Terminal->PipeSize, Terminal->ScrollBackHugePages);
 
-    Terminal->MaxLineCount = 8192;
-    Terminal->Lines = VirtualAlloc(0, Terminal->MaxLineCount*sizeof(example_line), MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+    // NOTE: 64MB of compressed history, which terminal output usually packs several times over, and at most 1GB of it
+    Terminal->ColdScrollBack = AllocateColdScrollback(64*1024*1024, 16384);
 
+    // NOTE: 16 million lines in 96MB, and a million distinct props at their starts in 12MB, committed as they are used
+    Terminal->MaxLineChunkCount = 4096;
+    Terminal->MaxLinePropsCount = 1024*1024;
+    Terminal->Lines = AllocateLineIndex(Terminal->MaxLineChunkCount, Terminal->MaxLinePropsCount);
+    ResetLineIndex(&Terminal->Lines, 0, Terminal->RunningCursor.Props);
+
+    // NOTE: Has to happen before anything is hashed, including the glyph snapshot file names
+    SelectGlyphHashBackend();
+
+    ReleaseFontPartitions(Terminal, 0);
     RevertToDefaultFont(Terminal);
     RefreshFont(Terminal);
 
@@ -1641,7 +2202,13 @@ static DWORD WINAPI TerminalThread(LPVOID Param)
         int Blink = ((1000*(BlinkTimer.QuadPart - StartTime.QuadPart) / (BlinkMS*Frequency.QuadPart)) & 1);
         if(!Terminal->Renderer.Device)
         {
-            Terminal->Renderer = AcquireD3D11Renderer(Terminal->Window, 0);
+            Terminal->Renderer = AcquireD3D11Renderer(Terminal->Window, 0, &Terminal->ShaderCode);
+            SetD3D11GlyphCacheDim(&Terminal->Renderer, Terminal->REFTERM_TEXTURE_WIDTH, Terminal->REFTERM_TEXTURE_HEIGHT,
+                                  REFTERM_FONT_PARTITION_COUNT*Terminal->REFTERM_FONT_TEXTURE_PAGES);
+            SetD3D11GlyphTransferDim(&Terminal->Renderer, Terminal->TransferWidth, Terminal->TransferHeight);
+
+            // NOTE: Whatever the partitions had in the old glyph cache texture is gone
+            ReleaseFontPartitions(Terminal, 0);
             RefreshFont(Terminal);
         }
         if(Terminal->Renderer.Device)
@@ -1667,9 +2234,9 @@ static DWORD WINAPI TerminalThread(LPVOID Param)
             if(Terminal->NoThrottle)
             {
                 glyph_table_stats Stats = GetAndClearStats(Terminal->GlyphTable);
-                wsprintfW(Title, L"refterm Size=%dx%d RenderFPS=%d.%02d CacheHits/Misses=%d/%d Recycle:%d",
+                wsprintfW(Title, L"refterm Size=%dx%d RenderFPS=%d.%02d CacheHits/Misses=%d/%d Recycle:%d Overflow:%d",
                               Terminal->ScreenBuffer.DimX, Terminal->ScreenBuffer.DimY, (int)FramesPerSec, (int)(FramesPerSec*100) % 100,
-                              (int)Stats.HitCount, (int)Stats.MissCount, (int)Stats.RecycleCount);
+                              (int)Stats.HitCount, (int)Stats.MissCount, (int)Stats.RecycleCount, (int)Stats.OverflowCount);
             }
             else
             {
@@ -1680,6 +2247,8 @@ static DWORD WINAPI TerminalThread(LPVOID Param)
         }
     }
 
+    ReleaseFontPartitions(Terminal, 1);
+
     DWriteRelease(&Terminal->GlyphGen);
     ReleaseD3D11Renderer(&Terminal->Renderer);
 
@@ -22,13 +22,6 @@ typedef struct
     int32_t X, Y;
 } terminal_point;
 
-typedef struct
-{
-    uint32_t Foreground;
-    uint32_t Background;
-    uint32_t Flags;
-} glyph_props;
-
 typedef struct
 {
     terminal_point At;
@@ -40,16 +33,73 @@ typedef struct
 {
     kbts_break_state BreakState;
     DWORD SegP[1026];
+    size_t SegByte[1026];
     uint32_t SegmentCount;
 } kb_partitioner;
 
 typedef struct
 {
-    size_t FirstP;
-    size_t OnePastLastP;
-    uint32_t ContainsComplexChars;
-    glyph_props StartingProps;
-} example_line;
+    // NOTE: UTF8Count == 0 means this run is a single codepoint that was already resolved to a
+    // tile, either a reserved ASCII one or one from the glyph table's codepoint page table
+    gpu_glyph_index DirectIndex;
+    char *UTF8; // NOTE: Points straight into the source buffer, which doesn't move during a parse
+    uint32_t UTF8Count;
+    uint32_t HashIndex;
+} glyph_run;
+
+/* NOTE: Runs are gathered here so they can be hashed with one ComputeGlyphHashes call and
+   their glyph table lookups issued as one FindGlyphEntriesByHashBatch call, instead of
+   one dependent chain of AES rounds and one dependent cache miss at a time.
+   The states returned by the batch have to survive the misses of the runs resolved
+   before them, which they do because LayoutLines pins everything looked up in a frame.
+   Runs are hashed from their UTF-8, and only converted to UTF-16 (into UTF16, one run at
+   a time) when DirectWrite actually has to size or rasterize them. */
+#define MaxGlyphRunBatch 256
+typedef struct
+{
+    uint32_t RunCount;
+    uint32_t HashCount;
+    int DebugToggle;
+    glyph_run Runs[MaxGlyphRunBatch];
+    glyph_hash_input HashInputs[MaxGlyphRunBatch];
+    glyph_hash Hashes[MaxGlyphRunBatch];
+    glyph_state States[MaxGlyphRunBatch];
+    wchar_t UTF16[1024];
+} glyph_run_batch;
+
+/* NOTE: What a scrollback file keeps besides the output itself (see OpenScrollBackFile), in
+   the source_buffer's extra bytes, followed by the line index's chunks and props.  The
+   terminal's Lines point right into the file, so they are saved as they are parsed, and
+   reopening the file doesn't parse anything. */
+typedef struct
+{
+    line_index_state Lines;
+    cursor_state RunningCursor;
+} scrollback_file_state;
+
+#define MinDirectCodepoint 32
+#define MaxDirectCodepoint 126
+
+/* NOTE: Each font configuration that has been set up recently keeps its own glyph table
+   (and reserved ASCII tiles) on its own pages of the one glyph cache texture, so switching
+   back to it with font/fontsize doesn't have to rasterize anything.  The cells of different
+   fonts are different sizes, so they can't share a tile grid - which table a glyph is in
+   is what tells the fonts apart, rather than anything in its hash. */
+#define REFTERM_FONT_PARTITION_COUNT 4
+typedef struct
+{
+    glyph_snapshot_key Key; // NOTE: Which font this partition is set up for, all zero if it isn't
+    void *GlyphTableMem;
+    glyph_table *GlyphTable;
+    gpu_glyph_index ReservedTileTable[MaxDirectCodepoint - MinDirectCodepoint + 1];
+    uint32_t FirstPage;
+    uint32_t LastUsed;
+    uint64_t SeedTime; // NOTE: When the table's hash seed was made, 0 if it never got one (see SaveGlyphSnapshot)
+
+    // NOTE: The glyph_generator's miss counters while this partition wasn't the current one
+    size_t SizeCount;
+    size_t RasterizeCount;
+} font_partition;
 
 typedef struct
 {
@@ -57,14 +107,28 @@ typedef struct
     int Quit;
 
     d3d11_renderer Renderer;
+    d3d11_shader_code ShaderCode;
     glyph_generator GlyphGen;
-    void *GlyphTableMem;
-    glyph_table *GlyphTable;
+    glyph_table *GlyphTable; // NOTE: The current font partition's
+    font_partition FontPartitions[REFTERM_FONT_PARTITION_COUNT];
+    uint32_t FontPartitionIndex;
+    uint32_t FontPartitionClock;
     terminal_buffer ScreenBuffer;
     source_buffer ScrollBackBuffer;
+    cold_scrollback ColdScrollBack; // NOTE: What has fallen off the back of ScrollBackBuffer, compressed
     kb_partitioner KBPartitioner;
+    glyph_run_batch RunBatch;
 
     DWORD PipeSize;
+    int ScrollBackHugePages; // NOTE: Ask for huge pages for the scrollback, which falls back to ordinary ones if they can't be had
+    size_t ScrollBackFileSize; // NOTE: How big "scrollback <file>" makes a new file
+
+    // NOTE: Backpressure on the child's output, see GetChildWritableRange
+    int FlowControl;
+    size_t OldestNeededP; // NOTE: The oldest scrollback byte the last LayoutLines read, or the start of the line being parsed
+    size_t StallCount; // NOTE: Times output from the child had to wait for the screen to catch up
+    int64_t StallStart; // NOTE: QueryPerformanceCounter at the start of the current stall, 0 when not stalled
+    int64_t StallTicks;
 
     HANDLE Legacy_WriteStdIn;
     HANDLE Legacy_ReadStdOut;
@@ -86,10 +150,10 @@ typedef struct
     int NoThrottle;
     int DebugHighlighting;
 
-    uint32_t MaxLineCount;
-    uint32_t CurrentLineIndex;
-    uint32_t LineCount;
-    example_line *Lines;
+    // NOTE: Room for MaxLineChunkCount*LINE_CHUNK_SIZE lines, and MaxLinePropsCount distinct props at their starts
+    uint32_t MaxLineChunkCount;
+    uint32_t MaxLinePropsCount;
+    line_index Lines;
 
     int32_t ViewingLineOffset;
 
@@ -102,6 +166,7 @@ typedef struct
 
     uint32_t REFTERM_TEXTURE_WIDTH;
     uint32_t REFTERM_TEXTURE_HEIGHT;
+    uint32_t REFTERM_FONT_TEXTURE_PAGES; // NOTE: Pages of REFTERM_TEXTURE_WIDTH x REFTERM_TEXTURE_HEIGHT each font partition may grow to
 
     uint32_t TransferWidth;
     uint32_t TransferHeight;
@@ -109,8 +174,7 @@ typedef struct
     uint32_t REFTERM_MAX_WIDTH;
     uint32_t REFTERM_MAX_HEIGHT;
 
-#define MinDirectCodepoint 32
-#define MaxDirectCodepoint 126
+    // NOTE: A copy of the current font partition's
     gpu_glyph_index ReservedTileTable[MaxDirectCodepoint - MinDirectCodepoint + 1];
 } example_terminal;
 
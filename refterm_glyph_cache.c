@@ -5,6 +5,12 @@
 
 #define DEBUG_VALIDATE_LRU 0
 
+#if _MSC_VER
+#define GlyphTableAtomicExchange(Dest, Value) _InterlockedExchange((Dest), (Value))
+#else
+#define GlyphTableAtomicExchange(Dest, Value) __atomic_exchange_n((Dest), (Value), __ATOMIC_SEQ_CST)
+#endif
+
 struct glyph_entry
 {
     glyph_hash HashValue;
@@ -13,6 +19,8 @@ struct glyph_entry
     uint32_t NextLRU;
     uint32_t PrevLRU;
     gpu_glyph_index GPUIndex;
+    uint32_t Flags;
+    uint32_t LastFrame; // NOTE: The frame this entry was last looked up in, see BeginGlyphTableFrame
 
     // NOTE(casey): For user use:
     uint32_t FilledState;
@@ -24,25 +32,123 @@ struct glyph_entry
 #endif
 };
 
+enum
+{
+    GlyphEntry_Referenced = 0x1, // NOTE: Only for GlyphTableEviction_Clock
+    GlyphEntry_InWindow = 0x2, // NOTE: Only for GlyphTableAdmission_TinyLFU
+};
+
+// NOTE: With GlyphTableAdmission_TinyLFU, entry 1 is reserved as the sentinel of the window LRU chain
+#define GLYPH_WINDOW_SENTINEL 1
+
+struct glyph_slot
+{
+    // NOTE: EntryIndex 0 is the sentinel, so it doubles as the "empty slot" marker
+    glyph_hash HashValue;
+    uint32_t EntryIndex;
+};
+
+struct glyph_front_entry
+{
+    glyph_hash HashValue;
+    glyph_state State;
+    uint32_t Generation; // NOTE: Only good while this matches the table's FrontGeneration
+};
+
+struct glyph_span_class
+{
+    // NOTE: The entries of a span class are the ones after its sentinel, up to the next class's sentinel
+    uint32_t TileCount;
+    uint32_t SentinelIndex;
+};
+
 struct glyph_table
 {
-    glyph_table_stats Stats;
+    glyph_table_stats Stats; // NOTE: Only ever counts up, see GetAndClearStats
 
     uint32_t HashMask;
     uint32_t HashCount;
-    uint32_t EntryCount;
-
-    uint32_t *HashTable;
+    uint32_t MaxHashCount; // NOTE: How far HashCount can grow, see BeginHashTableGrow
+    uint32_t HashedCount; // NOTE: How many entries are in the hash table right now
+    uint32_t RehashCount; // NOTE: The HashCount before the current grow, or zero if it isn't growing
+    uint32_t RehashNext; // NOTE: The next slot of the old HashCount to split
+    uint32_t EntryCount; // NOTE: Only the single-tile entries
+    uint32_t TotalEntryCount; // NOTE: The single-tile entries, then each span class's sentinel and entries
+    uint32_t Layout;
+    uint32_t Eviction;
+    uint32_t MaxChainLength; // NOTE: See TrimHashChain
+    uint32_t ClockHand; // NOTE: Only for GlyphTableEviction_Clock
+    uint32_t CurrentFrame; // NOTE: Zero until the first BeginGlyphTableFrame, which means nothing is pinned
+
+    // NOTE: Only for GlyphTableAdmission_TinyLFU
+    uint32_t Admission;
+    uint32_t WindowCount;
+    uint32_t WindowMax;
+    uint32_t SketchMask;
+    uint32_t SketchSampleCount;
+    uint32_t SketchResetCount;
+    uint8_t *Sketch;
+
+    uint32_t *HashTable; // NOTE: Only for GlyphTableLayout_Chained
+    glyph_slot *Slots; // NOTE: Only for GlyphTableLayout_OpenAddressed
     glyph_entry *Entries;
 
+    // NOTE: Only with a FrontCacheCount
+    uint32_t FrontMask;
+    uint32_t FrontGeneration;
+    glyph_front_entry *Front;
+
+    // NOTE: Only with a DirectPageCount, see FindGlyphEntryByCodepoint
+    uint32_t DirectPageCount;
+    uint32_t DirectPagesUsed;
+    uint16_t *DirectPageTable; // NOTE: One page number per high byte of a BMP codepoint, 0 until that page is first used
+    uint32_t *DirectPages; // NOTE: DirectPageCount pages of 256 entry indices, page number N is at (N - 1)*256
+    uint16_t *DirectCodepoints; // NOTE: Per entry, the codepoint mapped to it, or 0
+
+    uint32_t SpanClassCount;
+    glyph_span_class SpanClasses[GLYPH_TABLE_MAX_SPAN_CLASS_COUNT];
+
+    /* NOTE: A sharded table is just an array of complete tables ("shards"), each
+       with its own lock.  The top-level table only has ShardCount/Shards filled in.
+       Each shard has ShardCount == 0, and IDBase is added to its entry indices to
+       make IDs that are unique across the whole table. */
+    uint32_t ShardCount;
+    uint32_t ShardMask;
+    uint32_t EntriesPerShard;
+    uint32_t IDBase;
+    glyph_table **Shards;
+    volatile long Lock;
+
+    glyph_table_stats ReportedStats; // NOTE: What Stats was at the last GetAndClearStats, only read there
+
+    // NOTE: Only the top-level table's is used, since the hashes are picked before the shard is
+    char unsigned HashSeed[16];
+
 #if DEBUG_VALIDATE_LRU
     uint32_t LastLRUCount;
 #endif
 };
 
-static gpu_glyph_index PackGlyphCachePoint(uint32_t X, uint32_t Y)
+static gpu_glyph_index PackGlyphCachePoint(uint32_t X, uint32_t Y, uint32_t Page)
+{
+    Assert(X < 4096);
+    Assert(Y < 4096);
+    Assert(Page < 256);
+    gpu_glyph_index Result = {(Page << 24) | (Y << 12) | X};
+    return Result;
+}
+
+static gpu_glyph_index PackGlyphTablePoint(glyph_table_params Params, uint32_t X, uint32_t Y)
 {
-    gpu_glyph_index Result = {(Y << 16) | X};
+    // NOTE: Y counts rows across every page, so split it into the page and the row on that page
+    uint32_t Page = Params.FirstCachePage;
+    if(Params.CacheTileCountInY)
+    {
+        Page += Y / Params.CacheTileCountInY;
+        Y = Y % Params.CacheTileCountInY;
+    }
+
+    gpu_glyph_index Result = PackGlyphCachePoint(X, Y, Page);
     return Result;
 }
 
@@ -50,8 +156,9 @@ static glyph_cache_point UnpackGlyphCachePoint(gpu_glyph_index P)
 {
     glyph_cache_point Result;
 
-    Result.X = (P.Value & 0xffff);
-    Result.Y = (P.Value >> 16);
+    Result.X = (P.Value & 0xfff);
+    Result.Y = ((P.Value >> 12) & 0xfff);
+    Result.Page = (P.Value >> 24);
 
     return Result;
 }
@@ -64,48 +171,336 @@ static int GlyphHashesAreEqual(glyph_hash A, glyph_hash B)
     return Result;
 }
 
-static uint32_t *GetSlotPointer(glyph_table *Table, glyph_hash RunHash)
+static uint32_t GetHomeSlotIndex(glyph_table *Table, glyph_hash RunHash)
 {
     uint32_t HashIndex = _mm_cvtsi128_si32(RunHash.Value);
-    uint32_t HashSlot = (HashIndex & Table->HashMask);
+    uint32_t Result = (HashIndex & Table->HashMask);
+    if(Table->RehashCount)
+    {
+        // NOTE: While growing, slots that haven't been split yet still hold the entries of both halves
+        uint32_t OldIndex = (HashIndex & (Table->RehashCount - 1));
+        if(OldIndex >= Table->RehashNext)
+        {
+            Result = OldIndex;
+        }
+    }
+
+    Assert(Result < Table->HashCount);
+    return Result;
+}
 
-    Assert(HashSlot < Table->HashCount);
-    uint32_t *Result = &Table->HashTable[HashSlot];
+static uint32_t *GetSlotPointer(glyph_table *Table, glyph_hash RunHash)
+{
+    Assert(Table->Layout == GlyphTableLayout_Chained);
+    uint32_t *Result = &Table->HashTable[GetHomeSlotIndex(Table, RunHash)];
 
     return Result;
 }
 
+static uint32_t FindOpenSlotIndex(glyph_table *Table, glyph_hash RunHash)
+{
+    // NOTE: Returns either the slot holding RunHash, or the empty slot that ends its probe sequence
+    Assert(Table->Layout == GlyphTableLayout_OpenAddressed);
+
+    uint32_t SlotIndex = GetHomeSlotIndex(Table, RunHash);
+    for(;;)
+    {
+        glyph_slot *Slot = Table->Slots + SlotIndex;
+        if(!Slot->EntryIndex ||
+           GlyphHashesAreEqual(Slot->HashValue, RunHash))
+        {
+            break;
+        }
+
+        SlotIndex = (SlotIndex + 1) & Table->HashMask;
+    }
+
+    return SlotIndex;
+}
+
+static void RemoveOpenSlot(glyph_table *Table, uint32_t SlotIndex)
+{
+    /* NOTE: This is backward-shift deletion, so the table never needs tombstones.
+       Every slot after the hole in the same probe run is moved back into the hole
+       unless that would put it in front of its own home slot. */
+
+    uint32_t HashMask = Table->HashMask;
+    uint32_t Hole = SlotIndex;
+    uint32_t Next = (Hole + 1) & HashMask;
+    for(;;)
+    {
+        glyph_slot *Slot = Table->Slots + Next;
+        if(!Slot->EntryIndex)
+        {
+            break;
+        }
+
+        uint32_t Home = GetHomeSlotIndex(Table, Slot->HashValue);
+        if(((Next - Home) & HashMask) >= ((Next - Hole) & HashMask))
+        {
+            Table->Slots[Hole] = *Slot;
+            Hole = Next;
+        }
+
+        Next = (Next + 1) & HashMask;
+    }
+
+    Table->Slots[Hole].EntryIndex = 0;
+}
+
 static glyph_entry *GetEntry(glyph_table *Table, uint32_t Index)
 {
-    Assert(Index < Table->EntryCount);
+    Assert(Index < Table->TotalEntryCount);
     glyph_entry *Result = Table->Entries + Index;
     return Result;
 }
 
+static glyph_span_class *GetSpanClassForEntry(glyph_table *Table, uint32_t EntryIndex)
+{
+    // NOTE: Returns 0 for single-tile entries
+    glyph_span_class *Result = 0;
+    for(uint32_t ClassIndex = 0; ClassIndex < Table->SpanClassCount; ++ClassIndex)
+    {
+        if(Table->SpanClasses[ClassIndex].SentinelIndex < EntryIndex)
+        {
+            Result = Table->SpanClasses + ClassIndex;
+        }
+    }
+
+    return Result;
+}
+
+static glyph_span_class *GetSpanClassForTileCount(glyph_table *Table, uint32_t TileCount)
+{
+    // NOTE: Returns the smallest spans that fit TileCount tiles, or 0 if there aren't any
+    glyph_span_class *Result = 0;
+    for(uint32_t ClassIndex = 0; ClassIndex < Table->SpanClassCount; ++ClassIndex)
+    {
+        if(Table->SpanClasses[ClassIndex].TileCount >= TileCount)
+        {
+            Result = Table->SpanClasses + ClassIndex;
+            break;
+        }
+    }
+
+    return Result;
+}
+
+static uint32_t GetFreeChainIndex(glyph_table *Table, uint32_t EntryIndex)
+{
+    // NOTE: Single-tile entries are on entry 0's free chain, spans on their class sentinel's
+    glyph_span_class *Class = GetSpanClassForEntry(Table, EntryIndex);
+    uint32_t Result = Class ? Class->SentinelIndex : 0;
+    return Result;
+}
+
+static uint32_t GetEntryTileSpan(glyph_table *Table, uint32_t EntryIndex)
+{
+    glyph_span_class *Class = GetSpanClassForEntry(Table, EntryIndex);
+    uint32_t Result = Class ? Class->TileCount : 1;
+    return Result;
+}
+
+static int UsesLRUChain(glyph_table *Table, uint32_t EntryIndex)
+{
+    // NOTE: Spans are always kept in LRU order, whatever the single-tile entries use
+    int Result = ((Table->Eviction != GlyphTableEviction_Clock) || (EntryIndex >= Table->EntryCount));
+    return Result;
+}
+
 static glyph_entry *GetSentinel(glyph_table *Table)
 {
     glyph_entry *Result = Table->Entries;
     return Result;
 }
 
+static int IsPinned(glyph_table *Table, glyph_entry *Entry)
+{
+    // NOTE: Entries looked up during the current frame may still be drawn this frame, so they can't be recycled
+    int Result = (Table->CurrentFrame && (Entry->LastFrame == Table->CurrentFrame));
+    return Result;
+}
+
+static void LockShard(glyph_table *Shard)
+{
+    while(GlyphTableAtomicExchange(&Shard->Lock, 1))
+    {
+        while(Shard->Lock)
+        {
+            _mm_pause();
+        }
+    }
+}
+
+static void UnlockShard(glyph_table *Shard)
+{
+    GlyphTableAtomicExchange(&Shard->Lock, 0);
+}
+
+static glyph_table *GetShardForHash(glyph_table *Table, glyph_hash RunHash)
+{
+    // NOTE: The slot index comes from the low 32 bits, so use the next 32 to pick the shard
+    uint32_t ShardIndex = (_mm_cvtsi128_si32(_mm_srli_si128(RunHash.Value, 4)) & Table->ShardMask);
+    glyph_table *Result = Table->Shards[ShardIndex];
+    return Result;
+}
+
+static glyph_table *GetShardForID(glyph_table *Table, uint32_t ID)
+{
+    // NOTE: The last shard gets any leftover entries, so it can be bigger than EntriesPerShard
+    uint32_t ShardIndex = ID / Table->EntriesPerShard;
+    if(ShardIndex >= Table->ShardCount)
+    {
+        ShardIndex = Table->ShardCount - 1;
+    }
+
+    glyph_table *Result = Table->Shards[ShardIndex];
+    return Result;
+}
+
+static void AddGlyphTableStats(glyph_table_stats *Dest, glyph_table_stats *Source, int Sign)
+{
+    // NOTE: Every field of glyph_table_stats is a size_t counter, so they can all be done at once
+    size_t *DestCounts = (size_t *)Dest;
+    size_t *SourceCounts = (size_t *)Source;
+    for(size_t CountIndex = 0; CountIndex < (sizeof(glyph_table_stats) / sizeof(size_t)); ++CountIndex)
+    {
+        DestCounts[CountIndex] += (Sign < 0) ? (0 - SourceCounts[CountIndex]) : SourceCounts[CountIndex];
+    }
+}
+
+static glyph_table_stats GetGlyphTableStatsDelta(glyph_table_stats Newer, glyph_table_stats Older)
+{
+    glyph_table_stats Result = Newer;
+    AddGlyphTableStats(&Result, &Older, -1);
+    return Result;
+}
+
+static glyph_table_stats GetGlyphTableStats(glyph_table *Table)
+{
+    glyph_table_stats Result = {0};
+    if(Table->ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Table->ShardCount; ++ShardIndex)
+        {
+            glyph_table *Shard = Table->Shards[ShardIndex];
+
+            LockShard(Shard);
+            glyph_table_stats ShardStats = Shard->Stats;
+            UnlockShard(Shard);
+
+            AddGlyphTableStats(&Result, &ShardStats, 1);
+        }
+    }
+    else
+    {
+        Result = Table->Stats;
+    }
+
+    return Result;
+}
+
+static glyph_table_stats GetAndClearShardStats(glyph_table *Shard)
+{
+    // NOTE: The counters never actually reset, so GetGlyphTableStats users aren't affected
+    glyph_table_stats Result = GetGlyphTableStatsDelta(Shard->Stats, Shard->ReportedStats);
+    Shard->ReportedStats = Shard->Stats;
+
+    return Result;
+}
+
 static glyph_table_stats GetAndClearStats(glyph_table *Table)
 {
-    glyph_table_stats Result = Table->Stats;
-    glyph_table_stats ZeroStats = {0};
-    Table->Stats = ZeroStats;
+    glyph_table_stats Result = {0};
+    if(Table->ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Table->ShardCount; ++ShardIndex)
+        {
+            glyph_table *Shard = Table->Shards[ShardIndex];
+
+            LockShard(Shard);
+            glyph_table_stats ShardStats = GetAndClearShardStats(Shard);
+            UnlockShard(Shard);
+
+            AddGlyphTableStats(&Result, &ShardStats, 1);
+        }
+    }
+    else
+    {
+        Result = GetAndClearShardStats(Table);
+    }
 
     return Result;
 }
 
-static void UpdateGlyphCacheEntry(glyph_table *Table, uint32_t ID, uint32_t NewState, uint16_t NewDimX, uint16_t NewDimY)
+static void InvalidateFrontCache(glyph_table *Table)
+{
+    // NOTE: Every front slot was stored with an older generation now, so none of them match
+    if(!++Table->FrontGeneration)
+    {
+        // NOTE: After a wrap, slots from 2^32 generations ago would match again, so clear them
+        // for real.  Generation 0 is never used, so cleared slots never match.
+        if(Table->Front)
+        {
+            memset(Table->Front, 0, (Table->FrontMask + 1)*sizeof(glyph_front_entry));
+        }
+        Table->FrontGeneration = 1;
+    }
+}
+
+static glyph_front_entry *GetFrontSlot(glyph_table *Table, glyph_hash RunHash)
+{
+    glyph_front_entry *Result = Table->Front + (_mm_cvtsi128_si32(RunHash.Value) & Table->FrontMask);
+    return Result;
+}
+
+static int IsFrontHit(glyph_table *Table, glyph_front_entry *Front, glyph_hash RunHash)
+{
+    int Result = ((Front->Generation == Table->FrontGeneration) &&
+                  GlyphHashesAreEqual(Front->HashValue, RunHash));
+    return Result;
+}
+
+static void UpdateShardEntry(glyph_table *Shard, uint32_t Index, uint32_t NewState, uint16_t NewDimX, uint16_t NewDimY)
 {
-    glyph_entry *Entry = GetEntry(Table, ID);
+    glyph_entry *Entry = GetEntry(Shard, Index);
+
+    // NOTE: This is also how FreeEntry clears entries, so it covers every recycle too.  Only the
+    // front slot the entry's hash picks can hold it, so only that one has to go.
+    if(Shard->Front)
+    {
+        glyph_front_entry *Front = GetFrontSlot(Shard, Entry->HashValue);
+        if(Front->State.ID == (Shard->IDBase + Index))
+        {
+            Front->Generation = 0;
+        }
+    }
 
     Entry->FilledState = NewState;
     Entry->DimX = NewDimX;
     Entry->DimY = NewDimY;
 }
 
+static void UpdateGlyphCacheEntry(glyph_table *Table, uint32_t ID, uint32_t NewState, uint16_t NewDimX, uint16_t NewDimY)
+{
+    if(!ID)
+    {
+        // NOTE: This is the atlas overflow state, which has no entry to update
+    }
+    else if(Table->ShardCount)
+    {
+        glyph_table *Shard = GetShardForID(Table, ID);
+
+        LockShard(Shard);
+        UpdateShardEntry(Shard, ID - Shard->IDBase, NewState, NewDimX, NewDimY);
+        UnlockShard(Shard);
+    }
+    else
+    {
+        UpdateShardEntry(Table, ID, NewState, NewDimX, NewDimY);
+    }
+}
+
 #if DEBUG_VALIDATE_LRU
 static void ValidateLRU(glyph_table *Table, int ExpectedCountChange)
 {
@@ -134,108 +529,722 @@ static void ValidateLRU(glyph_table *Table, int ExpectedCountChange)
 #define ValidateLRU(...)
 #endif
 
-static void RecycleLRU(glyph_table *Table)
+static void UnlinkLRU(glyph_table *Table, uint32_t EntryIndex)
 {
-    glyph_entry *Sentinel = GetSentinel(Table);
-
-    // NOTE(casey): There are no more unused entries, evict the least recently used one
-    Assert(Sentinel->PrevLRU);
-
-    // NOTE(casey): Remove least recently used element from the LRU chain
-    uint32_t EntryIndex = Sentinel->PrevLRU;
     glyph_entry *Entry = GetEntry(Table, EntryIndex);
     glyph_entry *Prev = GetEntry(Table, Entry->PrevLRU);
-    Prev->NextLRU = 0;
-    Sentinel->PrevLRU = Entry->PrevLRU;
-    ValidateLRU(Table, -1);
+    glyph_entry *Next = GetEntry(Table, Entry->NextLRU);
 
-    // NOTE(casey): Find the location of this entry in its hash chain
-    uint32_t *NextIndex = GetSlotPointer(Table, Entry->HashValue);
-    while(*NextIndex != EntryIndex)
-    {
-        Assert(*NextIndex);
-        NextIndex = &GetEntry(Table, *NextIndex)->NextWithSameHash;
-    }
+    Prev->NextLRU = Entry->NextLRU;
+    Next->PrevLRU = Entry->PrevLRU;
+}
 
-    // NOTE(casey): Remove least recently used element from its hash chain, and place it on the free chain
-    Assert(*NextIndex == EntryIndex);
-    *NextIndex = Entry->NextWithSameHash;
-    Entry->NextWithSameHash = Sentinel->NextWithSameHash;
-    Sentinel->NextWithSameHash = EntryIndex;
+static void LinkLRUAtFront(glyph_table *Table, uint32_t SentinelIndex, uint32_t EntryIndex)
+{
+    // NOTE: The sentinel is the main LRU chain's (entry 0), or the admission window's
+    glyph_entry *Sentinel = GetEntry(Table, SentinelIndex);
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+    Entry->NextLRU = Sentinel->NextLRU;
+    Entry->PrevLRU = SentinelIndex;
 
-    // NOTE(casey): Clear the index count and state
-    UpdateGlyphCacheEntry(Table, EntryIndex, 0, 0, 0);
+    glyph_entry *NextLRU = GetEntry(Table, Sentinel->NextLRU);
+    NextLRU->PrevLRU = EntryIndex;
+    Sentinel->NextLRU = EntryIndex;
+}
 
-    ++Table->Stats.RecycleCount;
+static uint8_t *GetSketchCounter(glyph_table *Table, glyph_hash RunHash, uint32_t Row)
+{
+    /* NOTE: The low 64 bits of the hash already pick the slot and the shard, so the
+       sketch rows are indexed with the high 64 bits instead, double-hashing style. */
+    uint32_t A = _mm_cvtsi128_si32(_mm_srli_si128(RunHash.Value, 8));
+    uint32_t B = _mm_cvtsi128_si32(_mm_srli_si128(RunHash.Value, 12)) | 1;
+
+    uint32_t Width = Table->SketchMask + 1;
+    uint8_t *Result = Table->Sketch + Row*Width + ((A + Row*B) & Table->SketchMask);
+    return Result;
 }
 
-static uint32_t PopFreeEntry(glyph_table *Table)
+#define GLYPH_SKETCH_ROW_COUNT 4
+#define GLYPH_SKETCH_MAX_COUNT 15
+
+static void IncrementSketch(glyph_table *Table, glyph_hash RunHash, int WasHit)
 {
-    glyph_entry *Sentinel = GetSentinel(Table);
+    for(uint32_t Row = 0; Row < GLYPH_SKETCH_ROW_COUNT; ++Row)
+    {
+        uint8_t *Counter = GetSketchCounter(Table, RunHash, Row);
+        if(*Counter < GLYPH_SKETCH_MAX_COUNT)
+        {
+            ++*Counter;
+        }
+    }
 
-    if(!Sentinel->NextWithSameHash)
+    /* NOTE: Halve every counter periodically so the sketch follows what is on screen _now_.
+       Only hits count towards this, because a scan of one-off glyphs is all misses, and if
+       it aged the sketch, the glyphs it's supposed to protect would look stale by the end of it. */
+    Table->SketchSampleCount += (WasHit ? 1 : 0);
+    if(Table->SketchSampleCount >= Table->SketchResetCount)
     {
-        RecycleLRU(Table);
+        uint32_t SketchSize = GLYPH_SKETCH_ROW_COUNT*(Table->SketchMask + 1);
+        for(uint32_t CounterIndex = 0; CounterIndex < SketchSize; ++CounterIndex)
+        {
+            Table->Sketch[CounterIndex] >>= 1;
+        }
+        Table->SketchSampleCount /= 2;
     }
+}
 
-    uint32_t Result = Sentinel->NextWithSameHash;
-    Assert(Result);
+static uint32_t EstimateFrequency(glyph_table *Table, glyph_hash RunHash)
+{
+    uint32_t Result = GLYPH_SKETCH_MAX_COUNT;
+    for(uint32_t Row = 0; Row < GLYPH_SKETCH_ROW_COUNT; ++Row)
+    {
+        uint32_t Count = *GetSketchCounter(Table, RunHash, Row);
+        if(Result > Count)
+        {
+            Result = Count;
+        }
+    }
 
-    // NOTE(casey): Pop this unused entry off the sentinel's chain of unused entries
-    glyph_entry *Entry = GetEntry(Table, Result);
-    Sentinel->NextWithSameHash = Entry->NextWithSameHash;
-    Entry->NextWithSameHash = 0;
+    return Result;
+}
 
-    Assert(Entry);
-    Assert(Entry != Sentinel);
-    Assert(Entry->DimX == 0);
-    Assert(Entry->DimY == 0);
-    Assert(Entry->FilledState == 0);
-    Assert(Entry->NextWithSameHash == 0);
-    Assert(Entry == GetEntry(Table, Result));
+static uint32_t *GetDirectSlot(glyph_table *Table, uint32_t Codepoint, int Allocate)
+{
+    // NOTE: Two levels - the high byte picks a page, the low byte the slot in it.  Pages are
+    // handed out the first time a codepoint in them is mapped, and stay until the table is placed again.
+    uint32_t *Result = 0;
+    if(Table->DirectPageTable && (Codepoint < 0x10000))
+    {
+        uint16_t *PageNumber = Table->DirectPageTable + (Codepoint >> 8);
+        if(!*PageNumber && Allocate && (Table->DirectPagesUsed < Table->DirectPageCount))
+        {
+            *PageNumber = (uint16_t)++Table->DirectPagesUsed;
+            memset(Table->DirectPages + 256*(*PageNumber - 1), 0, 256*sizeof(uint32_t));
+        }
+
+        if(*PageNumber)
+        {
+            Result = Table->DirectPages + 256*(*PageNumber - 1) + (Codepoint & 0xff);
+        }
+    }
 
     return Result;
 }
 
-static glyph_state FindGlyphEntryByHash(glyph_table *Table, glyph_hash RunHash)
+static void FreeEntry(glyph_table *Table, uint32_t EntryIndex)
 {
-    glyph_entry *Result = 0;
+    // NOTE: The caller must already have taken the entry out of its LRU chain, if it is in one
+    glyph_entry *Sentinel = GetEntry(Table, GetFreeChainIndex(Table, EntryIndex));
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
 
-    uint32_t *Slot = GetSlotPointer(Table, RunHash);
-    uint32_t EntryIndex = *Slot;
-    while(EntryIndex)
+    if(Table->Layout == GlyphTableLayout_OpenAddressed)
     {
-        glyph_entry *Entry = GetEntry(Table, EntryIndex);
-        if(GlyphHashesAreEqual(Entry->HashValue, RunHash))
+        // NOTE: Remove the element from the hash slots
+        uint32_t SlotIndex = FindOpenSlotIndex(Table, Entry->HashValue);
+        Assert(Table->Slots[SlotIndex].EntryIndex == EntryIndex);
+        RemoveOpenSlot(Table, SlotIndex);
+    }
+    else
+    {
+        // NOTE(casey): Find the location of this entry in its hash chain
+        uint32_t *NextIndex = GetSlotPointer(Table, Entry->HashValue);
+        while(*NextIndex != EntryIndex)
         {
-            Result = Entry;
-            break;
+            Assert(*NextIndex);
+            NextIndex = &GetEntry(Table, *NextIndex)->NextWithSameHash;
         }
 
-        EntryIndex = Entry->NextWithSameHash;
+        // NOTE(casey): Remove the element from its hash chain
+        Assert(*NextIndex == EntryIndex);
+        *NextIndex = Entry->NextWithSameHash;
     }
+    --Table->HashedCount;
 
-    if(Result)
+    // NOTE: Whatever tile the codepoint pointed at is about to hold something else
+    if(Table->DirectCodepoints && Table->DirectCodepoints[EntryIndex])
     {
-        Assert(EntryIndex);
+        uint32_t *DirectSlot = GetDirectSlot(Table, Table->DirectCodepoints[EntryIndex], 0);
+        Assert(DirectSlot && (*DirectSlot == EntryIndex));
+        *DirectSlot = 0;
+        Table->DirectCodepoints[EntryIndex] = 0;
+    }
 
-        // NOTE(casey): An existing entry was found, remove it from the LRU
-        glyph_entry *Prev = GetEntry(Table, Result->PrevLRU);
-        glyph_entry *Next = GetEntry(Table, Result->NextLRU);
+    // NOTE(casey): Place it on the free chain
+    Entry->NextWithSameHash = Sentinel->NextWithSameHash;
+    Sentinel->NextWithSameHash = EntryIndex;
+
+    // NOTE(casey): Clear the index count and state
+    UpdateShardEntry(Table, EntryIndex, 0, 0, 0);
+}
+
+static uint32_t GetHistogramBucket(uint32_t Value, uint32_t BucketCount)
+{
+    // NOTE: 0 goes in bucket 0, and then each bucket is twice as wide as the one before it
+    uint32_t Result = 0;
+    while(Value && (Result < (BucketCount - 1)))
+    {
+        Value >>= 1;
+        ++Result;
+    }
+
+    return Result;
+}
+
+static void RecycleEntry(glyph_table *Table, uint32_t EntryIndex)
+{
+    uint32_t Age = Table->CurrentFrame - GetEntry(Table, EntryIndex)->LastFrame;
+    ++Table->Stats.EvictionAgeHistogram[GetHistogramBucket(Age, GLYPH_TABLE_AGE_HISTOGRAM_COUNT)];
+
+    FreeEntry(Table, EntryIndex);
+    ++Table->Stats.RecycleCount;
+}
+
+static void RecycleLRU(glyph_table *Table, uint32_t SentinelIndex)
+{
+    // NOTE: The sentinel is the main LRU chain's (entry 0), or a span class's
+    glyph_entry *Sentinel = GetEntry(Table, SentinelIndex);
+
+    // NOTE(casey): There are no more unused entries, evict the least recently used one
+    uint32_t EntryIndex = Sentinel->PrevLRU;
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
 
-        Prev->NextLRU = Result->NextLRU;
-        Next->PrevLRU = Result->PrevLRU;
+    // NOTE: If even the least recently used entry was used this frame, they all were, so there's nothing to
+    // evict.  (The chain can also only be empty here if the admission window holds every entry.)
+    if((EntryIndex == SentinelIndex) || IsPinned(Table, Entry))
+    {
+        return;
+    }
 
+    // NOTE(casey): Remove least recently used element from the LRU chain
+    glyph_entry *Prev = GetEntry(Table, Entry->PrevLRU);
+    Prev->NextLRU = SentinelIndex;
+    Sentinel->PrevLRU = Entry->PrevLRU;
+    if(!SentinelIndex)
+    {
         ValidateLRU(Table, -1);
+    }
+
+    RecycleEntry(Table, EntryIndex);
+}
+
+static void RecycleClock(glyph_table *Table)
+{
+    /* NOTE: There are no more unused entries, so every entry but the sentinel is in the
+       table.  Sweep the hand until it finds one that hasn't been referenced since the last
+       time the hand passed it.  The hand clears every reference bit it passes, so this
+       finds one within two full turns - unless every entry is pinned by the current frame,
+       in which case it gives up. */
+    uint32_t EntryIndex = Table->ClockHand;
+    uint32_t StepsLeft = 2*(Table->EntryCount - 1);
+    int Found = 0;
+    while(StepsLeft--)
+    {
+        if(EntryIndex >= Table->EntryCount)
+        {
+            EntryIndex = 1;
+        }
 
-        ++Table->Stats.HitCount;
+        glyph_entry *Entry = GetEntry(Table, EntryIndex);
+        if(!IsPinned(Table, Entry))
+        {
+            if(!(Entry->Flags & GlyphEntry_Referenced))
+            {
+                Found = 1;
+                break;
+            }
+
+            Entry->Flags &= ~GlyphEntry_Referenced;
+        }
+
+        ++EntryIndex;
+    }
+
+    Table->ClockHand = EntryIndex + 1;
+    if(Found)
+    {
+        RecycleEntry(Table, EntryIndex);
+    }
+}
+
+static void MakeRoomWithAdmission(glyph_table *Table)
+{
+    /* NOTE: New entries always go into the small admission window first, so a glyph that
+       was just looked up can always be drawn.  Once the window is full, its least recently
+       used entry has to move into the main LRU chain.  While there are unused entries that's
+       free, but once the table is full it would have to push out the main chain's least
+       recently used entry, so it only gets in if the sketch says it has been looked up more
+       often than that entry.  Otherwise it's dropped.  So a flood of one-off glyphs just
+       cycles through the window and never touches the main chain. */
+    glyph_entry *Window = GetEntry(Table, GLYPH_WINDOW_SENTINEL);
+    glyph_entry *Sentinel = GetSentinel(Table);
+
+    // NOTE: If the window's least recently used entry is pinned, the whole window is, so it
+    // just has to grow past WindowMax until the next frame.
+    if((Table->WindowCount >= Table->WindowMax) &&
+       !IsPinned(Table, GetEntry(Table, Window->PrevLRU)))
+    {
+        uint32_t CandidateIndex = Window->PrevLRU;
+        glyph_entry *Candidate = GetEntry(Table, CandidateIndex);
+        Assert(CandidateIndex != GLYPH_WINDOW_SENTINEL);
+        Assert(Candidate->Flags & GlyphEntry_InWindow);
+
+        UnlinkLRU(Table, CandidateIndex);
+        Candidate->Flags &= ~GlyphEntry_InWindow;
+        --Table->WindowCount;
+
+        int Admit = 1;
+        if(!Sentinel->NextWithSameHash)
+        {
+            uint32_t VictimIndex = Sentinel->PrevLRU;
+            glyph_entry *Victim = GetEntry(Table, VictimIndex);
+            Admit = (VictimIndex && !IsPinned(Table, Victim) &&
+                     (EstimateFrequency(Table, Candidate->HashValue) > EstimateFrequency(Table, Victim->HashValue)));
+        }
+
+        if(Admit)
+        {
+            LinkLRUAtFront(Table, 0, CandidateIndex);
+#if DEBUG_VALIDATE_LRU
+            Candidate->Ordering = Sentinel->Ordering++;
+#endif
+            ValidateLRU(Table, 1);
+            ++Table->Stats.AdmissionCount;
+
+            if(!Sentinel->NextWithSameHash)
+            {
+                RecycleLRU(Table, 0);
+            }
+        }
+        else
+        {
+            RecycleEntry(Table, CandidateIndex);
+            ++Table->Stats.RejectedAdmissionCount;
+        }
+    }
+    else if(!Sentinel->NextWithSameHash)
+    {
+        RecycleLRU(Table, 0);
+    }
+}
+
+static uint32_t PopFreeEntry(glyph_table *Table)
+{
+    glyph_entry *Sentinel = GetSentinel(Table);
+
+    if(Table->Admission == GlyphTableAdmission_TinyLFU)
+    {
+        MakeRoomWithAdmission(Table);
+    }
+    else if(!Sentinel->NextWithSameHash)
+    {
+        if(Table->Eviction == GlyphTableEviction_Clock)
+        {
+            RecycleClock(Table);
+        }
+        else
+        {
+            RecycleLRU(Table, 0);
+        }
+    }
+
+    // NOTE: Returns 0 if every entry is pinned by the current frame, which is an atlas overflow
+    uint32_t Result = Sentinel->NextWithSameHash;
+    if(!Result)
+    {
+        ++Table->Stats.OverflowCount;
+        return(Result);
+    }
+
+    // NOTE(casey): Pop this unused entry off the sentinel's chain of unused entries
+    glyph_entry *Entry = GetEntry(Table, Result);
+    Sentinel->NextWithSameHash = Entry->NextWithSameHash;
+    Entry->NextWithSameHash = 0;
+
+    Assert(Entry);
+    Assert(Entry != Sentinel);
+    Assert(Entry->DimX == 0);
+    Assert(Entry->DimY == 0);
+    Assert(Entry->FilledState == 0);
+    Assert(Entry->NextWithSameHash == 0);
+    Assert(Entry == GetEntry(Table, Result));
+
+    return Result;
+}
+
+static void BeginGlyphTableFrame(glyph_table *Table)
+{
+    if(Table->ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Table->ShardCount; ++ShardIndex)
+        {
+            glyph_table *Shard = Table->Shards[ShardIndex];
+
+            LockShard(Shard);
+            BeginGlyphTableFrame(Shard);
+            UnlockShard(Shard);
+        }
+    }
+    else
+    {
+        // NOTE: Frame 0 means "no frames", so skip it when the counter wraps
+        if(!++Table->CurrentFrame)
+        {
+            ++Table->CurrentFrame;
+        }
+
+        // NOTE: A front hit skips pinning, so front slots can only be good for the frame they were stored in
+        InvalidateFrontCache(Table);
+    }
+}
+
+static int IsGlyphAtlasOverflow(glyph_state State)
+{
+    int Result = (State.ID == 0);
+    return Result;
+}
+
+#define GLYPH_TABLE_GROW_CHAIN_LENGTH 2
+#define GLYPH_TABLE_REHASH_STEP_COUNT 4
+
+static void BeginHashTableGrow(glyph_table *Table)
+{
+    /* NOTE: This is linear-hashing style growth.  The slot array already has room for
+       MaxHashCount slots, so doubling HashCount just starts using the upper half.  The
+       entries of old slot N belong in either slot N or slot N + RehashCount of the doubled
+       table, depending on one more hash bit, and they get split between the two a few
+       slots per lookup (see StepHashTableGrow).  Until slot N is split, lookups that map
+       to either of them keep using slot N, so there's never a full rehash. */
+    Assert(Table->Layout == GlyphTableLayout_Chained);
+    Assert(!Table->RehashCount);
+
+    Table->RehashCount = Table->HashCount;
+    Table->RehashNext = 0;
+    Table->HashCount *= 2;
+    Table->HashMask = Table->HashCount - 1;
+
+    ++Table->Stats.GrowCount;
+}
+
+static void StepHashTableGrow(glyph_table *Table)
+{
+    for(uint32_t StepIndex = 0;
+        (StepIndex < GLYPH_TABLE_REHASH_STEP_COUNT) && Table->RehashCount;
+        ++StepIndex)
+    {
+        // NOTE: Keeps the order of the chain, so the two halves are still most-recently-inserted first
+        uint32_t SlotIndex = Table->RehashNext;
+        uint32_t *Low = &Table->HashTable[SlotIndex];
+        uint32_t *High = &Table->HashTable[SlotIndex + Table->RehashCount];
+        uint32_t EntryIndex = *Low;
+        while(EntryIndex)
+        {
+            glyph_entry *Entry = GetEntry(Table, EntryIndex);
+            uint32_t HashIndex = _mm_cvtsi128_si32(Entry->HashValue.Value);
+            if(HashIndex & Table->RehashCount)
+            {
+                *High = EntryIndex;
+                High = &Entry->NextWithSameHash;
+            }
+            else
+            {
+                *Low = EntryIndex;
+                Low = &Entry->NextWithSameHash;
+            }
+
+            EntryIndex = Entry->NextWithSameHash;
+        }
+        *Low = 0;
+        *High = 0;
+
+        if(++Table->RehashNext == Table->RehashCount)
+        {
+            Table->RehashCount = 0;
+            Table->RehashNext = 0;
+        }
+    }
+}
+
+static uint32_t FindEntryIndex(glyph_table *Table, glyph_hash RunHash, uint32_t **SlotResult, uint32_t *ProbeLengthResult)
+{
+    // NOTE: Returns 0 if RunHash isn't in the table.  For the chained layout, SlotResult gets
+    // the hash slot, so a miss can link a new entry into it.  ProbeLengthResult gets the number
+    // of stored hashes that were compared against RunHash.
+    uint32_t *Slot = 0;
+    uint32_t Result = 0;
+    uint32_t ProbeLength = 0;
+    if(Table->Layout == GlyphTableLayout_OpenAddressed)
+    {
+        // NOTE: The hash compare happens in the slot itself, so only a hit touches an entry
+        uint32_t SlotIndex = FindOpenSlotIndex(Table, RunHash);
+        Result = Table->Slots[SlotIndex].EntryIndex;
+        ProbeLength = ((SlotIndex - GetHomeSlotIndex(Table, RunHash)) & Table->HashMask) + (Result ? 1 : 0);
+    }
+    else
+    {
+        if(Table->RehashCount)
+        {
+            StepHashTableGrow(Table);
+        }
+
+        Slot = GetSlotPointer(Table, RunHash);
+        uint32_t EntryIndex = *Slot;
+        while(EntryIndex)
+        {
+            glyph_entry *Entry = GetEntry(Table, EntryIndex);
+            ++ProbeLength;
+            if(GlyphHashesAreEqual(Entry->HashValue, RunHash))
+            {
+                Result = EntryIndex;
+                break;
+            }
+
+            EntryIndex = Entry->NextWithSameHash;
+        }
+    }
+
+    *SlotResult = Slot;
+    *ProbeLengthResult = ProbeLength;
+    return Result;
+}
+
+static void InsertEntryIndex(glyph_table *Table, uint32_t *Slot, glyph_hash RunHash, uint32_t EntryIndex)
+{
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+    Entry->HashValue = RunHash;
+
+    if(Table->Layout == GlyphTableLayout_OpenAddressed)
+    {
+        // NOTE: Recycling an entry may have shifted slots around since the lookup,
+        // so the empty slot has to be found again.
+        glyph_slot *OpenSlot = Table->Slots + FindOpenSlotIndex(Table, RunHash);
+        Assert(OpenSlot->EntryIndex == 0);
+        OpenSlot->HashValue = RunHash;
+        OpenSlot->EntryIndex = EntryIndex;
+    }
+    else
+    {
+        Entry->NextWithSameHash = *Slot;
+        *Slot = EntryIndex;
+    }
+    ++Table->HashedCount;
+
+    // NOTE: Start growing once the chains get long on average (and the last grow is done)
+    if(!Table->RehashCount &&
+       (Table->HashCount < Table->MaxHashCount) &&
+       (Table->HashedCount > GLYPH_TABLE_GROW_CHAIN_LENGTH*Table->HashCount))
+    {
+        BeginHashTableGrow(Table);
+    }
+}
+
+static glyph_state GetEntryState(glyph_table *Table, uint32_t EntryIndex)
+{
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+
+    glyph_state State;
+    State.ID = Table->IDBase + EntryIndex;
+    State.DimX = Entry->DimX;
+    State.DimY = Entry->DimY;
+    State.GPUIndex = Entry->GPUIndex;
+    State.TileSpan = GetEntryTileSpan(Table, EntryIndex);
+    State.FilledState = Entry->FilledState;
+
+    return State;
+}
+
+static uint32_t UnlinkHitEntry(glyph_table *Table, uint32_t EntryIndex)
+{
+    // NOTE: Counts the hit and takes the entry out of its LRU chain (or just marks it referenced),
+    // and returns which chain it goes back to the front of - the main one, the admission window,
+    // or a span class's
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+
+    uint32_t ChainIndex;
+    if(Entry->Flags & GlyphEntry_InWindow)
+    {
+        ChainIndex = GLYPH_WINDOW_SENTINEL;
+    }
+    else
+    {
+        ChainIndex = GetFreeChainIndex(Table, EntryIndex);
+    }
+
+    if(!UsesLRUChain(Table, EntryIndex))
+    {
+        // NOTE: Don't write the bit if it's already set, so hits on hot entries stay read-only
+        if(!(Entry->Flags & GlyphEntry_Referenced))
+        {
+            Entry->Flags |= GlyphEntry_Referenced;
+        }
+    }
+    else
+    {
+        // NOTE(casey): An existing entry was found, remove it from the LRU
+        UnlinkLRU(Table, EntryIndex);
+        ValidateLRU(Table, ChainIndex ? 0 : -1);
+    }
+
+    ++Table->Stats.HitCount;
+
+    return ChainIndex;
+}
+
+static void RelinkLookedUpEntry(glyph_table *Table, uint32_t EntryIndex, uint32_t ChainIndex)
+{
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+
+    // NOTE: Only write this once per frame, so repeated hits in a frame stay read-only
+    if(Entry->LastFrame != Table->CurrentFrame)
+    {
+        Entry->LastFrame = Table->CurrentFrame;
+    }
+
+    if(UsesLRUChain(Table, EntryIndex))
+    {
+        // NOTE(casey): Update the LRU doubly-linked list to ensure this entry is now "first"
+        Assert(Entry != GetSentinel(Table));
+        LinkLRUAtFront(Table, ChainIndex, EntryIndex);
+
+#if DEBUG_VALIDATE_LRU
+        glyph_entry *Sentinel = GetSentinel(Table);
+        Entry->Ordering = Sentinel->Ordering++;
+#endif
+        ValidateLRU(Table, ChainIndex ? 0 : 1);
+    }
+}
+
+static void RemoveHashedEntry(glyph_table *Table, uint32_t EntryIndex)
+{
+    // NOTE: Takes the entry out of whatever LRU chain it is in, and gives it back
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+    if(UsesLRUChain(Table, EntryIndex))
+    {
+        UnlinkLRU(Table, EntryIndex);
+        if(Entry->Flags & GlyphEntry_InWindow)
+        {
+            --Table->WindowCount;
+        }
+        else if(!GetFreeChainIndex(Table, EntryIndex))
+        {
+            ValidateLRU(Table, -1);
+        }
+    }
+    Entry->Flags = 0;
+
+    FreeEntry(Table, EntryIndex);
+}
+
+static uint32_t PickChainVictim(glyph_table *Table, uint32_t EntryIndex, uint32_t VictimIndex)
+{
+    // NOTE: Whichever of the two was looked up longer ago, preferring EntryIndex on a tie, since
+    // it comes later in the chain, which means it was inserted earlier.  Pinned entries never win.
+    glyph_entry *Entry = GetEntry(Table, EntryIndex);
+    uint32_t Result = VictimIndex;
+    if(!IsPinned(Table, Entry))
+    {
+        if(!VictimIndex ||
+           ((Table->CurrentFrame - Entry->LastFrame) >= (Table->CurrentFrame - GetEntry(Table, VictimIndex)->LastFrame)))
+        {
+            Result = EntryIndex;
+        }
+    }
+
+    return Result;
+}
+
+static void TrimHashChain(glyph_table *Table, glyph_hash RunHash, uint32_t *Slot)
+{
+    /* NOTE: RunHash is about to go into a chain (or probe run) that is already MaxChainLength
+       long.  With a random seed, that is next to impossible by chance, so it is most likely text
+       made to collide, and letting the chain grow would make every lookup in it slower.  So the
+       entry in it that was looked up longest ago makes room instead - unless they are all pinned
+       by the current frame, in which case the chain just grows. */
+    uint32_t VictimIndex = 0;
+    if(Table->Layout == GlyphTableLayout_OpenAddressed)
+    {
+        for(uint32_t SlotIndex = GetHomeSlotIndex(Table, RunHash);
+            Table->Slots[SlotIndex].EntryIndex;
+            SlotIndex = (SlotIndex + 1) & Table->HashMask)
+        {
+            VictimIndex = PickChainVictim(Table, Table->Slots[SlotIndex].EntryIndex, VictimIndex);
+        }
+    }
+    else
+    {
+        for(uint32_t EntryIndex = *Slot;
+            EntryIndex;
+            EntryIndex = GetEntry(Table, EntryIndex)->NextWithSameHash)
+        {
+            VictimIndex = PickChainVictim(Table, EntryIndex, VictimIndex);
+        }
+    }
+
+    if(VictimIndex)
+    {
+        uint32_t Age = Table->CurrentFrame - GetEntry(Table, VictimIndex)->LastFrame;
+        ++Table->Stats.EvictionAgeHistogram[GetHistogramBucket(Age, GLYPH_TABLE_AGE_HISTOGRAM_COUNT)];
+
+        RemoveHashedEntry(Table, VictimIndex);
+        ++Table->Stats.ChainEvictionCount;
+    }
+}
+
+static glyph_state FindShardEntryByHash(glyph_table *Table, glyph_hash RunHash)
+{
+    // NOTE: A table that isn't sharded is its own (only) shard, so it goes straight here.
+    glyph_front_entry *Front = 0;
+    if(Table->Front)
+    {
+        Front = GetFrontSlot(Table, RunHash);
+        if(IsFrontHit(Table, Front, RunHash))
+        {
+            ++Table->Stats.HitCount;
+            ++Table->Stats.FrontHitCount;
+            return(Front->State);
+        }
+    }
+
+    uint32_t *Slot = 0;
+    uint32_t ProbeLength = 0;
+    uint32_t EntryIndex = FindEntryIndex(Table, RunHash, &Slot, &ProbeLength);
+    glyph_entry *Result = EntryIndex ? GetEntry(Table, EntryIndex) : 0;
+
+    uint32_t ProbeBucket = ProbeLength;
+    if(ProbeBucket >= GLYPH_TABLE_PROBE_HISTOGRAM_COUNT)
+    {
+        ProbeBucket = GLYPH_TABLE_PROBE_HISTOGRAM_COUNT - 1;
+    }
+    ++Table->Stats.ProbeLengthHistogram[ProbeBucket];
+
+    if(Table->Admission == GlyphTableAdmission_TinyLFU)
+    {
+        IncrementSketch(Table, RunHash, (Result != 0));
+    }
+
+    // NOTE: Which LRU chain the entry goes to the front of - the main one, the admission window, or a span class's
+    uint32_t ChainIndex = 0;
+    if(Result)
+    {
+        Assert(EntryIndex);
+        ChainIndex = UnlinkHitEntry(Table, EntryIndex);
     }
     else
     {
         // NOTE(casey): No existing entry was found, allocate a new one and link it into the hash chain
 
+        ++Table->Stats.MissCount;
+        if(ProbeLength >= Table->MaxChainLength)
+        {
+            // NOTE: A miss compared against the whole chain, so ProbeLength is its length
+            TrimHashChain(Table, RunHash, Slot);
+        }
+
         EntryIndex = PopFreeEntry(Table);
-        Assert(EntryIndex);
+        if(!EntryIndex)
+        {
+            glyph_state Overflow = {0};
+            return(Overflow);
+        }
 
         Result = GetEntry(Table, EntryIndex);
         Assert(Result->FilledState == 0);
@@ -243,36 +1252,438 @@ static glyph_state FindGlyphEntryByHash(glyph_table *Table, glyph_hash RunHash)
         Assert(Result->DimX == 0);
         Assert(Result->DimY == 0);
         
-        Result->NextWithSameHash = *Slot;
-        Result->HashValue = RunHash;
-        *Slot = EntryIndex;
+        // NOTE: New entries start unreferenced, so a glyph that is never used again is the first
+        // thing the clock hand takes, but it still survives until the hand comes all the way around.
+        Result->Flags = 0;
+        if(Table->Admission == GlyphTableAdmission_TinyLFU)
+        {
+            Result->Flags |= GlyphEntry_InWindow;
+            ChainIndex = GLYPH_WINDOW_SENTINEL;
+            ++Table->WindowCount;
+        }
+
+        InsertEntryIndex(Table, Slot, RunHash, EntryIndex);
+    }
+
+    RelinkLookedUpEntry(Table, EntryIndex, ChainIndex);
+
+    glyph_state State = GetEntryState(Table, EntryIndex);
+    if(Front)
+    {
+        Front->HashValue = RunHash;
+        Front->State = State;
+        Front->Generation = Table->FrontGeneration;
+    }
+
+    return State;
+}
+
+static glyph_state FindShardSpanByHash(glyph_table *Table, glyph_hash RunHash, uint32_t TileCount)
+{
+    uint32_t *Slot = 0;
+    uint32_t ProbeLength = 0;
+    uint32_t OldIndex = FindEntryIndex(Table, RunHash, &Slot, &ProbeLength);
+    glyph_span_class *Class = GetSpanClassForTileCount(Table, TileCount);
+    if(!Class || (OldIndex && (GetEntryTileSpan(Table, OldIndex) >= TileCount)))
+    {
+        return(FindShardEntryByHash(Table, RunHash));
+    }
+
+    if(!OldIndex && (ProbeLength >= Table->MaxChainLength))
+    {
+        TrimHashChain(Table, RunHash, Slot);
+    }
+
+    glyph_entry *Sentinel = GetEntry(Table, Class->SentinelIndex);
+    if(!Sentinel->NextWithSameHash)
+    {
+        RecycleLRU(Table, Class->SentinelIndex);
+    }
+
+    // NOTE: If every span of this size is in use this frame, the glyph just stays where it is
+    uint32_t SpanIndex = Sentinel->NextWithSameHash;
+    if(!SpanIndex)
+    {
+        return(FindShardEntryByHash(Table, RunHash));
+    }
+
+    glyph_entry *Span = GetEntry(Table, SpanIndex);
+    Sentinel->NextWithSameHash = Span->NextWithSameHash;
+    Span->NextWithSameHash = 0;
+    Assert(Span->FilledState == 0);
+
+    if(OldIndex)
+    {
+        RemoveHashedEntry(Table, OldIndex);
+    }
+
+    InsertEntryIndex(Table, Slot, RunHash, SpanIndex);
+    Span->Flags = 0;
+    Span->LastFrame = Table->CurrentFrame;
+    LinkLRUAtFront(Table, Class->SentinelIndex, SpanIndex);
+
+    ++Table->Stats.SpanCount;
+
+    glyph_state State = GetEntryState(Table, SpanIndex);
+    return State;
+}
+
+static glyph_state FindGlyphEntryByHash(glyph_table *Table, glyph_hash RunHash)
+{
+    glyph_state Result;
+    if(Table->ShardCount)
+    {
+        glyph_table *Shard = GetShardForHash(Table, RunHash);
+
+        LockShard(Shard);
+        Result = FindShardEntryByHash(Shard, RunHash);
+        UnlockShard(Shard);
+    }
+    else
+    {
+        Result = FindShardEntryByHash(Table, RunHash);
+    }
+
+    return Result;
+}
+
+static glyph_state FindGlyphSpanByHash(glyph_table *Table, glyph_hash RunHash, uint32_t TileCount)
+{
+    glyph_state Result;
+    if(Table->ShardCount)
+    {
+        glyph_table *Shard = GetShardForHash(Table, RunHash);
+
+        LockShard(Shard);
+        Result = FindShardSpanByHash(Shard, RunHash, TileCount);
+        UnlockShard(Shard);
+    }
+    else
+    {
+        Result = FindShardSpanByHash(Table, RunHash, TileCount);
+    }
+
+    return Result;
+}
+
+static int FindGlyphEntryByCodepoint(glyph_table *Table, uint32_t Codepoint, uint32_t FilledState, glyph_state *Result)
+{
+    // NOTE: Sharded tables have no page table, since the shard depends on the hash.  An entry
+    // that isn't in FilledState yet is left exactly as it was, since the caller is about to
+    // look it up by hash anyway, and that lookup is the one that should count.
+    int Found = 0;
+
+    uint32_t *DirectSlot = GetDirectSlot(Table, Codepoint, 0);
+    uint32_t EntryIndex = DirectSlot ? *DirectSlot : 0;
+    glyph_entry *Entry = EntryIndex ? GetEntry(Table, EntryIndex) : 0;
+    if(Entry && (Entry->FilledState == FilledState))
+    {
+        Assert(Table->DirectCodepoints[EntryIndex] == Codepoint);
+
+        // NOTE: The same bookkeeping as a hit in FindShardEntryByHash, so the entry is pinned and
+        // counts towards admission just the same
+        if(Table->Admission == GlyphTableAdmission_TinyLFU)
+        {
+            IncrementSketch(Table, Entry->HashValue, 1);
+        }
+        uint32_t ChainIndex = UnlinkHitEntry(Table, EntryIndex);
+        RelinkLookedUpEntry(Table, EntryIndex, ChainIndex);
+        ++Table->Stats.DirectHitCount;
+
+        *Result = GetEntryState(Table, EntryIndex);
+        Found = 1;
+    }
+
+    return Found;
+}
+
+static void MapGlyphCodepoint(glyph_table *Table, uint32_t Codepoint, uint32_t ID)
+{
+    // NOTE: Codepoint 0 is what an unmapped entry has, so it can't be mapped.  A codepoint that
+    // already maps to some other entry, or an entry that already has some other codepoint, is
+    // left alone - FreeEntry can only undo one mapping per entry.
+    uint32_t *DirectSlot = (Codepoint && ID) ? GetDirectSlot(Table, Codepoint, 1) : 0;
+    if(DirectSlot && !*DirectSlot && !Table->DirectCodepoints[ID])
+    {
+        Assert(GetEntryTileSpan(Table, ID) == 1);
+
+        *DirectSlot = ID;
+        Table->DirectCodepoints[ID] = (uint16_t)Codepoint;
+    }
+}
+
+static gpu_glyph_index GetGlyphSpanTile(glyph_state State, uint32_t TileIndex)
+{
+    // NOTE: Span tiles never straddle a row, so this is just a step in X
+    Assert(TileIndex < State.TileSpan);
+    glyph_cache_point Point = UnpackGlyphCachePoint(State.GPUIndex);
+    gpu_glyph_index Result = PackGlyphCachePoint(Point.X + TileIndex, Point.Y, Point.Page);
+    return Result;
+}
+
+static void FindGlyphEntriesByHashBatch(glyph_table *Table, uint32_t Count, glyph_hash *Hashes, glyph_state *States)
+{
+    /* NOTE: This does group prefetching.  For each group of lookups, first every home slot
+       is prefetched, then every slot is read and the entry it points at is prefetched, and
+       only then are the lookups actually resolved, so the cache misses of the whole group
+       overlap instead of being taken one after another.
+
+       Lookups the front cache can answer are answered as they come, before they are grouped,
+       so every lookup in a group is one that needs its slot and entry - a front slot that
+       looked good when the group was gathered could have been taken by an earlier lookup of
+       the same group by the time it was resolved, and then nothing was prefetched for it.
+
+       The slots (and front cache slots) are read without taking the shard lock, which is
+       fine because the worst a stale slot can do is prefetch the wrong entry, or skip a
+       prefetch that was needed, and front hits are checked again under the lock. */
+
+#define GLYPH_BATCH_GROUP_SIZE 16
+    uint32_t GroupIndices[GLYPH_BATCH_GROUP_SIZE];
+    char *SlotPointers[GLYPH_BATCH_GROUP_SIZE];
+
+    uint32_t NextIndex = 0;
+    while(NextIndex < Count)
+    {
+        uint32_t GroupCount = 0;
+        while((NextIndex < Count) && (GroupCount < GLYPH_BATCH_GROUP_SIZE))
+        {
+            uint32_t Index = NextIndex++;
+            glyph_table *Shard = Table->ShardCount ? GetShardForHash(Table, Hashes[Index]) : Table;
+            if(Shard->Front && IsFrontHit(Shard, GetFrontSlot(Shard, Hashes[Index]), Hashes[Index]))
+            {
+                States[Index] = FindGlyphEntryByHash(Table, Hashes[Index]);
+            }
+            else
+            {
+                uint32_t SlotIndex = GetHomeSlotIndex(Shard, Hashes[Index]);
+                char *Slot = (Shard->Layout == GlyphTableLayout_OpenAddressed) ?
+                    (char *)(Shard->Slots + SlotIndex) : (char *)(Shard->HashTable + SlotIndex);
+                _mm_prefetch(Slot, _MM_HINT_T0);
+
+                GroupIndices[GroupCount] = Index;
+                SlotPointers[GroupCount] = Slot;
+                ++GroupCount;
+            }
+        }
+
+        for(uint32_t GroupIndex = 0; GroupIndex < GroupCount; ++GroupIndex)
+        {
+            uint32_t Index = GroupIndices[GroupIndex];
+            glyph_table *Shard = Table->ShardCount ? GetShardForHash(Table, Hashes[Index]) : Table;
+            uint32_t EntryIndex = (Shard->Layout == GlyphTableLayout_OpenAddressed) ?
+                ((glyph_slot *)SlotPointers[GroupIndex])->EntryIndex : *(uint32_t *)SlotPointers[GroupIndex];
+            if(EntryIndex && (EntryIndex < Shard->TotalEntryCount))
+            {
+                // NOTE: Entries aren't cache-line aligned, so make sure both lines are on the way
+                char *Entry = (char *)GetEntry(Shard, EntryIndex);
+                _mm_prefetch(Entry, _MM_HINT_T0);
+                _mm_prefetch(Entry + sizeof(glyph_entry) - 1, _MM_HINT_T0);
+            }
+        }
+
+        for(uint32_t GroupIndex = 0; GroupIndex < GroupCount; ++GroupIndex)
+        {
+            uint32_t Index = GroupIndices[GroupIndex];
+            States[Index] = FindGlyphEntryByHash(Table, Hashes[Index]);
+        }
+    }
+}
+
+static int IsSentinelIndex(glyph_table *Table, uint32_t EntryIndex)
+{
+    int Result = ((EntryIndex == 0) ||
+                  ((Table->Admission == GlyphTableAdmission_TinyLFU) && (EntryIndex == GLYPH_WINDOW_SENTINEL)));
+    for(uint32_t ClassIndex = 0; ClassIndex < Table->SpanClassCount; ++ClassIndex)
+    {
+        if(Table->SpanClasses[ClassIndex].SentinelIndex == EntryIndex)
+        {
+            Result = 1;
+        }
+    }
+
+    return Result;
+}
+
+static uint32_t SaveShardEntry(glyph_table *Shard, uint32_t EntryIndex, uint32_t Count, glyph_snapshot_entry *Entries)
+{
+    // NOTE: Entries that were never filled in have nothing worth keeping
+    glyph_entry *Entry = GetEntry(Shard, EntryIndex);
+    if(Entry->FilledState)
+    {
+        glyph_snapshot_entry *Dest = Entries + Count++;
+        Dest->HashValue = Entry->HashValue;
+        Dest->ID = Shard->IDBase + EntryIndex;
+        Dest->FilledState = Entry->FilledState;
+        Dest->DimX = Entry->DimX;
+        Dest->DimY = Entry->DimY;
+        Dest->Reserved = 0;
+    }
+
+    return Count;
+}
+
+static uint32_t SaveShardChain(glyph_table *Shard, uint32_t SentinelIndex, uint32_t Count, uint32_t MaxCount, glyph_snapshot_entry *Entries)
+{
+    // NOTE: Walks from the least recently used end, so loading them in order puts them back in the same order
+    glyph_entry *Sentinel = GetEntry(Shard, SentinelIndex);
+    for(uint32_t EntryIndex = Sentinel->PrevLRU;
+        (EntryIndex != SentinelIndex) && (Count < MaxCount);
+        EntryIndex = GetEntry(Shard, EntryIndex)->PrevLRU)
+    {
+        Count = SaveShardEntry(Shard, EntryIndex, Count, Entries);
+    }
+
+    return Count;
+}
+
+static uint32_t SaveShardSnapshot(glyph_table *Shard, uint32_t Count, uint32_t MaxCount, glyph_snapshot_entry *Entries)
+{
+    if(Shard->Eviction == GlyphTableEviction_Clock)
+    {
+        // NOTE: CLOCK entries aren't in any order, so they just go in index order
+        for(uint32_t EntryIndex = 1; (EntryIndex < Shard->EntryCount) && (Count < MaxCount); ++EntryIndex)
+        {
+            Count = SaveShardEntry(Shard, EntryIndex, Count, Entries);
+        }
+    }
+    else
+    {
+        // NOTE: The window goes after the main chain, since its entries are the newest
+        Count = SaveShardChain(Shard, 0, Count, MaxCount, Entries);
+        if(Shard->Admission == GlyphTableAdmission_TinyLFU)
+        {
+            Count = SaveShardChain(Shard, GLYPH_WINDOW_SENTINEL, Count, MaxCount, Entries);
+        }
+    }
+
+    for(uint32_t ClassIndex = 0; ClassIndex < Shard->SpanClassCount; ++ClassIndex)
+    {
+        Count = SaveShardChain(Shard, Shard->SpanClasses[ClassIndex].SentinelIndex, Count, MaxCount, Entries);
+    }
+
+    return Count;
+}
+
+static uint32_t SaveGlyphTableSnapshot(glyph_table *Table, uint32_t MaxCount, glyph_snapshot_entry *Entries)
+{
+    uint32_t Result = 0;
+    if(Table->ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Table->ShardCount; ++ShardIndex)
+        {
+            glyph_table *Shard = Table->Shards[ShardIndex];
+
+            LockShard(Shard);
+            Result = SaveShardSnapshot(Shard, Result, MaxCount, Entries);
+            UnlockShard(Shard);
+        }
+    }
+    else
+    {
+        Result = SaveShardSnapshot(Table, Result, MaxCount, Entries);
+    }
 
-        ++Table->Stats.MissCount;
+    return Result;
+}
+
+static int LoadShardSnapshotEntry(glyph_table *Shard, glyph_snapshot_entry *Source)
+{
+    // NOTE: The file may be stale or damaged, so anything that doesn't fit is just skipped
+    uint32_t EntryIndex = Source->ID - Shard->IDBase;
+    if((Source->ID < Shard->IDBase) ||
+       (EntryIndex >= Shard->TotalEntryCount) ||
+       IsSentinelIndex(Shard, EntryIndex) ||
+       (Source->FilledState == 0))
+    {
+        return(0);
     }
 
-    // NOTE(casey): Update the LRU doubly-linked list to ensure this entry is now "first"
-    glyph_entry *Sentinel = GetSentinel(Table);
-    Assert(Result != Sentinel);
-    Result->NextLRU = Sentinel->NextLRU;
-    Result->PrevLRU = 0;
+    glyph_entry *Entry = GetEntry(Shard, EntryIndex);
+    uint32_t *Slot = 0;
+    uint32_t ProbeLength = 0;
+    if(Entry->FilledState || FindEntryIndex(Shard, Source->HashValue, &Slot, &ProbeLength))
+    {
+        return(0);
+    }
 
-    glyph_entry *NextLRU = GetEntry(Table, Sentinel->NextLRU);
-    NextLRU->PrevLRU = EntryIndex;
-    Sentinel->NextLRU = EntryIndex;
+    // NOTE: This overwrites the entry's link in its free chain, so the free chains are rebuilt afterwards
+    InsertEntryIndex(Shard, Slot, Source->HashValue, EntryIndex);
+    Entry->Flags = 0;
+    Entry->LastFrame = 0;
+    UpdateShardEntry(Shard, EntryIndex, Source->FilledState, Source->DimX, Source->DimY);
 
+    if(UsesLRUChain(Shard, EntryIndex))
+    {
+        // NOTE: Single-tile entries all go in the main chain, they have already earned their place
+        uint32_t ChainIndex = GetFreeChainIndex(Shard, EntryIndex);
+        LinkLRUAtFront(Shard, ChainIndex, EntryIndex);
+        if(!ChainIndex)
+        {
 #if DEBUG_VALIDATE_LRU
-    Result->Ordering = Sentinel->Ordering++;
+            Entry->Ordering = GetSentinel(Shard)->Ordering++;
 #endif
-    ValidateLRU(Table, 1);
+            ValidateLRU(Shard, 1);
+        }
+    }
 
-    glyph_state State;
-    State.ID = EntryIndex;
-    State.DimX = Result->DimX;
-    State.DimY = Result->DimY;
-    State.GPUIndex = Result->GPUIndex;
-    State.FilledState = Result->FilledState;
+    return(1);
+}
 
-    return State;
+static void RebuildShardFreeChains(glyph_table *Shard)
+{
+    // NOTE: Backwards, so each free chain ends up in index order, like a freshly placed table's
+    for(uint32_t ChainIndex = 0; ChainIndex <= Shard->SpanClassCount; ++ChainIndex)
+    {
+        uint32_t SentinelIndex = ChainIndex ? Shard->SpanClasses[ChainIndex - 1].SentinelIndex : 0;
+        GetEntry(Shard, SentinelIndex)->NextWithSameHash = 0;
+    }
+
+    for(uint32_t EntryIndex = Shard->TotalEntryCount - 1; EntryIndex > 0; --EntryIndex)
+    {
+        glyph_entry *Entry = GetEntry(Shard, EntryIndex);
+        if(!IsSentinelIndex(Shard, EntryIndex) && !Entry->FilledState)
+        {
+            glyph_entry *Sentinel = GetEntry(Shard, GetFreeChainIndex(Shard, EntryIndex));
+            Entry->NextWithSameHash = Sentinel->NextWithSameHash;
+            Sentinel->NextWithSameHash = EntryIndex;
+        }
+    }
+}
+
+static uint32_t LoadGlyphTableSnapshot(glyph_table *Table, uint32_t Count, glyph_snapshot_entry *Entries)
+{
+    uint32_t Result = 0;
+    if(Table->ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Table->ShardCount; ++ShardIndex)
+        {
+            glyph_table *Shard = Table->Shards[ShardIndex];
+
+            LockShard(Shard);
+            for(uint32_t EntryIndex = 0; EntryIndex < Count; ++EntryIndex)
+            {
+                // NOTE: An entry can only live in the shard its hash picks
+                glyph_snapshot_entry *Source = Entries + EntryIndex;
+                if((GetShardForHash(Table, Source->HashValue) == Shard) &&
+                   (Source->ID < (Shard->IDBase + Shard->TotalEntryCount)))
+                {
+                    Result += LoadShardSnapshotEntry(Shard, Source);
+                }
+            }
+            RebuildShardFreeChains(Shard);
+            UnlockShard(Shard);
+        }
+    }
+    else
+    {
+        for(uint32_t EntryIndex = 0; EntryIndex < Count; ++EntryIndex)
+        {
+            Result += LoadShardSnapshotEntry(Table, Entries + EntryIndex);
+        }
+        RebuildShardFreeChains(Table);
+    }
+
+    return Result;
 }
 
 static void InitializeDirectGlyphTable(glyph_table_params Params, gpu_glyph_index *Table, int SkipZeroSlot)
@@ -296,62 +1707,530 @@ static void InitializeDirectGlyphTable(glyph_table_params Params, gpu_glyph_inde
             ++Y;
         }
 
-        Table[EntryIndex] = PackGlyphCachePoint(X, Y);
+        Table[EntryIndex] = PackGlyphTablePoint(Params, X, Y);
 
         ++X;
     }
 }
 
+static uint32_t GetShardEntryCount(glyph_table_params Params)
+{
+    // NOTE: Each span class that has any spans also needs an entry for its sentinel
+    uint32_t Result = Params.EntryCount;
+    for(uint32_t ClassIndex = 0; ClassIndex < GLYPH_TABLE_MAX_SPAN_CLASS_COUNT; ++ClassIndex)
+    {
+        if(Params.SpanEntryCounts[ClassIndex])
+        {
+            Result += 1 + Params.SpanEntryCounts[ClassIndex];
+        }
+    }
+
+    return Result;
+}
+
+static uint32_t AssignShardTiles(glyph_table_params Params, uint32_t SingleTileStart, glyph_table *Table)
+{
+    /* NOTE: The spans start at ReservedTileCount, and a span that doesn't fit in what is
+       left of the current row starts the next one, so its tiles are always side by side.
+       The single-tile entries are just consecutive tiles starting at SingleTileStart, which
+       is after the spans of every shard, so entry N of an unsharded table without spans
+       still gets tile ReservedTileCount + N.
+       
+       Returns the tile after the last span.  If Table is 0, this only computes that. */
+    Assert(Params.CacheTileCountInX >= 1);
+
+    uint32_t X = Params.ReservedTileCount % Params.CacheTileCountInX;
+    uint32_t Y = Params.ReservedTileCount / Params.CacheTileCountInX;
+
+    uint32_t EntryIndex = Params.EntryCount;
+    for(uint32_t ClassIndex = 0; ClassIndex < GLYPH_TABLE_MAX_SPAN_CLASS_COUNT; ++ClassIndex)
+    {
+        uint32_t SpanCount = Params.SpanEntryCounts[ClassIndex];
+        if(SpanCount)
+        {
+            uint32_t TileCount = (2 << ClassIndex);
+            Assert(TileCount <= Params.CacheTileCountInX);
+
+            // NOTE: The class sentinel doesn't get any tiles
+            ++EntryIndex;
+            for(uint32_t SpanIndex = 0; SpanIndex < SpanCount; ++SpanIndex)
+            {
+                if((X + TileCount) > Params.CacheTileCountInX)
+                {
+                    X = 0;
+                    ++Y;
+                }
+
+                if(Table)
+                {
+                    GetEntry(Table, EntryIndex)->GPUIndex = PackGlyphTablePoint(Params, X, Y);
+                }
+
+                ++EntryIndex;
+                X += TileCount;
+            }
+        }
+    }
+
+    uint32_t Result = Y*Params.CacheTileCountInX + X;
+
+    if(Table)
+    {
+        X = SingleTileStart % Params.CacheTileCountInX;
+        Y = SingleTileStart / Params.CacheTileCountInX;
+        for(EntryIndex = 0;
+            EntryIndex < Params.EntryCount;
+            ++EntryIndex)
+        {
+            if(X >= Params.CacheTileCountInX)
+            {
+                X = 0;
+                ++Y;
+            }
+
+            GetEntry(Table, EntryIndex)->GPUIndex = PackGlyphTablePoint(Params, X, Y);
+
+            ++X;
+        }
+    }
+
+    return Result;
+}
+
+static glyph_table_params SplitShardParams(glyph_table_params Params, uint32_t ShardIndex)
+{
+    // NOTE: Each shard gets an equal share of the slots and entries (and the last one gets the leftovers)
+    glyph_table_params Result = Params;
+
+    uint32_t EntriesPerShard = Params.EntryCount / Params.ShardCount;
+    Result.ShardCount = 0;
+    Result.HashCount = Params.HashCount / Params.ShardCount;
+    Result.EntryCount = EntriesPerShard;
+    if((ShardIndex + 1) == Params.ShardCount)
+    {
+        Result.EntryCount = Params.EntryCount - ShardIndex*EntriesPerShard;
+    }
+    for(uint32_t ClassIndex = 0; ClassIndex < GLYPH_TABLE_MAX_SPAN_CLASS_COUNT; ++ClassIndex)
+    {
+        uint32_t SpansPerShard = Params.SpanEntryCounts[ClassIndex] / Params.ShardCount;
+        Result.SpanEntryCounts[ClassIndex] = SpansPerShard;
+        if((ShardIndex + 1) == Params.ShardCount)
+        {
+            Result.SpanEntryCounts[ClassIndex] = Params.SpanEntryCounts[ClassIndex] - ShardIndex*SpansPerShard;
+        }
+    }
+    Result.MaxHashCount = Params.MaxHashCount / Params.ShardCount;
+    if(Params.AdmissionWindowCount)
+    {
+        Result.AdmissionWindowCount = Params.AdmissionWindowCount / Params.ShardCount;
+        if(Result.AdmissionWindowCount < 1)
+        {
+            Result.AdmissionWindowCount = 1;
+        }
+    }
+
+    if(Result.HashCount < 1)
+    {
+        Result.HashCount = 1;
+    }
+
+    return Result;
+}
+
+static uint32_t GetSpanTileEnd(glyph_table_params Params, uint32_t ShardCount)
+{
+    // NOTE: Returns the tile after the spans of the first ShardCount shards
+    uint32_t Result = Params.ReservedTileCount;
+    for(uint32_t ShardIndex = 0; ShardIndex < ShardCount; ++ShardIndex)
+    {
+        glyph_table_params ShardParams = Params.ShardCount ? SplitShardParams(Params, ShardIndex) : Params;
+        ShardParams.ReservedTileCount = Result;
+        Result = AssignShardTiles(ShardParams, 0, 0);
+    }
+
+    return Result;
+}
+
+static glyph_table_params GetShardParams(glyph_table_params Params, uint32_t ShardIndex)
+{
+    // NOTE: A shard's spans start right after the spans of the shard before it
+    glyph_table_params Result = SplitShardParams(Params, ShardIndex);
+    Result.ReservedTileCount = GetSpanTileEnd(Params, ShardIndex);
+
+    return Result;
+}
+
+static uint32_t GetShardSingleTileStart(glyph_table_params Params, uint32_t ShardIndex)
+{
+    // NOTE: The single-tile entries of every shard come after all the spans, in shard order
+    uint32_t ShardCount = Params.ShardCount ? Params.ShardCount : 1;
+    uint32_t Result = GetSpanTileEnd(Params, ShardCount) + ShardIndex*(Params.EntryCount / ShardCount);
+    return Result;
+}
+
+static uint32_t GetGlyphTableTileCount(glyph_table_params Params)
+{
+    uint32_t Result = GetShardSingleTileStart(Params, 0) + Params.EntryCount;
+    return Result;
+}
+
+static uint32_t GetGlyphTablePageCount(glyph_table_params Params)
+{
+    // NOTE: Tiles go row after row, so the last tile is on the last page
+    uint32_t Result = 1;
+    uint32_t TileCount = GetGlyphTableTileCount(Params);
+    if(Params.CacheTileCountInY && TileCount)
+    {
+        Result = ((TileCount - 1) / Params.CacheTileCountInX) / Params.CacheTileCountInY + 1;
+    }
+
+    return Result;
+}
+
+static uint32_t GetGlyphTableSnapshotCapacity(glyph_table_params Params)
+{
+    // NOTE: Every entry of every shard, sentinels included, which is more than can ever be saved
+    uint32_t Result = 0;
+    if(Params.ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Params.ShardCount; ++ShardIndex)
+        {
+            Result += GetShardEntryCount(SplitShardParams(Params, ShardIndex));
+        }
+    }
+    else
+    {
+        Result = GetShardEntryCount(Params);
+    }
+
+    return Result;
+}
+
+static size_t GetShardFootprint(glyph_table_params ShardParams);
 static size_t GetGlyphTableFootprint(glyph_table_params Params)
 {
-    size_t HashSize = Params.HashCount*sizeof(uint32_t);
-    size_t EntrySize = Params.EntryCount*sizeof(glyph_entry);
-    size_t Result = (sizeof(glyph_table) + HashSize + EntrySize);
+    size_t Result = 0;
+    if(Params.ShardCount)
+    {
+        for(uint32_t ShardIndex = 0; ShardIndex < Params.ShardCount; ++ShardIndex)
+        {
+            Result += GetShardFootprint(GetShardParams(Params, ShardIndex));
+        }
+
+        Result += sizeof(glyph_table) + Params.ShardCount*sizeof(glyph_table *);
+    }
+    else
+    {
+        Result = GetShardFootprint(Params);
+    }
+
+    return Result;
+}
+
+static uint32_t GetSketchWidth(glyph_table_params Params)
+{
+    // NOTE: One counter per entry in each row, rounded up to a power of two for masking
+    uint32_t Result = 0;
+    if(Params.Admission == GlyphTableAdmission_TinyLFU)
+    {
+        Result = 1;
+        while(Result < Params.EntryCount)
+        {
+            Result *= 2;
+        }
+    }
+
+    return Result;
+}
+
+static uint32_t GetMaxHashCount(glyph_table_params Params)
+{
+    // NOTE: Open-addressed tables never grow, since HashCount is already larger than EntryCount
+    uint32_t Result = Params.HashCount;
+    if((Params.Layout == GlyphTableLayout_Chained) && (Params.MaxHashCount > Result))
+    {
+        Result = Params.MaxHashCount;
+    }
+
+    return Result;
+}
+
+static size_t GetShardFootprint(glyph_table_params Params)
+{
+    size_t HashSize = GetMaxHashCount(Params)*((Params.Layout == GlyphTableLayout_OpenAddressed) ? sizeof(glyph_slot) : sizeof(uint32_t));
+    size_t EntrySize = GetShardEntryCount(Params)*sizeof(glyph_entry);
+    size_t SketchSize = GLYPH_SKETCH_ROW_COUNT*GetSketchWidth(Params);
+    size_t FrontSize = Params.FrontCacheCount*sizeof(glyph_front_entry);
+    size_t DirectSize = 0;
+    if(Params.DirectPageCount)
+    {
+        DirectSize = (Params.DirectPageCount*256*sizeof(uint32_t) + 256*sizeof(uint16_t) +
+                      GetShardEntryCount(Params)*sizeof(uint16_t));
+    }
+    size_t Result = (sizeof(glyph_table) + HashSize + EntrySize + FrontSize + SketchSize + DirectSize);
+
+    // NOTE: Shards are placed back-to-back, so keep each one on its own cache lines
+    // (which also keeps the next shard's entries aligned).
+    Result = (Result + 63) & ~(size_t)63;
+
+    return Result;
+}
+
+static uint64_t MixGlyphSeedBits(uint64_t Value)
+{
+    // NOTE: The splitmix64 finalizer, so every input bit affects every output bit
+    Value ^= Value >> 30;
+    Value *= 0xbf58476d1ce4e5b9ull;
+    Value ^= Value >> 27;
+    Value *= 0x94d049bb133111ebull;
+    Value ^= Value >> 31;
+    return Value;
+}
+
+static void PickGlyphTableSeed(glyph_table *Table)
+{
+    // NOTE: Just the best that can be done without the OS (see SetGlyphTableSeed).  The count
+    // keeps two tables placed at the same address in the same tick apart.
+    static uint64_t PlaceCount;
+    uint64_t Low = MixGlyphSeedBits(__rdtsc() ^ (uint64_t)(size_t)Table);
+    uint64_t High = MixGlyphSeedBits(Low ^ __rdtsc() ^ ++PlaceCount);
+    memcpy(Table->HashSeed, &Low, sizeof(Low));
+    memcpy(Table->HashSeed + 8, &High, sizeof(High));
+}
 
+static char unsigned *GetGlyphTableSeed(glyph_table *Table)
+{
+    char unsigned *Result = Table->HashSeed;
     return Result;
 }
 
+static void SetGlyphTableSeed(glyph_table *Table, char unsigned *Seedx16)
+{
+    Assert(Table->ShardCount || !Table->HashedCount);
+    memcpy(Table->HashSeed, Seedx16, sizeof(Table->HashSeed));
+}
+
+static glyph_table *PlaceShardInMemory(glyph_table_params Params, uint32_t SingleTileStart, void *Memory);
 static glyph_table *PlaceGlyphTableInMemory(glyph_table_params Params, void *Memory)
+{
+    glyph_table *Result = 0;
+
+    if(Params.ShardCount)
+    {
+        Assert(IsPowerOfTwo(Params.ShardCount));
+        Assert(!Params.DirectPageCount);
+        Assert((Params.EntryCount / Params.ShardCount) >= 2);
+
+        if(Memory)
+        {
+            char *At = (char *)Memory;
+            glyph_table *Shards[256];
+            Assert(Params.ShardCount <= ArrayCount(Shards));
+
+            // NOTE: Every shard but the last has the same number of entries, so IDs can be mapped back with a divide
+            uint32_t EntriesPerShard = GetShardEntryCount(SplitShardParams(Params, 0));
+            for(uint32_t ShardIndex = 0; ShardIndex < Params.ShardCount; ++ShardIndex)
+            {
+                glyph_table_params ShardParams = GetShardParams(Params, ShardIndex);
+                Shards[ShardIndex] = PlaceShardInMemory(ShardParams, GetShardSingleTileStart(Params, ShardIndex), At);
+                Shards[ShardIndex]->IDBase = ShardIndex*EntriesPerShard;
+                At += GetShardFootprint(ShardParams);
+            }
+
+            Result = (glyph_table *)At;
+            memset(Result, 0, sizeof(*Result));
+            Result->Shards = (glyph_table **)(Result + 1);
+            Result->ShardCount = Params.ShardCount;
+            Result->ShardMask = Params.ShardCount - 1;
+            Result->EntriesPerShard = EntriesPerShard;
+            Result->EntryCount = Params.EntryCount;
+            Result->TotalEntryCount = GetShardEntryCount(Params);
+            Result->Layout = Params.Layout;
+            Result->Eviction = Params.Eviction;
+            Result->Admission = Params.Admission;
+            for(uint32_t ShardIndex = 0; ShardIndex < Params.ShardCount; ++ShardIndex)
+            {
+                Result->Shards[ShardIndex] = Shards[ShardIndex];
+            }
+            PickGlyphTableSeed(Result);
+        }
+    }
+    else
+    {
+        Result = PlaceShardInMemory(Params, GetShardSingleTileStart(Params, 0), Memory);
+    }
+
+    return Result;
+}
+
+static uint32_t GetMaxChainLength(glyph_table_params Params)
+{
+    // NOTE: The default has to stay well clear of the chains a full table gets by chance, so a
+    // table with a lot of entries per slot (or an open-addressed one that is nearly full) gets a
+    // longer limit.  Open-addressed probe runs grow with the square of 1/(1 - load).
+    uint32_t Result = Params.MaxChainLength;
+    if(!Result)
+    {
+        Result = GLYPH_TABLE_DEFAULT_MAX_CHAIN_LENGTH;
+
+        uint64_t EntryCount = GetShardEntryCount(Params);
+        uint64_t HashCount = GetMaxHashCount(Params);
+        uint64_t Expected = 4*((EntryCount + HashCount - 1) / HashCount);
+        if(Params.Layout == GlyphTableLayout_OpenAddressed)
+        {
+            uint64_t FreeCount = (HashCount > EntryCount) ? (HashCount - EntryCount) : 1;
+            Expected = (2*HashCount*HashCount) / (FreeCount*FreeCount);
+        }
+
+        if(Expected > Result)
+        {
+            Result = (Expected < 0xffffffff) ? (uint32_t)Expected : 0xffffffff;
+        }
+    }
+
+    return Result;
+}
+
+static glyph_table *PlaceShardInMemory(glyph_table_params Params, uint32_t SingleTileStart, void *Memory)
 {
     Assert(Params.HashCount >= 1);
     Assert(Params.EntryCount >= 2);
     Assert(IsPowerOfTwo(Params.HashCount));
+    Assert(IsPowerOfTwo(GetMaxHashCount(Params)));
+    Assert(!Params.FrontCacheCount || IsPowerOfTwo(Params.FrontCacheCount));
+    Assert(Params.DirectPageCount <= 256);
     Assert(Params.CacheTileCountInX >= 1);
+    Assert((Params.Layout != GlyphTableLayout_OpenAddressed) || (Params.HashCount > GetShardEntryCount(Params)));
+    Assert((Params.Admission != GlyphTableAdmission_TinyLFU) || (Params.Eviction == GlyphTableEviction_LRU));
+    Assert((Params.Admission != GlyphTableAdmission_TinyLFU) || (Params.EntryCount >= 4));
 
     glyph_table *Result = 0;
+    uint32_t TotalEntryCount = GetShardEntryCount(Params);
 
     if(Memory)
     {
         // NOTE(casey): Always put the glyph_entry array at the base of the memory, because the
         // compiler may generate aligned-SSE ops, which would crash if it was unaligned.
         glyph_entry *Entries = (glyph_entry *)Memory;
-        Result = (glyph_table *)(Entries + Params.EntryCount);
-        Result->HashTable = (uint32_t *)(Result + 1);
+
+        // NOTE: The front slots and the open-addressed slots have hashes in them too, so they go
+        // right after the entries for the same reason.
+        glyph_front_entry *Front = (glyph_front_entry *)(Entries + TotalEntryCount);
+        char *AfterFront = (char *)(Front + Params.FrontCacheCount);
+        if(Params.Layout == GlyphTableLayout_OpenAddressed)
+        {
+            glyph_slot *Slots = (glyph_slot *)AfterFront;
+            Result = (glyph_table *)(Slots + Params.HashCount);
+            Result->Slots = Slots;
+            Result->HashTable = 0;
+            Result->Sketch = (uint8_t *)(Result + 1);
+
+            memset(Result->Slots, 0, Params.HashCount*sizeof(Result->Slots[0]));
+        }
+        else
+        {
+            Result = (glyph_table *)AfterFront;
+            Result->HashTable = (uint32_t *)(Result + 1);
+            Result->Slots = 0;
+            Result->Sketch = (uint8_t *)(Result->HashTable + GetMaxHashCount(Params));
+
+            memset(Result->HashTable, 0, Params.HashCount*sizeof(Result->HashTable[0]));
+        }
         Result->Entries = Entries;
 
+        Result->Front = Params.FrontCacheCount ? Front : 0;
+        Result->FrontMask = Params.FrontCacheCount ? (Params.FrontCacheCount - 1) : 0;
+        Result->FrontGeneration = 1;
+        memset(Front, 0, Params.FrontCacheCount*sizeof(glyph_front_entry));
+
+        uint32_t SketchWidth = GetSketchWidth(Params);
+        memset(Result->Sketch, 0, GLYPH_SKETCH_ROW_COUNT*SketchWidth);
+        Result->SketchMask = SketchWidth ? (SketchWidth - 1) : 0;
+        Result->SketchSampleCount = 0;
+        Result->SketchResetCount = 10*Params.EntryCount;
+
+        // NOTE: The page table goes after the sketch, whose size is always a multiple of 4
+        Result->DirectPageCount = Params.DirectPageCount;
+        Result->DirectPagesUsed = 0;
+        Result->DirectPageTable = 0;
+        Result->DirectPages = 0;
+        Result->DirectCodepoints = 0;
+        if(Params.DirectPageCount)
+        {
+            Result->DirectPages = (uint32_t *)(Result->Sketch + GLYPH_SKETCH_ROW_COUNT*SketchWidth);
+            Result->DirectPageTable = (uint16_t *)(Result->DirectPages + 256*Params.DirectPageCount);
+            Result->DirectCodepoints = Result->DirectPageTable + 256;
+
+            memset(Result->DirectPageTable, 0, 256*sizeof(uint16_t));
+            memset(Result->DirectCodepoints, 0, TotalEntryCount*sizeof(uint16_t));
+        }
+        Result->Admission = Params.Admission;
+        Result->WindowCount = 0;
+
+        // NOTE: The window defaults to about 1/64th of the entries, and always leaves some for the main chain
+        Result->WindowMax = Params.AdmissionWindowCount ? Params.AdmissionWindowCount : (Params.EntryCount / 64);
+        if(Result->WindowMax > (Params.EntryCount - 3))
+        {
+            Result->WindowMax = Params.EntryCount - 3;
+        }
+        if(Result->WindowMax < 1)
+        {
+            Result->WindowMax = 1;
+        }
+
         Result->HashMask = Params.HashCount - 1;
         Result->HashCount = Params.HashCount;
+        Result->MaxHashCount = GetMaxHashCount(Params);
+        Result->HashedCount = 0;
+        Result->RehashCount = 0;
+        Result->RehashNext = 0;
         Result->EntryCount = Params.EntryCount;
+        Result->TotalEntryCount = TotalEntryCount;
+        Result->Layout = Params.Layout;
+        Result->Eviction = Params.Eviction;
+        Result->MaxChainLength = GetMaxChainLength(Params);
+        Result->ClockHand = 1;
+        Result->CurrentFrame = 0;
+
+        Result->ShardCount = 0;
+        Result->ShardMask = 0;
+        Result->EntriesPerShard = 0;
+        Result->IDBase = 0;
+        Result->Shards = 0;
+        Result->Lock = 0;
+
+        // NOTE: Each span class is its sentinel followed by its spans, right after the single-tile entries
+        Result->SpanClassCount = 0;
+        uint32_t ChainEnd = Params.EntryCount;
+        uint32_t ChainEnds[GLYPH_TABLE_MAX_SPAN_CLASS_COUNT + 1];
+        ChainEnds[0] = ChainEnd;
+        for(uint32_t ClassIndex = 0; ClassIndex < GLYPH_TABLE_MAX_SPAN_CLASS_COUNT; ++ClassIndex)
+        {
+            if(Params.SpanEntryCounts[ClassIndex])
+            {
+                glyph_span_class *Class = Result->SpanClasses + Result->SpanClassCount++;
+                Class->TileCount = (2 << ClassIndex);
+                Class->SentinelIndex = ChainEnd;
 
-        memset(Result->HashTable, 0, Result->HashCount*sizeof(Result->HashTable[0]));
-
-        uint32_t StartingTile = Params.ReservedTileCount;
+                ChainEnd += 1 + Params.SpanEntryCounts[ClassIndex];
+                ChainEnds[Result->SpanClassCount] = ChainEnd;
+            }
+        }
+        Assert(ChainEnd == TotalEntryCount);
 
         glyph_entry *Sentinel = GetSentinel(Result);
-        uint32_t X = StartingTile % Params.CacheTileCountInX;
-        uint32_t Y = StartingTile / Params.CacheTileCountInX;
+        uint32_t ChainIndex = 0;
         for(uint32_t EntryIndex = 0;
-            EntryIndex < Params.EntryCount;
+            EntryIndex < TotalEntryCount;
             ++EntryIndex)
         {
-            if(X >= Params.CacheTileCountInX)
+            if(EntryIndex == ChainEnds[ChainIndex])
             {
-                X = 0;
-                ++Y;
+                ++ChainIndex;
             }
 
             glyph_entry *Entry = GetEntry(Result, EntryIndex);
-            if((EntryIndex+1) < Params.EntryCount)
+            if((EntryIndex+1) < ChainEnds[ChainIndex])
             {
                 Entry->NextWithSameHash = EntryIndex + 1;
             }
@@ -359,16 +2238,43 @@ static glyph_table *PlaceGlyphTableInMemory(glyph_table_params Params, void *Mem
             {
                 Entry->NextWithSameHash = 0;
             }
-            Entry->GPUIndex = PackGlyphCachePoint(X, Y);
+            Entry->GPUIndex.Value = 0;
+            Entry->NextLRU = 0;
+            Entry->PrevLRU = 0;
+            Entry->Flags = 0;
+            Entry->LastFrame = 0;
 
             Entry->FilledState = 0;
             Entry->DimX = 0;
             Entry->DimY = 0;
-            
-            ++X;
         }
 
-        GetAndClearStats(Result);
+        for(uint32_t ClassIndex = 0; ClassIndex < Result->SpanClassCount; ++ClassIndex)
+        {
+            // NOTE: Span sentinels start out as empty circular LRU chains, like the window's
+            uint32_t SpanSentinelIndex = Result->SpanClasses[ClassIndex].SentinelIndex;
+            glyph_entry *SpanSentinel = GetEntry(Result, SpanSentinelIndex);
+            SpanSentinel->NextLRU = SpanSentinelIndex;
+            SpanSentinel->PrevLRU = SpanSentinelIndex;
+        }
+
+        AssignShardTiles(Params, SingleTileStart, Result);
+
+        if(Params.Admission == GlyphTableAdmission_TinyLFU)
+        {
+            // NOTE: Take the window's sentinel out of the free chain and make it an empty LRU chain
+            glyph_entry *Window = GetEntry(Result, GLYPH_WINDOW_SENTINEL);
+            Sentinel->NextWithSameHash = Window->NextWithSameHash;
+            Window->NextWithSameHash = 0;
+            Window->NextLRU = GLYPH_WINDOW_SENTINEL;
+            Window->PrevLRU = GLYPH_WINDOW_SENTINEL;
+        }
+
+        glyph_table_stats ZeroStats = {0};
+        Result->Stats = ZeroStats;
+        Result->ReportedStats = ZeroStats;
+
+        PickGlyphTableSeed(Result);
     }
 
     return Result;
@@ -9,10 +9,11 @@
    
    1) Consider and test some alternate cache designs to see if there
       are any that remain simple to understand, but provide better
-      performance.  For example, this is a two-level cache (first the
+      performance.  For example, the default layout is a two-level cache (first the
       chain is looked up, then the elements), which almost certainly
       has worse cache behavior than a design where the first lookup
-      produced an actual element.
+      produced an actual element.  GlyphTableLayout_OpenAddressed is
+      one such alternative, and glyph_cache_bench.c compares the two.
       
    2) Battle-test all the functions with a lot of randomized and constructed
       data to ensure there are no lurking reference errors.  There are
@@ -28,10 +29,17 @@ typedef struct glyph_cache_point glyph_cache_point;
 typedef struct gpu_glyph_index gpu_glyph_index;
 typedef struct glyph_table_stats glyph_table_stats;
 typedef struct glyph_state glyph_state;
+typedef struct glyph_snapshot_entry glyph_snapshot_entry;
+typedef enum glyph_table_layout glyph_table_layout;
+typedef enum glyph_table_eviction glyph_table_eviction;
+typedef enum glyph_table_admission glyph_table_admission;
 
 // NOTE(Casey): "Opaque" types used for the internals:
 typedef struct glyph_table glyph_table;
 typedef struct glyph_entry glyph_entry;
+typedef struct glyph_slot glyph_slot;
+typedef struct glyph_front_entry glyph_front_entry;
+typedef struct glyph_span_class glyph_span_class;
 
 /* NOTE(casey):
 
@@ -57,13 +65,167 @@ typedef struct glyph_entry glyph_entry;
    CacheTileCountInX = The number of rects to put horizontally in the
                        cache texture.  This should generally be the width of the
                        cache texture divided by the font width.
+
+   Layout = How the hash table is organized (see glyph_table_layout below).
+            Zero is the original chained layout, so you can leave it alone
+            if you don't care.
+
+   ShardCount = Zero for a plain table, which is strictly single-threaded.  Otherwise,
+                the table is split into ShardCount independent tables (a power of two,
+                256 at most) with their own LRU chains and their own locks, picked by
+                hash bits.  The HashCount and EntryCount are divided evenly between
+                them.  This makes FindGlyphEntryByHash, UpdateGlyphCacheEntry and
+                GetAndClearStats safe to call from multiple threads at once, and
+                threads looking up glyphs in different shards never wait on each other.
+                Note that a ShardCount of 1 is a single table behind a single lock.
+                
+                Be aware that with multiple threads, another thread's miss can recycle
+                an entry you just looked up, exactly the same way a later miss on your
+                own thread could.  The cache must be big enough for what all the threads
+                are drawing at once.
+
+   Eviction = How the entry to recycle is picked when the table is full (see
+              glyph_table_eviction below).  Zero is the original LRU.
+
+   Admission = Whether a new glyph is allowed to push an established one out of the
+               cache (see glyph_table_admission below).  Zero admits everything, which
+               is the original behavior.
+
+   AdmissionWindowCount = Only for GlyphTableAdmission_TinyLFU.  How many entries make
+                          up the window that new glyphs go into before they have to
+                          earn their place.  Zero picks EntryCount/64.  Since glyphs can
+                          be recycled out of the window after that many other new glyphs,
+                          it must be comfortably larger than the number of new glyphs you
+                          look up while still using the ones you looked up before them
+                          (unless you use BeginGlyphTableFrame, which pins them instead).
+
+   SpanEntryCounts = How many multi-tile "span" entries to make of each size.  SpanEntryCounts[0]
+                     is the number of 2-tile spans, [1] of 4-tile spans, [2] of 8-tile spans and
+                     [3] of 16-tile spans.  The tiles of a span are always next to each other
+                     in the same row of the cache texture, so a wide glyph can be one entry
+                     (see FindGlyphSpanByHash).  Span tiles come out of the cache texture on top
+                     of the EntryCount single tiles, so use GetGlyphTableTileCount to see how many
+                     tiles the table needs in total.  All zero (the default) makes no spans.
+
+   MaxHashCount = Only for GlyphTableLayout_Chained.  If it is larger than HashCount (and a power
+                  of two), the hash table starts out with HashCount slots and doubles whenever
+                  there are more than two entries per slot on average, up to MaxHashCount slots.
+                  The entries are moved over to the new slots a few slots per lookup, so
+                  there's never a stall, and nothing is flushed.  Memory for MaxHashCount
+                  slots is part of the footprint from the start.  Zero never grows.
+
+   CacheTileCountInY = How many rows of tiles fit in one page of the cache texture, if the cache
+                       texture is an array of pages (a texture array).  Tiles are laid out row
+                       after row as usual, and every CacheTileCountInY rows start a new page, so
+                       the tiles of one row (and so a span) are always on the same page.  Entries
+                       are handed out lowest tile first until the table is full, so the pages fill
+                       in order, and you only need to create a page once a glyph lands in it.
+                       Zero (the default) puts every row on page 0.
+
+   FirstCachePage = Which page of the cache texture the table's tile 0 is on.  The table only
+                    ever uses pages FirstCachePage up to FirstCachePage + GetGlyphTablePageCount - 1,
+                    so several tables (one per font, say) can share one texture array as long
+                    as their pages don't overlap.
+
+   FrontCacheCount = How many slots (a power of two) a small direct-mapped "front" cache in
+                     front of the hash table gets, or zero for none.  Each slot holds one hash and
+                     the glyph_state it came back with, picked by the low bits of the hash, so a
+                     glyph that repeats along a row (box-drawing, powerline symbols, the same few
+                     CJK characters) costs one compare instead of a hash lookup and an LRU relink.
+                     Recycling, freeing or updating an entry clears the one slot that can hold
+                     it, and starting a frame makes all of them stale at once (a generation
+                     number).  A front hit doesn't touch the LRU chain or the admission sketch,
+                     but since it can only happen after a real lookup of the same glyph in the
+                     same frame, the entry has already been moved up and pinned.  (Without
+                     BeginGlyphTableFrame, repeats keep the LRU position of the first lookup
+                     until another glyph takes the slot.)  With sharding, each shard has its own.
+
+   DirectPageCount = How many 256-codepoint pages the codepoint page table can use (see
+                     FindGlyphEntryByCodepoint), or zero for none.  Each page costs 1k, plus
+                     2 bytes per entry for the table as a whole.  Not for sharded tables.
+
+   MaxChainLength = The longest a hash chain (or, with GlyphTableLayout_OpenAddressed, the probe
+                    run from a hash's home slot) is allowed to get.  Zero picks
+                    GLYPH_TABLE_DEFAULT_MAX_CHAIN_LENGTH, or more for a table with a lot of
+                    entries per slot (or a nearly full open-addressed one).  When a new glyph would make a chain any
+                    longer, the entry in that chain that was looked up longest ago is evicted to
+                    make room first (see ChainEvictionCount), so text made to collide in the
+                    hash table can't make every lookup walk a huge chain.  Entries pinned by the
+                    current frame are never evicted this way, so within one frame a chain can
+                    still go past it - and without BeginGlyphTableFrame, just like a recycle, it
+                    can evict an entry you looked up a moment ago.  If you set it yourself, keep
+                    it well above the average number of entries per slot, or it will evict
+                    glyphs that just happen to share a slot.
 */
+#define GLYPH_TABLE_DEFAULT_MAX_CHAIN_LENGTH 32
+#define GLYPH_TABLE_MAX_SPAN_CLASS_COUNT 4
+
+enum glyph_table_layout
+{
+    /* NOTE: Each hash slot is a 32-bit index of the first entry in a chain
+       of entries with the same slot.  Small, but every lookup has to go through
+       the slot to an entry before it can even compare the hash, and collisions walk
+       more entries.  HashCount can be much smaller than EntryCount. */
+    GlyphTableLayout_Chained,
+
+    /* NOTE: Each hash slot stores the full 128-bit hash inline next to the entry
+       index, and collisions probe linearly into the adjacent slots.  Slots are 32
+       bytes, so the first probe compares the hash directly and a typical
+       probe stays within one or two cache lines.  Costs more memory, and
+       HashCount must be larger than EntryCount - twice as large is a good starting
+       point, since probe lengths get long as the table fills up. */
+    GlyphTableLayout_OpenAddressed,
+};
+
+enum glyph_table_eviction
+{
+    /* NOTE: Exact least-recently-used order.  Every hit unlinks its entry and relinks
+       it at the front of a doubly-linked list, which writes to the entry and both of
+       its old neighbors (and the front entry), even when the entry was already at the front. */
+    GlyphTableEviction_LRU,
+
+    /* NOTE: CLOCK, aka "second chance".  A hit just sets a reference bit in the entry
+       (and only if it wasn't already set), so hits on a warm cache are read-only.  When an
+       entry has to be recycled, a clock hand sweeps the entries in order, clearing reference
+       bits as it goes, and recycles the first one it finds that wasn't referenced since the
+       last sweep.  This approximates LRU, and never has to touch more than the entry being
+       looked up. */
+    GlyphTableEviction_Clock,
+};
+
+enum glyph_table_admission
+{
+    // NOTE: Every miss gets to evict something
+    GlyphTableAdmission_None,
+
+    /* NOTE: TinyLFU-style admission.  The table keeps a small count-min sketch of how often
+       each hash has been looked up recently.  New glyphs go into a small LRU window, and when
+       one falls out of the window, it only replaces the main chain's least recently used entry
+       if the sketch says it has been looked up more often.  This stops a one-time flood of
+       glyphs (like cat'ing a file of random Unicode) from evicting the glyphs that are on
+       screen all the time (prompt, box-drawing, common CJK).  Requires GlyphTableEviction_LRU,
+       uses one entry as the window's sentinel, and costs 4 bytes per entry for the sketch. */
+    GlyphTableAdmission_TinyLFU,
+};
+
 struct glyph_table_params
 {
     uint32_t HashCount;
     uint32_t EntryCount;
     uint32_t ReservedTileCount;
     uint32_t CacheTileCountInX;
+    uint32_t Layout;
+    uint32_t ShardCount;
+    uint32_t Eviction;
+    uint32_t Admission;
+    uint32_t AdmissionWindowCount;
+    uint32_t SpanEntryCounts[GLYPH_TABLE_MAX_SPAN_CLASS_COUNT];
+    uint32_t MaxHashCount;
+    uint32_t CacheTileCountInY;
+    uint32_t FrontCacheCount;
+    uint32_t DirectPageCount;
+    uint32_t FirstCachePage;
+    uint32_t MaxChainLength;
 };
 
 /* NOTE(casey):
@@ -105,11 +267,43 @@ static void InitializeDirectGlyphTable(glyph_table_params Params, gpu_glyph_inde
 static size_t GetGlyphTableFootprint(glyph_table_params Params);
 static glyph_table *PlaceGlyphTableInMemory(glyph_table_params Params, void *Memory);
 
+/* NOTE:
+
+   Every table gets its own 16-byte hash seed when it is placed, and GetGlyphTableSeed returns
+   it.  Hash your glyphs with that (eg. pass it to ComputeGlyphHash) instead of a seed that is
+   the same everywhere, so there's no way to know ahead of time which strings land in the same
+   hash slot.  PlaceGlyphTableInMemory doesn't call the OS, so it only has the cycle counter and
+   the table's address to go on - if you have a proper random number generator, call
+   SetGlyphTableSeed with 16 bytes from it right after placing the table.
+
+   Since the hashes in a table only match the seed they were made with, SetGlyphTableSeed must
+   only be called while the table is still empty, and a snapshot (see SaveGlyphTableSnapshot)
+   has to be loaded into a table with the seed it was saved with.
+*/
+static char unsigned *GetGlyphTableSeed(glyph_table *Table);
+static void SetGlyphTableSeed(glyph_table *Table, char unsigned *Seedx16);
+
+/* NOTE:
+
+   GetGlyphTableTileCount returns how many tiles of the cache texture the table uses, counting
+   from tile 0 and including the ReservedTileCount reserved ones, so it must not be larger than
+   the number of tiles in your texture.  Without spans this is just ReservedTileCount + EntryCount.
+   Spans are laid out first, and never straddle two rows, so the easiest way to fill a texture
+   is to call this with EntryCount set to zero and give the leftover tiles to EntryCount.
+   GetGlyphTablePageCount is how many pages (see CacheTileCountInY) those tiles cover.
+*/
+static uint32_t GetGlyphTableTileCount(glyph_table_params Params);
+static uint32_t GetGlyphTablePageCount(glyph_table_params Params);
+
 /* NOTE(casey):
 
    Glyph indices are packed Y.X as a 32-bit 16.16 value.  Whenever you get back a gpu_glyph_index,
    you can retrieve the X/Y ordinal of the point int he texture with UnpackGlyphCachePoint,
    so you don't have to do the unpacking yourself.
+
+   NOTE: With the cache texture split into pages (see CacheTileCountInY), the packing is now
+   Page.Y.X as 8.12.12, so there can be up to 256 pages of up to 4096x4096 tiles each.  The
+   Y that comes back is the row within its page.
 */
 struct gpu_glyph_index 
 {
@@ -118,6 +312,7 @@ struct gpu_glyph_index
 struct glyph_cache_point
 {
     uint32_t X, Y;
+    uint32_t Page;
 };
 static glyph_cache_point UnpackGlyphCachePoint(gpu_glyph_index P);
 
@@ -135,6 +330,7 @@ struct glyph_state
 {
     uint32_t ID;
     gpu_glyph_index GPUIndex;
+    uint32_t TileSpan; // NOTE: How many tiles, going right from GPUIndex, belong to this entry (see FindGlyphSpanByHash)
 
     // NOTE(casey): Technically these two values can be whatever you want.
     uint32_t FilledState;
@@ -143,6 +339,80 @@ struct glyph_state
 };
 static glyph_state FindGlyphEntryByHash(glyph_table *Table, glyph_hash RunHash);
 
+/* NOTE:
+
+   If you call BeginGlyphTableFrame at the start of every frame, the table will never recycle
+   an entry that was looked up during the current frame, so a glyph you already put on screen
+   can't have its tile reused for a different glyph before the frame is drawn.  That makes it
+   safe to use an atlas that is smaller than one full screen of glyphs.
+   
+   If a miss then needs an entry and every entry is in use by the current frame, there is
+   nothing that can be recycled, so FindGlyphEntryByHash returns an "atlas overflow" state
+   instead, which IsGlyphAtlasOverflow tells you about, and which the stats count as an overflow.
+   It has an ID of 0 and a GPUIndex of 0, so if you reserve tile 0 as an empty tile, you can just
+   draw it (as nothing) - just don't transfer a glyph into it.  Passing its ID to
+   UpdateGlyphCacheEntry does nothing.
+
+   If you never call BeginGlyphTableFrame, nothing is ever pinned and misses never overflow.
+*/
+static void BeginGlyphTableFrame(glyph_table *Table);
+static int IsGlyphAtlasOverflow(glyph_state State);
+
+/* NOTE:
+
+   If you have a whole batch of hashes to look up at once (like every glyph run in a row),
+   FindGlyphEntriesByHashBatch produces exactly the same States as calling FindGlyphEntryByHash
+   on each hash in order, but it prefetches the hash slots and entries a few lookups ahead,
+   so the memory latency of the lookups overlaps instead of being paid one after another.
+   
+   Just like with individual lookups, later misses in the batch can recycle entries returned
+   earlier in the batch if the batch has more distinct glyphs than the cache can hold - unless
+   you use BeginGlyphTableFrame, in which case they overflow instead.
+*/
+static void FindGlyphEntriesByHashBatch(glyph_table *Table, uint32_t Count, glyph_hash *Hashes, glyph_state *States);
+
+/* NOTE:
+
+   Every new glyph starts out in a single-tile entry, because you don't know how wide it is
+   until you have looked it up and sized it.  Once you know it needs TileCount tiles, call
+   FindGlyphSpanByHash, which moves the hash into a span entry with at least TileCount tiles
+   next to each other in one row.  From then on, FindGlyphEntryByHash returns the span itself,
+   so drawing a wide glyph is a single lookup: the tiles are GPUIndex, and then the next
+   TileSpan - 1 tiles to the right of it, which GetGlyphSpanTile computes for you.  Since the
+   tiles are contiguous, you can also fill the whole span with one copy.
+   
+   Spans of each size are recycled least-recently-used among themselves (regardless of Eviction
+   and Admission, which only apply to single-tile entries).  A span is a new entry, so its
+   FilledState, DimX and DimY start at zero just like after a miss, and the single-tile entry it
+   replaces is freed - its ID is no longer valid, so don't use a glyph_state you got for it
+   before.  If the hash is already in a big enough entry, or there are no spans that big,
+   or every one of them is in use this frame, this is the same as FindGlyphEntryByHash, and you
+   have to check TileSpan to see whether you got a span.
+*/
+static glyph_state FindGlyphSpanByHash(glyph_table *Table, glyph_hash RunHash, uint32_t TileCount);
+static gpu_glyph_index GetGlyphSpanTile(glyph_state State, uint32_t TileIndex);
+
+/* NOTE:
+
+   The codepoint page table lets a single BMP codepoint that you know is drawn with a single
+   tile skip hashing altogether.  Once you have looked up its hash and found it is one tile,
+   call MapGlyphCodepoint with the ID you got, and from then on FindGlyphEntryByCodepoint
+   returns that entry's state directly (and returns 0 for codepoints that aren't mapped, in
+   which case you hash it and look it up as usual).  A hit does everything a hash hit does,
+   so the entry is pinned for the frame just the same.
+
+   The mapping is dropped whenever the entry is recycled or freed, so it never points at
+   a tile that holds some other glyph now.  Only an entry whose FilledState is the one you
+   ask for is a hit; one that isn't (not rasterized yet, say) returns 0 without touching the
+   LRU, admission counts or stats, so the hash lookup you fall back to is the only one that
+   counts.  The pages are two levels deep,
+   high byte then low byte, and a page is only taken from DirectPageCount when the first
+   codepoint in it is mapped - once they are used up, codepoints in new pages just don't
+   get mapped.
+*/
+static int FindGlyphEntryByCodepoint(glyph_table *Table, uint32_t Codepoint, uint32_t FilledState, glyph_state *Result);
+static void MapGlyphCodepoint(glyph_table *Table, uint32_t Codepoint, uint32_t ID);
+
 /* NOTE(casey):
 
    Whenever you change the state of the cache texture, call UpdateGlyphCacheEntry with the ID from the glyph_state
@@ -152,18 +422,69 @@ static glyph_state FindGlyphEntryByHash(glyph_table *Table, glyph_hash RunHash);
 */
 static void UpdateGlyphCacheEntry(glyph_table *Table, uint32_t ID, uint32_t NewState, uint16_t NewDimX, uint16_t NewDimY);
 
+/* NOTE:
+
+   To keep the cache across runs, SaveGlyphTableSnapshot writes out every entry whose FilledState
+   is non-zero (up to MaxCount of them, and GetGlyphTableSnapshotCapacity is always enough) and
+   returns how many it wrote.  Since IDs are kept, and an entry's GPUIndex only depends on its ID,
+   you also have to save the pixels of the cache texture - the table can't do that for you.
+
+   Next time, LoadGlyphTableSnapshot puts them back into a table that was just placed with the
+   exact same glyph_table_params, and you put the pixels back into the texture.  Records that
+   don't fit (IDs out of range, hashes that are already in the table or in the wrong shard,
+   entries that are already taken) are skipped, so a damaged file can't corrupt the table,
+   but you should still check the file itself however you like.  It returns how many entries
+   were loaded.  Everything comes back in the same LRU order it was saved in, except that
+   with GlyphTableAdmission_TinyLFU the admission window's glyphs go straight to the main chain.
+*/
+struct glyph_snapshot_entry
+{
+    glyph_hash HashValue;
+    uint32_t ID;
+    uint32_t FilledState;
+    uint16_t DimX;
+    uint16_t DimY;
+    uint32_t Reserved;
+};
+static uint32_t GetGlyphTableSnapshotCapacity(glyph_table_params Params);
+static uint32_t SaveGlyphTableSnapshot(glyph_table *Table, uint32_t MaxCount, glyph_snapshot_entry *Entries);
+static uint32_t LoadGlyphTableSnapshot(glyph_table *Table, uint32_t Count, glyph_snapshot_entry *Entries);
+
 /* NOTE(casey):
 
    The table keeps some simple internal stats.  The values are zeroed after every GetAndClearStats,
    so the count is the total number since the last time the stats were retrieved.
    
-   TODO(casey): This may be a mistake.  Perhaps the stats should just accumulate ad infinitum,
-   and people can diff vs. their old stats to find out the change?
+   NOTE: The counters themselves now accumulate ad infinitum, and GetAndClearStats just returns
+   the difference from what it returned last time, so it still works as before.  GetGlyphTableStats
+   returns the running totals without disturbing GetAndClearStats, and GetGlyphTableStatsDelta
+   diffs two of those, so any number of observers can each keep their own "last time".
 */
+#define GLYPH_TABLE_PROBE_HISTOGRAM_COUNT 8
+#define GLYPH_TABLE_AGE_HISTOGRAM_COUNT 16
 struct glyph_table_stats
 {
     size_t HitCount; // NOTE(casey): Number of times FindGlyphEntryByHash hit the cache
     size_t MissCount; // NOTE(casey): Number of times FindGlyphEntryByHash misses the cache
     size_t RecycleCount;  // NOTE(casey): Number of times an entry had to be recycled to fill a cache miss
+    size_t AdmissionCount; // NOTE: Number of times a glyph leaving the admission window was let into the main LRU chain
+    size_t RejectedAdmissionCount; // NOTE: Number of times a glyph leaving the admission window was dropped instead
+    size_t OverflowCount; // NOTE: Number of misses that got an atlas overflow because every entry was in use this frame
+    size_t SpanCount; // NOTE: Number of times FindGlyphSpanByHash moved a glyph into a multi-tile span
+    size_t GrowCount; // NOTE: Number of times the hash table started doubling (see MaxHashCount)
+    size_t FrontHitCount; // NOTE: How many of HitCount were answered by the front cache (see FrontCacheCount)
+    size_t DirectHitCount; // NOTE: How many of HitCount were answered by FindGlyphEntryByCodepoint
+    size_t ChainEvictionCount; // NOTE: Number of entries evicted because a new glyph's hash chain was already MaxChainLength long
+
+    // NOTE: Lookups by how many stored hashes they had to compare against (hits and misses both,
+    // but not front cache or codepoint hits).  The last bucket counts everything at or past it.
+    size_t ProbeLengthHistogram[GLYPH_TABLE_PROBE_HISTOGRAM_COUNT];
+
+    // NOTE: Recycled entries by how many frames ago they were last looked up, in powers of two -
+    // bucket 0 is the current frame, bucket N is 2^(N-1) to 2^N - 1 frames ago.  Only means
+    // anything if you call BeginGlyphTableFrame.
+    size_t EvictionAgeHistogram[GLYPH_TABLE_AGE_HISTOGRAM_COUNT];
 };
 static glyph_table_stats GetAndClearStats(glyph_table *Table);
+static glyph_table_stats GetGlyphTableStats(glyph_table *Table);
+static glyph_table_stats GetGlyphTableStatsDelta(glyph_table_stats Newer, glyph_table_stats Older);
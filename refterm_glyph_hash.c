@@ -0,0 +1,640 @@
+#if defined(__clang__) || defined(__GNUC__)
+#define GLYPH_HASH_TARGET(Features) __attribute__((target(Features)))
+#else
+#define GLYPH_HASH_TARGET(Features)
+#endif
+
+#if !_MSC_VER
+#include <cpuid.h>
+#endif
+
+#ifdef REFTERM_GLYPH_HASH_BACKEND
+#define GlyphHashBackend REFTERM_GLYPH_HASH_BACKEND
+#else
+static glyph_hash_backend GlyphHashBackend = GlyphHashBackend_AES4;
+#endif
+
+// NOTE: Whether GlyphHashBackend_VAES does its four lanes in one AVX-512 register or two AVX2 ones
+static int GlyphHashUseZMM;
+
+static char unsigned DefaultSeed[16] =
+{
+    178, 201, 95, 240, 40, 41, 143, 216,
+    2, 209, 178, 114, 232, 4, 176, 188
+};
+static char unsigned GlyphHashOverhangMask[32] =
+{
+    255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,
+    0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0
+};
+static char unsigned GlyphHashShuffleTable[32] =
+{
+  0, 1, 2, 3,  4, 5, 6, 7,  8, 9, 10, 11,  12, 13, 14, 15,
+  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF,  0xFF, 0xFF, 0xFF, 0xFF
+};
+
+typedef struct
+{
+    uint32_t EAX, EBX, ECX, EDX;
+} glyph_hash_cpuid;
+
+static glyph_hash_cpuid GlyphHashCPUID(uint32_t Leaf, uint32_t SubLeaf)
+{
+    glyph_hash_cpuid Result = {0};
+#if _MSC_VER
+    int Registers[4];
+    __cpuidex(Registers, (int)Leaf, (int)SubLeaf);
+    Result.EAX = (uint32_t)Registers[0];
+    Result.EBX = (uint32_t)Registers[1];
+    Result.ECX = (uint32_t)Registers[2];
+    Result.EDX = (uint32_t)Registers[3];
+#else
+    __get_cpuid_count(Leaf, SubLeaf, &Result.EAX, &Result.EBX, &Result.ECX, &Result.EDX);
+#endif
+    return Result;
+}
+
+GLYPH_HASH_TARGET("xsave")
+static uint64_t GetGlyphHashXCR0(void)
+{
+    uint64_t Result = _xgetbv(0);
+    return Result;
+}
+
+static int IsGlyphHashBackendSupportedByCPU(glyph_hash_backend Backend, int *UseZMM)
+{
+    glyph_hash_cpuid Leaf0 = GlyphHashCPUID(0, 0);
+    glyph_hash_cpuid Leaf1 = GlyphHashCPUID(1, 0);
+    glyph_hash_cpuid Leaf7 = {0};
+    if(Leaf0.EAX >= 7)
+    {
+        Leaf7 = GlyphHashCPUID(7, 0);
+    }
+
+    int HasSSSE3 = (Leaf1.ECX >> 9) & 1;
+    int HasAES = (Leaf1.ECX >> 25) & 1;
+    int HasOSXSAVE = (Leaf1.ECX >> 27) & 1;
+    int HasAVX = (Leaf1.ECX >> 28) & 1;
+    int HasAVX2 = (Leaf7.EBX >> 5) & 1;
+    int HasAVX512F = (Leaf7.EBX >> 16) & 1;
+    int HasVAES = (Leaf7.ECX >> 9) & 1;
+
+    // NOTE: The CPU having the instructions isn't enough, the OS also has to save the wider registers
+    uint64_t XCR0 = HasOSXSAVE ? GetGlyphHashXCR0() : 0;
+    int OSHasYMM = ((XCR0 & 0x6) == 0x6);
+    int OSHasZMM = ((XCR0 & 0xe6) == 0xe6);
+
+    int Result = 0;
+    *UseZMM = 0;
+    switch(Backend)
+    {
+        case GlyphHashBackend_AES4:
+        case GlyphHashBackend_AES2:
+        {
+            Result = HasAES && HasSSSE3;
+        } break;
+
+        case GlyphHashBackend_VAES:
+        {
+            *UseZMM = HasAVX512F && OSHasZMM;
+            Result = HasAES && HasSSSE3 && HasVAES && HasAVX && HasAVX2 && OSHasYMM;
+        } break;
+
+        case GlyphHashBackend_Portable:
+        {
+            Result = 1;
+        } break;
+
+        default: break;
+    }
+
+    return Result;
+}
+
+static int IsGlyphHashBackendSupported(glyph_hash_backend Backend)
+{
+    int UseZMM;
+    int Result = IsGlyphHashBackendSupportedByCPU(Backend, &UseZMM);
+#ifdef REFTERM_GLYPH_HASH_BACKEND
+    Result = Result && (Backend == REFTERM_GLYPH_HASH_BACKEND);
+#endif
+    return Result;
+}
+
+static int SetGlyphHashBackend(glyph_hash_backend Backend)
+{
+    int UseZMM;
+    int Result = IsGlyphHashBackendSupportedByCPU(Backend, &UseZMM);
+#ifdef REFTERM_GLYPH_HASH_BACKEND
+    Result = Result && (Backend == REFTERM_GLYPH_HASH_BACKEND);
+#endif
+    if(Result)
+    {
+#ifndef REFTERM_GLYPH_HASH_BACKEND
+        GlyphHashBackend = Backend;
+#endif
+        GlyphHashUseZMM = UseZMM;
+    }
+
+    return Result;
+}
+
+static glyph_hash_backend SelectGlyphHashBackend(void)
+{
+    // NOTE: VAES hashes short runs exactly like AES4, so it's always at least as good when it's there
+    if(!SetGlyphHashBackend(GlyphHashBackend_VAES) &&
+       !SetGlyphHashBackend(GlyphHashBackend_AES4))
+    {
+        SetGlyphHashBackend(GlyphHashBackend_Portable);
+    }
+
+    return GlyphHashBackend;
+}
+
+static glyph_hash_backend GetGlyphHashBackend(void)
+{
+    return GlyphHashBackend;
+}
+
+static char *GetGlyphHashBackendName(glyph_hash_backend Backend)
+{
+    char *Result = "unknown";
+    switch(Backend)
+    {
+        case GlyphHashBackend_AES4: Result = "AES4"; break;
+        case GlyphHashBackend_AES2: Result = "AES2"; break;
+        case GlyphHashBackend_VAES: Result = "VAES"; break;
+        case GlyphHashBackend_Portable: Result = "portable"; break;
+        default: break;
+    }
+
+    return Result;
+}
+
+static __m128i LoadGlyphHashOverhang(char unsigned *At, size_t Overhang)
+{
+    // NOTE: Loads the last Overhang (1-15) bytes, zero-extended, without touching the next page
+    size_t Overread = 16 - Overhang;
+
+    size_t OverhangMaskOffset = 16 - Overhang;
+    size_t ShuffleTableOffset = 0;
+
+    if(((uintptr_t)At ^ ((uintptr_t)At + 16)) & 4096) {
+      // The final read would cross a page boundary.
+      // Offset it so it doesn't.
+      At -= Overread;
+      OverhangMaskOffset = 0;
+      ShuffleTableOffset = Overread;
+    }
+
+    __m128i In = _mm_loadu_si128((__m128i *)At);
+    In = _mm_shuffle_epi8(_mm_and_si128(In, _mm_loadu_si128((__m128i *)(GlyphHashOverhangMask + OverhangMaskOffset))),
+                          _mm_loadu_si128((__m128i *)(GlyphHashShuffleTable + ShuffleTableOffset)));
+    return In;
+}
+
+static __m128i ComputeGlyphHashAES4(size_t Count, char unsigned *At, __m128i HashValue)
+{
+    size_t ChunkCount = Count / 16;
+    while(ChunkCount--)
+    {
+        __m128i In = _mm_loadu_si128((__m128i *)At);
+        At += 16;
+
+        HashValue = _mm_xor_si128(HashValue, In);
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+    }
+
+    size_t Overhang = Count % 16;
+    if(Overhang)
+    {
+        HashValue = _mm_xor_si128(HashValue, LoadGlyphHashOverhang(At, Overhang));
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+    }
+
+    return HashValue;
+}
+
+static __m128i ComputeGlyphHashAES2(size_t Count, char unsigned *At, __m128i HashValue)
+{
+    size_t ChunkCount = Count / 16;
+    while(ChunkCount--)
+    {
+        __m128i In = _mm_loadu_si128((__m128i *)At);
+        At += 16;
+
+        HashValue = _mm_xor_si128(HashValue, In);
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+    }
+
+    size_t Overhang = Count % 16;
+    if(Overhang)
+    {
+        HashValue = _mm_xor_si128(HashValue, LoadGlyphHashOverhang(At, Overhang));
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+    }
+
+    return HashValue;
+}
+
+static __m128i FoldGlyphHashLanes(__m128i Lane0, __m128i Lane1, __m128i Lane2, __m128i Lane3)
+{
+    // NOTE: Lanes 1-3 go into lane 0 as if they were three more blocks of input
+    __m128i HashValue = Lane0;
+    __m128i Lanes[3] = {Lane1, Lane2, Lane3};
+    for(uint32_t LaneIndex = 0; LaneIndex < ArrayCount(Lanes); ++LaneIndex)
+    {
+        HashValue = _mm_xor_si128(HashValue, Lanes[LaneIndex]);
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+        HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+    }
+
+    return HashValue;
+}
+
+GLYPH_HASH_TARGET("aes,vaes,avx2")
+static __m128i ComputeGlyphHashVAES256(size_t BlockCount, char unsigned *At, __m128i HashValue)
+{
+    // NOTE: Lane N starts as the hash so far with N XORed in, and takes bytes 16N-16N+15 of each block
+    __m256i Lanes01 = _mm256_set_m128i(_mm_xor_si128(HashValue, _mm_cvtsi32_si128(1)), HashValue);
+    __m256i Lanes23 = _mm256_set_m128i(_mm_xor_si128(HashValue, _mm_cvtsi32_si128(3)),
+                                       _mm_xor_si128(HashValue, _mm_cvtsi32_si128(2)));
+    while(BlockCount--)
+    {
+        Lanes01 = _mm256_xor_si256(Lanes01, _mm256_loadu_si256((__m256i *)At));
+        Lanes23 = _mm256_xor_si256(Lanes23, _mm256_loadu_si256((__m256i *)(At + 32)));
+        At += 64;
+
+        Lanes01 = _mm256_aesdec_epi128(Lanes01, _mm256_setzero_si256());
+        Lanes23 = _mm256_aesdec_epi128(Lanes23, _mm256_setzero_si256());
+        Lanes01 = _mm256_aesdec_epi128(Lanes01, _mm256_setzero_si256());
+        Lanes23 = _mm256_aesdec_epi128(Lanes23, _mm256_setzero_si256());
+        Lanes01 = _mm256_aesdec_epi128(Lanes01, _mm256_setzero_si256());
+        Lanes23 = _mm256_aesdec_epi128(Lanes23, _mm256_setzero_si256());
+        Lanes01 = _mm256_aesdec_epi128(Lanes01, _mm256_setzero_si256());
+        Lanes23 = _mm256_aesdec_epi128(Lanes23, _mm256_setzero_si256());
+    }
+
+    HashValue = FoldGlyphHashLanes(_mm256_castsi256_si128(Lanes01), _mm256_extracti128_si256(Lanes01, 1),
+                                   _mm256_castsi256_si128(Lanes23), _mm256_extracti128_si256(Lanes23, 1));
+    return HashValue;
+}
+
+GLYPH_HASH_TARGET("aes,vaes,avx512f")
+static __m128i ComputeGlyphHashVAES512(size_t BlockCount, char unsigned *At, __m128i HashValue)
+{
+    // NOTE: Exactly the same lanes as ComputeGlyphHashVAES256, just in one register
+    __m512i Lanes = _mm512_xor_si512(_mm512_broadcast_i32x4(HashValue),
+                                     _mm512_set_epi32(0, 0, 0, 3,  0, 0, 0, 2,  0, 0, 0, 1,  0, 0, 0, 0));
+    while(BlockCount--)
+    {
+        Lanes = _mm512_xor_si512(Lanes, _mm512_loadu_si512((void *)At));
+        At += 64;
+
+        Lanes = _mm512_aesdec_epi128(Lanes, _mm512_setzero_si512());
+        Lanes = _mm512_aesdec_epi128(Lanes, _mm512_setzero_si512());
+        Lanes = _mm512_aesdec_epi128(Lanes, _mm512_setzero_si512());
+        Lanes = _mm512_aesdec_epi128(Lanes, _mm512_setzero_si512());
+    }
+
+    HashValue = FoldGlyphHashLanes(_mm512_extracti32x4_epi32(Lanes, 0), _mm512_extracti32x4_epi32(Lanes, 1),
+                                   _mm512_extracti32x4_epi32(Lanes, 2), _mm512_extracti32x4_epi32(Lanes, 3));
+    return HashValue;
+}
+
+static __m128i ComputeGlyphHashVAES(size_t Count, char unsigned *At, __m128i HashValue)
+{
+    // NOTE: Folding the lanes costs as much as three more blocks, so below four blocks the
+    // lanes don't pay for themselves
+    size_t BlockCount = Count / 64;
+    if(BlockCount >= 4)
+    {
+        HashValue = GlyphHashUseZMM ?
+            ComputeGlyphHashVAES512(BlockCount, At, HashValue) :
+            ComputeGlyphHashVAES256(BlockCount, At, HashValue);
+        At += 64*BlockCount;
+        Count -= 64*BlockCount;
+    }
+
+    HashValue = ComputeGlyphHashAES4(Count, At, HashValue);
+    return HashValue;
+}
+
+static void MixGlyphHashPortable(uint64_t *AInit, uint64_t *BInit)
+{
+    // NOTE: Every step is invertible, so distinct states always stay distinct, and the shifts
+    // bring the high bits of each multiply back down, since the table slot comes from the low bits.
+    uint64_t A = *AInit;
+    uint64_t B = *BInit;
+    for(uint32_t Round = 0; Round < 2; ++Round)
+    {
+        A ^= B;
+        A *= 0x9e3779b97f4a7c15ull;
+        A ^= A >> 32;
+        B ^= A;
+        B *= 0xbf58476d1ce4e5b9ull;
+        B ^= B >> 29;
+    }
+
+    *AInit = A;
+    *BInit = B;
+}
+
+static __m128i ComputeGlyphHashPortable(size_t Count, char unsigned *At, __m128i HashValue)
+{
+    uint64_t A = (uint64_t)_mm_cvtsi128_si64(HashValue);
+    uint64_t B = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(HashValue, HashValue));
+
+    size_t ChunkCount = Count / 16;
+    while(ChunkCount--)
+    {
+        __m128i In = _mm_loadu_si128((__m128i *)At);
+        At += 16;
+
+        A ^= (uint64_t)_mm_cvtsi128_si64(In);
+        B ^= (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(In, In));
+        MixGlyphHashPortable(&A, &B);
+    }
+
+    size_t Overhang = Count % 16;
+    if(Overhang)
+    {
+        // NOTE: Masked like the AES backends, except that shifting the bytes back down after a
+        // page-crossing read needs SSSE3, so that case goes a byte at a time instead
+        uint64_t InA = 0;
+        uint64_t InB = 0;
+        if(((uintptr_t)At ^ ((uintptr_t)At + 16)) & 4096)
+        {
+            for(size_t Index = 0; Index < Overhang; ++Index)
+            {
+                uint64_t Byte = (uint64_t)At[Index] << (8*(Index % 8));
+                InA |= (Index < 8) ? Byte : 0;
+                InB |= (Index < 8) ? 0 : Byte;
+            }
+        }
+        else
+        {
+            __m128i In = _mm_and_si128(_mm_loadu_si128((__m128i *)At),
+                                       _mm_loadu_si128((__m128i *)(GlyphHashOverhangMask + 16 - Overhang)));
+            InA = (uint64_t)_mm_cvtsi128_si64(In);
+            InB = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(In, In));
+        }
+
+        A ^= InA;
+        B ^= InB;
+        MixGlyphHashPortable(&A, &B);
+    }
+
+    HashValue = _mm_set_epi64x((long long)B, (long long)A);
+    return HashValue;
+}
+
+static glyph_hash ComputeGlyphHash(size_t Count, char unsigned *At, char unsigned *Seedx16)
+{
+    /* TODO(casey):
+
+      Consider and test some alternate hash designs.  The hash here
+      was the simplest thing to type in, but it is not necessarily
+      the best hash for the job.  It may be that less AES rounds
+      would produce equivalently collision-free results for the
+      problem space.  It may be that non-AES hashing would be
+      better.  Some careful analysis would be nice.
+
+      NOTE: The alternatives are the glyph_hash_backend values, and
+      glyph_cache_bench -hash measures them.
+    */
+
+    // TODO(casey): Does the result of a grapheme composition
+    // depend on whether or not it was RTL or LTR?  Or are there
+    // no fonts that ever get used in both directions, so it doesn't
+    // matter?
+
+    // TODO(casey): Double-check exactly the pattern
+    // we want to use for the hash here
+
+    glyph_hash Result = {0};
+
+    // TODO(casey): Should there be an IV?
+    __m128i HashValue = _mm_cvtsi64_si128(Count);
+    HashValue = _mm_xor_si128(HashValue, _mm_loadu_si128((__m128i *)Seedx16));
+
+    switch(GlyphHashBackend)
+    {
+        case GlyphHashBackend_AES2: HashValue = ComputeGlyphHashAES2(Count, At, HashValue); break;
+        case GlyphHashBackend_VAES: HashValue = ComputeGlyphHashVAES(Count, At, HashValue); break;
+        case GlyphHashBackend_Portable: HashValue = ComputeGlyphHashPortable(Count, At, HashValue); break;
+        default: HashValue = ComputeGlyphHashAES4(Count, At, HashValue); break;
+    }
+
+    Result.Value = HashValue;
+
+    return Result;
+}
+
+static glyph_hash ComputeHashForTileIndex(glyph_hash Tile0Hash, uint32_t TileIndex)
+{
+    __m128i HashValue = Tile0Hash.Value;
+    if(TileIndex)
+    {
+        HashValue = _mm_xor_si128(HashValue, _mm_set1_epi32(TileIndex));
+        switch(GlyphHashBackend)
+        {
+            case GlyphHashBackend_AES2:
+            {
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+            } break;
+
+            case GlyphHashBackend_Portable:
+            {
+                uint64_t A = (uint64_t)_mm_cvtsi128_si64(HashValue);
+                uint64_t B = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(HashValue, HashValue));
+                MixGlyphHashPortable(&A, &B);
+                HashValue = _mm_set_epi64x((long long)B, (long long)A);
+            } break;
+
+            default:
+            {
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+                HashValue = _mm_aesdec_si128(HashValue, _mm_setzero_si128());
+            } break;
+        }
+    }
+
+    glyph_hash Result = {HashValue};
+    return Result;
+}
+
+static __m128i LoadGlyphHashTail(char unsigned *At, size_t Count)
+{
+    // NOTE: The same load as LoadGlyphHashOverhang (for 1-16 bytes), but without a branch,
+    // because whether each lane's read crosses a page is unpredictable
+    size_t Overread = 16 - Count;
+    size_t Shift = ((((uintptr_t)At ^ ((uintptr_t)At + 16)) >> 12) & 1)*Overread;
+
+    __m128i In = _mm_loadu_si128((__m128i *)(At - Shift));
+    In = _mm_shuffle_epi8(_mm_and_si128(In, _mm_loadu_si128((__m128i *)(GlyphHashOverhangMask + Overread - Shift))),
+                          _mm_loadu_si128((__m128i *)(GlyphHashShuffleTable + Shift)));
+    return In;
+}
+
+static void RunGlyphHashLaneRounds(__m128i *Lanes, uint32_t RoundCount)
+{
+    // NOTE: Written out lane by lane so the lanes stay in registers, and round-major so the
+    // CPU always has eight independent AES ops to overlap
+    __m128i Zero = _mm_setzero_si128();
+    __m128i Lane0 = Lanes[0];
+    __m128i Lane1 = Lanes[1];
+    __m128i Lane2 = Lanes[2];
+    __m128i Lane3 = Lanes[3];
+    __m128i Lane4 = Lanes[4];
+    __m128i Lane5 = Lanes[5];
+    __m128i Lane6 = Lanes[6];
+    __m128i Lane7 = Lanes[7];
+    while(RoundCount--)
+    {
+        Lane0 = _mm_aesdec_si128(Lane0, Zero);
+        Lane1 = _mm_aesdec_si128(Lane1, Zero);
+        Lane2 = _mm_aesdec_si128(Lane2, Zero);
+        Lane3 = _mm_aesdec_si128(Lane3, Zero);
+        Lane4 = _mm_aesdec_si128(Lane4, Zero);
+        Lane5 = _mm_aesdec_si128(Lane5, Zero);
+        Lane6 = _mm_aesdec_si128(Lane6, Zero);
+        Lane7 = _mm_aesdec_si128(Lane7, Zero);
+    }
+    Lanes[0] = Lane0;
+    Lanes[1] = Lane1;
+    Lanes[2] = Lane2;
+    Lanes[3] = Lane3;
+    Lanes[4] = Lane4;
+    Lanes[5] = Lane5;
+    Lanes[6] = Lane6;
+    Lanes[7] = Lane7;
+}
+
+GLYPH_HASH_TARGET("aes,vaes,avx2")
+static void RunGlyphHashLaneRoundsVAES256(__m128i *Lanes)
+{
+    __m256i Zero = _mm256_setzero_si256();
+    __m256i Lanes01 = _mm256_set_m128i(Lanes[1], Lanes[0]);
+    __m256i Lanes23 = _mm256_set_m128i(Lanes[3], Lanes[2]);
+    __m256i Lanes45 = _mm256_set_m128i(Lanes[5], Lanes[4]);
+    __m256i Lanes67 = _mm256_set_m128i(Lanes[7], Lanes[6]);
+    for(uint32_t Round = 0; Round < 4; ++Round)
+    {
+        Lanes01 = _mm256_aesdec_epi128(Lanes01, Zero);
+        Lanes23 = _mm256_aesdec_epi128(Lanes23, Zero);
+        Lanes45 = _mm256_aesdec_epi128(Lanes45, Zero);
+        Lanes67 = _mm256_aesdec_epi128(Lanes67, Zero);
+    }
+    Lanes[0] = _mm256_castsi256_si128(Lanes01);
+    Lanes[1] = _mm256_extracti128_si256(Lanes01, 1);
+    Lanes[2] = _mm256_castsi256_si128(Lanes23);
+    Lanes[3] = _mm256_extracti128_si256(Lanes23, 1);
+    Lanes[4] = _mm256_castsi256_si128(Lanes45);
+    Lanes[5] = _mm256_extracti128_si256(Lanes45, 1);
+    Lanes[6] = _mm256_castsi256_si128(Lanes67);
+    Lanes[7] = _mm256_extracti128_si256(Lanes67, 1);
+}
+
+GLYPH_HASH_TARGET("aes,vaes,avx512f")
+static void RunGlyphHashLaneRoundsVAES512(__m128i *Lanes)
+{
+    __m512i Zero = _mm512_setzero_si512();
+    __m512i Lanes0123 = _mm512_inserti32x4(_mm512_inserti32x4(_mm512_inserti32x4(_mm512_castsi128_si512(Lanes[0]),
+                                                                                  Lanes[1], 1), Lanes[2], 2), Lanes[3], 3);
+    __m512i Lanes4567 = _mm512_inserti32x4(_mm512_inserti32x4(_mm512_inserti32x4(_mm512_castsi128_si512(Lanes[4]),
+                                                                                  Lanes[5], 1), Lanes[6], 2), Lanes[7], 3);
+    for(uint32_t Round = 0; Round < 4; ++Round)
+    {
+        Lanes0123 = _mm512_aesdec_epi128(Lanes0123, Zero);
+        Lanes4567 = _mm512_aesdec_epi128(Lanes4567, Zero);
+    }
+    Lanes[0] = _mm512_castsi512_si128(Lanes0123);
+    Lanes[1] = _mm512_extracti32x4_epi32(Lanes0123, 1);
+    Lanes[2] = _mm512_extracti32x4_epi32(Lanes0123, 2);
+    Lanes[3] = _mm512_extracti32x4_epi32(Lanes0123, 3);
+    Lanes[4] = _mm512_castsi512_si128(Lanes4567);
+    Lanes[5] = _mm512_extracti32x4_epi32(Lanes4567, 1);
+    Lanes[6] = _mm512_extracti32x4_epi32(Lanes4567, 2);
+    Lanes[7] = _mm512_extracti32x4_epi32(Lanes4567, 3);
+}
+
+static void ComputeGlyphHashes(uint32_t RunCount, glyph_hash_input *Inputs, char unsigned *Seedx16, glyph_hash *Hashes)
+{
+    __m128i Seed = _mm_loadu_si128((__m128i *)Seedx16);
+
+    uint32_t RunIndex = 0;
+    while(RunIndex < RunCount)
+    {
+        // NOTE: Lanes only ever hash one block each, since that's nearly every glyph run.  A group
+        // with a longer (or empty) run in it, and the last few runs, are hashed one at a time.
+        int AllOneBlock = ((GlyphHashBackend != GlyphHashBackend_Portable) &&
+                           ((RunCount - RunIndex) >= GLYPH_HASH_LANE_COUNT));
+        for(uint32_t Lane = 0; AllOneBlock && (Lane < GLYPH_HASH_LANE_COUNT); ++Lane)
+        {
+            size_t Count = Inputs[RunIndex + Lane].Count;
+            AllOneBlock = (Count - 1) < 16;
+        }
+
+        if(AllOneBlock)
+        {
+            __m128i Lanes[GLYPH_HASH_LANE_COUNT];
+            for(uint32_t Lane = 0; Lane < GLYPH_HASH_LANE_COUNT; ++Lane)
+            {
+                glyph_hash_input *Input = Inputs + RunIndex + Lane;
+                Lanes[Lane] = _mm_xor_si128(_mm_xor_si128(_mm_cvtsi64_si128(Input->Count), Seed),
+                                            LoadGlyphHashTail(Input->At, Input->Count));
+            }
+
+            if(GlyphHashBackend == GlyphHashBackend_VAES)
+            {
+                if(GlyphHashUseZMM)
+                {
+                    RunGlyphHashLaneRoundsVAES512(Lanes);
+                }
+                else
+                {
+                    RunGlyphHashLaneRoundsVAES256(Lanes);
+                }
+            }
+            else if(GlyphHashBackend == GlyphHashBackend_AES2)
+            {
+                RunGlyphHashLaneRounds(Lanes, 2);
+            }
+            else
+            {
+                RunGlyphHashLaneRounds(Lanes, 4);
+            }
+
+            for(uint32_t Lane = 0; Lane < GLYPH_HASH_LANE_COUNT; ++Lane)
+            {
+                Hashes[RunIndex + Lane].Value = Lanes[Lane];
+            }
+
+            RunIndex += GLYPH_HASH_LANE_COUNT;
+        }
+        else
+        {
+            uint32_t StopIndex = RunIndex + GLYPH_HASH_LANE_COUNT;
+            StopIndex = (StopIndex > RunCount) ? RunCount : StopIndex;
+            while(RunIndex < StopIndex)
+            {
+                Hashes[RunIndex] = ComputeGlyphHash(Inputs[RunIndex].Count, Inputs[RunIndex].At, Seedx16);
+                ++RunIndex;
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/* NOTE:
+
+   The glyph hash turns the bytes of a glyph run (the UTF-8 of a grapheme cluster, usually
+   1-12 bytes) into the 128-bit glyph_hash that the glyph table is keyed by.  It is also used
+   for the glyph snapshot's file name and checksum, which hash a lot more bytes at a time.
+
+   There are several backends:
+
+   GlyphHashBackend_AES4 is the original hash: each 16 bytes are XORed in and then go
+   through four AES decryption rounds with a zero key.
+
+   GlyphHashBackend_AES2 is the same with two rounds instead of four, which takes about
+   a sixth off the latency of a short run.  But glyph_cache_bench -hash shows that two
+   rounds are not enough: there are no full 128-bit collisions, but the low 32 bits
+   (which pick the hash table slot) collide several hundred times more often than random
+   on real cluster strings.  It is only there to be measured.
+
+   GlyphHashBackend_VAES is AES4 for anything under 256 bytes (so glyph runs hash exactly
+   the same), but hashes 64-byte blocks as four independent AES lanes at once with VAES,
+   using AVX-512 registers when they are there and two AVX2 registers when they aren't.
+   The lanes are folded together at the end.  It only helps long inputs, like the
+   snapshot checksum.
+
+   GlyphHashBackend_Portable needs nothing past SSE2, for CPUs without AES-NI.  It mixes
+   two 64-bit halves with multiplies and xorshifts instead of AES rounds.
+
+   SelectGlyphHashBackend picks the best backend the CPU supports (checked with cpuid)
+   and must be called once before anything is hashed.  Defining REFTERM_GLYPH_HASH_BACKEND
+   to one of the backends compiles in just that one instead, with no dispatch at all.
+
+   Different backends produce different hashes, so anything that is saved keyed by a
+   hash (see glyph_snapshot_key) has to record which backend it used.
+*/
+
+typedef enum
+{
+    GlyphHashBackend_AES4,
+    GlyphHashBackend_AES2,
+    GlyphHashBackend_VAES,
+    GlyphHashBackend_Portable,
+
+    GlyphHashBackend_Count,
+} glyph_hash_backend;
+
+static glyph_hash_backend SelectGlyphHashBackend(void);
+static int IsGlyphHashBackendSupported(glyph_hash_backend Backend);
+static glyph_hash_backend GetGlyphHashBackend(void);
+static char *GetGlyphHashBackendName(glyph_hash_backend Backend);
+
+/* NOTE:
+
+   SetGlyphHashBackend is only for benchmarks and tests.  Changing the backend while a glyph
+   table is in use makes every entry in it unreachable.  It returns 0 (and changes nothing)
+   if the CPU doesn't support Backend, or if a different backend was compiled in.
+*/
+static int SetGlyphHashBackend(glyph_hash_backend Backend);
+
+static glyph_hash ComputeGlyphHash(size_t Count, char unsigned *At, char unsigned *Seedx16);
+static glyph_hash ComputeHashForTileIndex(glyph_hash Tile0Hash, uint32_t TileIndex);
+
+/* NOTE:
+
+   ComputeGlyphHashes gives exactly the same hashes as calling ComputeGlyphHash on each
+   input, but hashes GLYPH_HASH_LANE_COUNT inputs at a time.  A glyph run is usually one
+   16-byte block, so one hash is a chain of dependent AES rounds that leaves the AES unit
+   mostly idle; interleaving the rounds of eight runs keeps it busy.  With the VAES backend,
+   the lanes are packed into YMM/ZMM registers so one instruction does a round of several
+   lanes.  The Portable backend just hashes the inputs one after the other.
+*/
+#define GLYPH_HASH_LANE_COUNT 8 // NOTE: The lane code is written out for exactly 8
+typedef struct
+{
+    char unsigned *At;
+    size_t Count;
+} glyph_hash_input;
+
+static void ComputeGlyphHashes(uint32_t RunCount, glyph_hash_input *Inputs, char unsigned *Seedx16, glyph_hash *Hashes);
@@ -1,115 +0,0 @@
-#if 0
-//
-// Generated by Microsoft (R) D3D Shader Disassembler
-//
-//
-// Input signature:
-//
-// Name                 Index   Mask Register SysValue  Format   Used
-// -------------------- ----- ------ -------- -------- ------- ------
-// SV_VERTEXID              0   x           0   VERTID    uint   x   
-//
-//
-// Output signature:
-//
-// Name                 Index   Mask Register SysValue  Format   Used
-// -------------------- ----- ------ -------- -------- ------- ------
-// SV_POSITION              0   xyzw        0      POS   float   xyzw
-//
-vs_5_0
-dcl_globalFlags refactoringAllowed
-dcl_input_sgv v0.x, vertex_id
-dcl_output_siv o0.xyzw, position
-dcl_temps 1
-and r0.x, v0.x, l(1)
-utof r0.x, r0.x
-add r0.x, r0.x, l(-0.500000)
-add o0.x, r0.x, r0.x
-ushr r0.x, v0.x, l(1)
-utof r0.x, r0.x
-add r0.x, r0.x, l(-0.500000)
-mul o0.y, r0.x, l(-2.000000)
-mov o0.zw, l(0,0,0,1.000000)
-ret 
-// Approximately 0 instruction slots used
-#endif
-
-const BYTE ReftermVSShaderBytes[] =
-{
-     68,  88,  66,  67, 173, 161, 
-    191, 148, 243,  58, 210,  73, 
-    205,  38,  94,  72,  97,  14, 
-     93,  15,   1,   0,   0,   0, 
-    196,   1,   0,   0,   3,   0, 
-      0,   0,  44,   0,   0,   0, 
-     96,   0,   0,   0, 148,   0, 
-      0,   0,  73,  83,  71,  78, 
-     44,   0,   0,   0,   1,   0, 
-      0,   0,   8,   0,   0,   0, 
-     32,   0,   0,   0,   0,   0, 
-      0,   0,   6,   0,   0,   0, 
-      1,   0,   0,   0,   0,   0, 
-      0,   0,   1,   1,   0,   0, 
-     83,  86,  95,  86,  69,  82, 
-     84,  69,  88,  73,  68,   0, 
-     79,  83,  71,  78,  44,   0, 
-      0,   0,   1,   0,   0,   0, 
-      8,   0,   0,   0,  32,   0, 
-      0,   0,   0,   0,   0,   0, 
-      1,   0,   0,   0,   3,   0, 
-      0,   0,   0,   0,   0,   0, 
-     15,   0,   0,   0,  83,  86, 
-     95,  80,  79,  83,  73,  84, 
-     73,  79,  78,   0,  83,  72, 
-     69,  88,  40,   1,   0,   0, 
-     80,   0,   1,   0,  74,   0, 
-      0,   0, 106,   8,   0,   1, 
-     96,   0,   0,   4,  18,  16, 
-     16,   0,   0,   0,   0,   0, 
-      6,   0,   0,   0, 103,   0, 
-      0,   4, 242,  32,  16,   0, 
-      0,   0,   0,   0,   1,   0, 
-      0,   0, 104,   0,   0,   2, 
-      1,   0,   0,   0,   1,   0, 
-      0,   7,  18,   0,  16,   0, 
-      0,   0,   0,   0,  10,  16, 
-     16,   0,   0,   0,   0,   0, 
-      1,  64,   0,   0,   1,   0, 
-      0,   0,  86,   0,   0,   5, 
-     18,   0,  16,   0,   0,   0, 
-      0,   0,  10,   0,  16,   0, 
-      0,   0,   0,   0,   0,   0, 
-      0,   7,  18,   0,  16,   0, 
-      0,   0,   0,   0,  10,   0, 
-     16,   0,   0,   0,   0,   0, 
-      1,  64,   0,   0,   0,   0, 
-      0, 191,   0,   0,   0,   7, 
-     18,  32,  16,   0,   0,   0, 
-      0,   0,  10,   0,  16,   0, 
-      0,   0,   0,   0,  10,   0, 
-     16,   0,   0,   0,   0,   0, 
-     85,   0,   0,   7,  18,   0, 
-     16,   0,   0,   0,   0,   0, 
-     10,  16,  16,   0,   0,   0, 
-      0,   0,   1,  64,   0,   0, 
-      1,   0,   0,   0,  86,   0, 
-      0,   5,  18,   0,  16,   0, 
-      0,   0,   0,   0,  10,   0, 
-     16,   0,   0,   0,   0,   0, 
-      0,   0,   0,   7,  18,   0, 
-     16,   0,   0,   0,   0,   0, 
-     10,   0,  16,   0,   0,   0, 
-      0,   0,   1,  64,   0,   0, 
-      0,   0,   0, 191,  56,   0, 
-      0,   7,  34,  32,  16,   0, 
-      0,   0,   0,   0,  10,   0, 
-     16,   0,   0,   0,   0,   0, 
-      1,  64,   0,   0,   0,   0, 
-      0, 192,  54,   0,   0,   8, 
-    194,  32,  16,   0,   0,   0, 
-      0,   0,   2,  64,   0,   0, 
-      0,   0,   0,   0,   0,   0, 
-      0,   0,   0,   0,   0,   0, 
-      0,   0, 128,  63,  62,   0, 
-      0,   1
-};
@@ -0,0 +1,1491 @@
+/* NOTE:
+
+   Standalone check and benchmark for refterm_example_source_buffer.  It does not need a
+   window or a child process - it writes a known byte stream into the scrollback buffer the
+   same way UpdateTerminalBuffer does (GetNextWritableRange, fill, CommitWrite) and reads it
+   back the way LayoutLines does (ReadSourceAt).
+
+   source_buffer_bench -check
+
+       Writes commits of sizes from 1 byte up to nearly the whole buffer, so plenty of
+       them straddle the wrap point, and after each one checks that ReadSourceAt hands back the
+       right bytes, in one contiguous range, for reads that start before the wrap and end
+       after it.  Also checks that a write through the second view shows up at the start
+       of the first.  Then does the same to a file-backed buffer (AllocateFileSourceBuffer),
+       closes it, reopens it and checks that everything, including the caller's bytes in the
+       header, comes back, and that files it shouldn't use are refused and left alone.
+       Then runs the producer/consumer calls on two threads (see -spsc) and checks
+       every byte the consumer gets.  Then appends lines to small line indexes
+       (refterm_example_line_index) until they have wrapped many times, checking every line
+       still in them against what went in, and that they come back from their saved state.
+       Prints FAILED and exits with 1 on the first mismatch.
+
+   source_buffer_bench -throughput [DataSize]
+
+       Streams 4GB through the buffer in 64-byte, 4KB and 64KB chunks, reading each chunk
+       back with ReadSourceAt, and prints GB/s.  For comparison, the same loop on an
+       ordinary (singly mapped) ring buffer, which has to split every write and read that
+       crosses the end in two.  The default DataSize is refterm's PipeSize, 16MB.
+
+   source_buffer_bench -pages [DataSize]
+
+       Compares a buffer on ordinary pages against one that asked for huge pages
+       (AllocateSourceBuffer's UseHugePages) on what a large-file splat does to a big
+       scrollback: fill it with lines from 64KB pipe reads, find every line end, and then lay
+       out screens of lines scattered all over it.  Prints GB/s, ns/line, and dTLB read
+       misses where the CPU's counters can be read (Linux perf_event_open).  On Linux, 2MB
+       pages have to be reserved first, e.g. echo 512 > /proc/sys/vm/nr_hugepages for 1GB;
+       on Windows, the account needs the "Lock pages in memory" privilege.  The default
+       DataSize is 256MB.
+
+   source_buffer_bench -spsc [DataSize]
+
+       Streams 4GB through the buffer with a producer thread (memcpy in, PublishWrite) and a
+       consumer thread (GetPublishedRange, read every byte, ReleaseConsumed), in 64-byte,
+       4KB and 64KB chunks, against doing both on one thread the way UpdateTerminalBuffer
+       does, and prints GB/s and how often each side found the other one in its way.  -check
+       also runs the two threads over 256MB and checks every byte the consumer sees.
+
+   source_buffer_bench -file [DataSize]
+
+       Fills a file-backed buffer (1GB by default, in source_buffer_bench.rtsb in the current
+       directory) with lines, closes it, and times reopening it and reading the last screen,
+       against the one pass over the whole thing that replaying the output would take.
+
+   source_buffer_bench -cold [TotalSize]
+
+       Streams TotalSize bytes (1GB by default) of generated log output through a 16MB
+       scrollback with a cold scrollback (refterm_example_cold_scrollback) behind it, then
+       checks that everything the cold store still holds reads back right, and prints the
+       compression ratio, the archiving speed, how much history fits, and how long reading
+       a screen of cold lines takes when paging up and when jumping around.
+
+   source_buffer_bench -lines [LineCount]
+
+       Appends LineCount lines (10 million by default) to a line index the size of the
+       terminal's, with the usual props and again with different props on every line, and
+       prints the time per append and per random lookup and the memory per line, against the
+       example_line records the terminal used to keep.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS 1
+#if !_WIN32
+#define _GNU_SOURCE 1 // NOTE: For memfd_create
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if _WIN32
+#include <windows.h>
+#include <intrin.h>
+#pragma comment (lib, "user32") // NOTE: MessageBoxW when the ring can't be mapped
+#pragma comment (lib, "advapi32") // NOTE: The token calls that enable large pages
+#pragma comment (lib, "mincore") // NOTE: VirtualAlloc2 and MapViewOfFile3
+#else
+#include <x86intrin.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "refterm.h"
+#include "refterm_example_source_buffer.h"
+#include "refterm_example_source_buffer.c"
+#include "refterm_example_cold_scrollback.h"
+#include "refterm_example_cold_scrollback.c"
+#include "refterm_example_line_index.h"
+#include "refterm_example_line_index.c"
+
+static double GetSeconds(void)
+{
+#if _WIN32
+    LARGE_INTEGER Frequency, Counter;
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    double Result = (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    double Result = (double)Time.tv_sec + 1e-9*(double)Time.tv_nsec;
+#endif
+    return Result;
+}
+
+static uint64_t RandomState = 0x9e3779b97f4a7c15ull;
+static uint64_t RandomU64(void)
+{
+    // NOTE: xorshift64*, which is plenty for generating test output
+    RandomState ^= RandomState >> 12;
+    RandomState ^= RandomState << 25;
+    RandomState ^= RandomState >> 27;
+    uint64_t Result = RandomState*0x2545f4914f6cdd1dull;
+    return Result;
+}
+
+static char ExpectedByte(size_t AbsoluteP)
+{
+    // NOTE: Doesn't repeat with any power-of-two period, so a read from the wrong half (or the wrong lap) shows up
+    uint64_t Mixed = (uint64_t)AbsoluteP*0x9e3779b97f4a7c15ull;
+    char Result = (char)(Mixed >> 56);
+    return Result;
+}
+
+static int CheckRange(source_buffer *Buffer, size_t AbsoluteP, size_t Count)
+{
+    int Result = 1;
+
+    source_buffer_range Range = ReadSourceAt(Buffer, AbsoluteP, Count);
+    if((Range.AbsoluteP != AbsoluteP) || (Range.Count != Count))
+    {
+        printf("FAILED: ReadSourceAt(%llu, %llu) returned %llu bytes at %llu\n",
+               (unsigned long long)AbsoluteP, (unsigned long long)Count,
+               (unsigned long long)Range.Count, (unsigned long long)Range.AbsoluteP);
+        Result = 0;
+    }
+    else
+    {
+        for(size_t Index = 0; Index < Count; ++Index)
+        {
+            if(Range.Data[Index] != ExpectedByte(AbsoluteP + Index))
+            {
+                printf("FAILED: byte %llu of the buffer (relative %llu) is wrong\n",
+                       (unsigned long long)(AbsoluteP + Index),
+                       (unsigned long long)((AbsoluteP + Index) % Buffer->DataSize));
+                Result = 0;
+                break;
+            }
+        }
+    }
+
+    return Result;
+}
+
+static int CheckBuffer(size_t RequestedSize, int UseHugePages)
+{
+    source_buffer Buffer = AllocateSourceBuffer(RequestedSize, UseHugePages);
+    if(!Buffer.Data)
+    {
+        printf("FAILED: could not allocate a %llu byte buffer\n", (unsigned long long)RequestedSize);
+        return 0;
+    }
+
+    size_t DataSize = Buffer.DataSize;
+    int Result = (DataSize >= RequestedSize);
+
+    // NOTE: A write through the second view is the same memory as the start of the first
+    Buffer.Data[DataSize] = 'A';
+    Buffer.Data[2*DataSize - 1] = 'B';
+    if((Buffer.Data[0] != 'A') || (Buffer.Data[DataSize - 1] != 'B'))
+    {
+        printf("FAILED: the two views of a %llu byte buffer are not the same memory\n", (unsigned long long)DataSize);
+        Result = 0;
+    }
+
+    // NOTE: Commit sizes jump around between 1 byte and everything IsInBuffer can hold, so the wrap keeps falling somewhere new
+    size_t CommitSize = 1;
+    size_t WrapCount = 0;
+    size_t PinP = 0;
+    while(Result && (WrapCount < 64))
+    {
+        // NOTE: Every so often, hold back from the start of an earlier commit, which then has to survive this one
+        int Pinned = ((WrapCount & 1) && IsInBuffer(&Buffer, PinP));
+        if(Pinned && (CommitSize > GetWritableCountBefore(&Buffer, PinP)))
+        {
+            CommitSize = GetWritableCountBefore(&Buffer, PinP);
+        }
+
+        source_buffer_range Dest = GetNextWritableRange(&Buffer, CommitSize);
+        if(Dest.Count != CommitSize)
+        {
+            printf("FAILED: asked for %llu writable bytes and got %llu\n",
+                   (unsigned long long)CommitSize, (unsigned long long)Dest.Count);
+            Result = 0;
+            break;
+        }
+
+        for(size_t Index = 0; Index < Dest.Count; ++Index)
+        {
+            Dest.Data[Index] = ExpectedByte(Dest.AbsoluteP + Index);
+        }
+
+        size_t OldRelative = Buffer.RelativePoint;
+        CommitWrite(&Buffer, Dest.Count);
+        if(Dest.Count && (Buffer.RelativePoint <= OldRelative))
+        {
+            ++WrapCount;
+        }
+
+        if(Pinned && !IsInBuffer(&Buffer, PinP))
+        {
+            printf("FAILED: a write of GetWritableCountBefore bytes wrote over byte %llu\n", (unsigned long long)PinP);
+            Result = 0;
+        }
+        if(!Pinned || !CommitSize)
+        {
+            PinP = Dest.AbsoluteP;
+        }
+
+        // NOTE: IsInBuffer keeps back one byte short of a whole buffer, the byte the next write starts on
+        size_t EndP = GetCurrentAbsoluteP(&Buffer);
+        size_t Oldest = (EndP > (DataSize - 1)) ? (EndP - (DataSize - 1)) : 0;
+
+        // NOTE: The whole commit, the whole buffer, and a range that starts before the wrap point and ends after it
+        Result = Result && (!Dest.Count || CheckRange(&Buffer, Dest.AbsoluteP, Dest.Count));
+        Result = Result && CheckRange(&Buffer, Oldest, EndP - Oldest);
+        if(Buffer.RelativePoint && (EndP - Oldest > Buffer.RelativePoint))
+        {
+            size_t Before = (EndP - Oldest - Buffer.RelativePoint) / 2;
+            size_t StartP = EndP - Buffer.RelativePoint - Before;
+            Result = Result && CheckRange(&Buffer, StartP, Before + (Buffer.RelativePoint + 1) / 2);
+        }
+
+        // NOTE: Anything older than one buffer's worth has been overwritten, and anything past the end hasn't been written
+        if(Result && (Oldest && IsInBuffer(&Buffer, Oldest - 1)))
+        {
+            printf("FAILED: overwritten byte %llu still reads as in the buffer\n", (unsigned long long)(Oldest - 1));
+            Result = 0;
+        }
+        if(Result && ReadSourceAt(&Buffer, EndP, 1).Count)
+        {
+            printf("FAILED: unwritten byte %llu reads as in the buffer\n", (unsigned long long)EndP);
+            Result = 0;
+        }
+
+        CommitSize = (CommitSize*5 + 3) % (DataSize - 1) + 1;
+    }
+
+    printf("%10llu byte buffer on %4lluKB pages: %s\n", (unsigned long long)DataSize,
+           (unsigned long long)(Buffer.PageSize >> 10), Result ? "ok" : "FAILED");
+
+    FreeSourceBuffer(&Buffer);
+    return Result;
+}
+
+static int WriteAndCheck(source_buffer *Buffer, size_t TotalSize, uint64_t *CommitCount)
+{
+    // NOTE: Commits of all sizes, checking each one and the whole buffer, and counting them in *CommitCount
+    int Result = 1;
+
+    size_t DataSize = Buffer->DataSize;
+    size_t CommitSize = 1;
+    for(size_t Written = 0; Result && (Written < TotalSize); Written += CommitSize)
+    {
+        CommitSize = (CommitSize*5 + 3) % (DataSize - 1) + 1;
+        source_buffer_range Dest = GetNextWritableRange(Buffer, CommitSize);
+        for(size_t Index = 0; Index < Dest.Count; ++Index)
+        {
+            Dest.Data[Index] = ExpectedByte(Dest.AbsoluteP + Index);
+        }
+
+        CommitWrite(Buffer, Dest.Count);
+        ++*CommitCount;
+        SaveSourceBufferFile(Buffer);
+
+        size_t EndP = GetCurrentAbsoluteP(Buffer);
+        size_t Oldest = (EndP > (DataSize - 1)) ? (EndP - (DataSize - 1)) : 0;
+        Result = CheckRange(Buffer, Dest.AbsoluteP, Dest.Count) && CheckRange(Buffer, Oldest, EndP - Oldest);
+    }
+
+    return Result;
+}
+
+static int CheckFileBuffer(char *Path)
+{
+    int Result = 1;
+
+    size_t ExtraSize = 3*sizeof(uint64_t);
+    remove(Path);
+
+    // NOTE: A new file, written a couple of times around
+    source_buffer Buffer = AllocateFileSourceBuffer(Path, 1024*1024, ExtraSize);
+    uint64_t *Extra = (uint64_t *)GetSourceBufferFileExtra(&Buffer);
+    if(!Buffer.Data || !Extra || Buffer.AbsoluteFilledSize || Extra[0] || Extra[2])
+    {
+        printf("FAILED: could not make a new file-backed buffer in %s\n", Path);
+        remove(Path);
+        return 0;
+    }
+
+    size_t DataSize = Buffer.DataSize;
+    Result = WriteAndCheck(&Buffer, 5*DataSize/2, &Extra[0]);
+    Extra[2] = 0x5245464552;
+
+    // NOTE: Nobody else gets to write it while it's open
+    source_buffer Second = AllocateFileSourceBuffer(Path, 1024*1024, ExtraSize);
+    if(Second.Data)
+    {
+        printf("FAILED: a file-backed buffer was opened twice\n");
+        FreeSourceBuffer(&Second);
+        Result = 0;
+    }
+
+    size_t SavedFilledSize = Buffer.AbsoluteFilledSize;
+    uint64_t SavedCommitCount = Extra[0];
+    FreeSourceBuffer(&Buffer);
+
+    // NOTE: Reopened, with the file's own DataSize whatever is asked for, and carrying on from where it was
+    Buffer = AllocateFileSourceBuffer(Path, 4096, ExtraSize);
+    Extra = (uint64_t *)GetSourceBufferFileExtra(&Buffer);
+    if(!Buffer.Data || (Buffer.DataSize != DataSize) || (Buffer.AbsoluteFilledSize != SavedFilledSize) ||
+       (Extra[0] != SavedCommitCount) || (Extra[2] != 0x5245464552))
+    {
+        printf("FAILED: reopening the file-backed buffer did not give it back as it was\n");
+        Result = 0;
+    }
+    else
+    {
+        size_t EndP = GetCurrentAbsoluteP(&Buffer);
+        Result = Result && CheckRange(&Buffer, EndP - (DataSize - 1), DataSize - 1);
+        Result = Result && WriteAndCheck(&Buffer, DataSize, &Extra[0]);
+    }
+    FreeSourceBuffer(&Buffer);
+
+    // NOTE: A different layout of the caller's bytes is refused, and so is a file that isn't one of these
+    Buffer = AllocateFileSourceBuffer(Path, 1024*1024, ExtraSize + 8);
+    if(Buffer.Data)
+    {
+        printf("FAILED: a file-backed buffer was opened with the wrong ExtraSize\n");
+        FreeSourceBuffer(&Buffer);
+        Result = 0;
+    }
+    remove(Path);
+
+    char Text[] = "not a scrollback\n";
+    FILE *Other = fopen(Path, "wb");
+    if(Other)
+    {
+        fwrite(Text, 1, sizeof(Text) - 1, Other);
+        fclose(Other);
+
+        Buffer = AllocateFileSourceBuffer(Path, 1024*1024, ExtraSize);
+        char Back[sizeof(Text)] = {0};
+        Other = fopen(Path, "rb");
+        size_t BackCount = Other ? fread(Back, 1, sizeof(Back), Other) : 0;
+        if(Other) fclose(Other);
+        if(Buffer.Data || (BackCount != sizeof(Text) - 1) || memcmp(Back, Text, BackCount))
+        {
+            printf("FAILED: a file that isn't a scrollback was opened or changed\n");
+            FreeSourceBuffer(&Buffer);
+            Result = 0;
+        }
+    }
+    remove(Path);
+
+    printf("%10llu byte buffer in a file: %s\n", (unsigned long long)DataSize, Result ? "ok" : "FAILED");
+
+    return Result;
+}
+
+static uint64_t SumChunk(char *Data, size_t Count)
+{
+    // NOTE: Stands in for the parser actually looking at what it reads
+    uint64_t Result = 0;
+    size_t Index = 0;
+    for(; (Index + 8) <= Count; Index += 8)
+    {
+        uint64_t Value;
+        memcpy(&Value, Data + Index, 8);
+        Result += Value;
+    }
+    for(; Index < Count; ++Index)
+    {
+        Result += (char unsigned)Data[Index];
+    }
+
+    return Result;
+}
+
+static uint64_t StreamMagic(source_buffer *Buffer, char *Source, size_t ChunkSize, size_t TotalSize)
+{
+    uint64_t Sink = 0;
+    for(size_t Written = 0; Written < TotalSize; Written += ChunkSize)
+    {
+        source_buffer_range Dest = GetNextWritableRange(Buffer, ChunkSize);
+        memcpy(Dest.Data, Source, Dest.Count);
+        CommitWrite(Buffer, Dest.Count);
+
+        source_buffer_range Range = ReadSourceAt(Buffer, Dest.AbsoluteP, Dest.Count);
+        Sink += SumChunk(Range.Data, Range.Count);
+    }
+
+    return Sink;
+}
+
+// NOTE: Not a power of two, so the pattern never lines up with the buffer's wrap point
+#define SPSC_PERIOD ((1 << 17) - 1)
+
+typedef struct
+{
+    source_buffer *Buffer;
+    char *Source; // NOTE: 2*SPSC_PERIOD bytes, so a chunk of up to SPSC_PERIOD starting anywhere in the first half is contiguous
+    size_t ChunkSize;
+    size_t TotalSize;
+    int Verify;
+
+    size_t StallCount; // NOTE: How often it found no room to write (producer) or nothing new to read (consumer)
+    uint64_t Sink;
+    int Failed;
+} spsc_side;
+
+static void WaitForOtherSide(uint32_t *SpinCount)
+{
+    // NOTE: Spin briefly, since the other side is usually only a moment away, then give up the core in case it needs this one
+    if(++*SpinCount < 64)
+    {
+        _mm_pause();
+    }
+    else
+    {
+#if _WIN32
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+        *SpinCount = 0;
+    }
+}
+
+#if _WIN32
+static DWORD WINAPI ProducerThreadProc(LPVOID Param)
+#else
+static void *ProducerThreadProc(void *Param)
+#endif
+{
+    // NOTE: Stands in for a thread that does nothing but ReadFile from the child's pipe into the buffer
+    spsc_side *Side = (spsc_side *)Param;
+    source_buffer *Buffer = Side->Buffer;
+
+    uint32_t SpinCount = 0;
+    size_t Written = 0;
+    while(Written < Side->TotalSize)
+    {
+        size_t Want = Side->TotalSize - Written;
+        if(Want > Side->ChunkSize)
+        {
+            Want = Side->ChunkSize;
+        }
+
+        source_buffer_range Dest = GetProducerWritableRange(Buffer, Want);
+        if(Dest.Count)
+        {
+            memcpy(Dest.Data, Side->Source + (Dest.AbsoluteP % SPSC_PERIOD), Dest.Count);
+            PublishWrite(Buffer, Dest.Count);
+            Written += Dest.Count;
+            SpinCount = 0;
+        }
+        else
+        {
+            ++Side->StallCount;
+            WaitForOtherSide(&SpinCount);
+        }
+    }
+
+    return 0;
+}
+
+#if _WIN32
+static DWORD WINAPI ConsumerThreadProc(LPVOID Param)
+#else
+static void *ConsumerThreadProc(void *Param)
+#endif
+{
+    // NOTE: Stands in for the terminal thread parsing whatever has come in
+    spsc_side *Side = (spsc_side *)Param;
+    source_buffer *Buffer = Side->Buffer;
+
+    size_t StartP = Buffer->ConsumerP;
+    size_t P = StartP;
+    uint32_t SpinCount = 0;
+    while((P - StartP) < Side->TotalSize)
+    {
+        source_buffer_range Range = GetPublishedRange(Buffer, P, Side->ChunkSize);
+        if(Range.Count)
+        {
+            if(Side->Verify)
+            {
+                if(memcmp(Range.Data, Side->Source + (P % SPSC_PERIOD), Range.Count) != 0)
+                {
+                    Side->Failed = 1;
+                }
+            }
+            else
+            {
+                Side->Sink += SumChunk(Range.Data, Range.Count);
+            }
+
+            P += Range.Count;
+            ReleaseConsumed(Buffer, P);
+            SpinCount = 0;
+        }
+        else
+        {
+            ++Side->StallCount;
+            WaitForOtherSide(&SpinCount);
+        }
+    }
+
+    return 0;
+}
+
+static void RunProducerConsumer(spsc_side *Producer, spsc_side *Consumer)
+{
+#if _WIN32
+    HANDLE Threads[2];
+    Threads[0] = CreateThread(0, 0, ConsumerThreadProc, Consumer, 0, 0);
+    Threads[1] = CreateThread(0, 0, ProducerThreadProc, Producer, 0, 0);
+    WaitForMultipleObjects(2, Threads, TRUE, INFINITE);
+    CloseHandle(Threads[0]);
+    CloseHandle(Threads[1]);
+#else
+    pthread_t Threads[2];
+    pthread_create(&Threads[0], 0, ConsumerThreadProc, Consumer);
+    pthread_create(&Threads[1], 0, ProducerThreadProc, Producer);
+    pthread_join(Threads[0], 0);
+    pthread_join(Threads[1], 0);
+#endif
+}
+
+static char *MakeSPSCSource(void)
+{
+    char *Result = (char *)malloc(2*SPSC_PERIOD);
+    for(size_t Index = 0; Index < 2*SPSC_PERIOD; ++Index)
+    {
+        Result[Index] = ExpectedByte(Index % SPSC_PERIOD);
+    }
+
+    return Result;
+}
+
+static int CheckProducerConsumer(size_t DataSize, size_t ChunkSize)
+{
+    source_buffer Buffer = AllocateSourceBuffer(DataSize, 0);
+    if(!Buffer.Data)
+    {
+        printf("FAILED: could not allocate a %llu byte buffer\n", (unsigned long long)DataSize);
+        return 0;
+    }
+
+    char *Source = MakeSPSCSource();
+
+    spsc_side Producer = {0};
+    Producer.Buffer = &Buffer;
+    Producer.Source = Source;
+    Producer.ChunkSize = ChunkSize;
+    Producer.TotalSize = 256*1024*1024;
+
+    // NOTE: The consumer takes differently sized bites than the producer, so their ranges don't line up
+    spsc_side Consumer = Producer;
+    Consumer.ChunkSize = ChunkSize/2 + 7;
+    Consumer.Verify = 1;
+
+    RunProducerConsumer(&Producer, &Consumer);
+
+    int Result = (!Consumer.Failed && (Buffer.ConsumerP == Producer.TotalSize) &&
+                  (Buffer.PublishedFilledSize == Producer.TotalSize));
+    printf("%10llu byte buffer, %5llu byte chunks, producer and consumer threads: %s\n",
+           (unsigned long long)Buffer.DataSize, (unsigned long long)ChunkSize, Result ? "ok" : "FAILED");
+
+    free(Source);
+    FreeSourceBuffer(&Buffer);
+    return Result;
+}
+
+static uint32_t TestLineLength(size_t Line)
+{
+    // NOTE: Mostly log-line lengths, with the odd line as long as ParseLines lets one get
+    uint64_t Mixed = (uint64_t)Line*0x9e3779b97f4a7c15ull;
+    uint32_t Result = (uint32_t)((Mixed >> 32) % 160);
+    if((Mixed >> 56) == 0)
+    {
+        Result = 4096;
+    }
+    return Result;
+}
+
+static glyph_props TestLineProps(size_t Line, int Rainbow)
+{
+    // NOTE: Usually the default colors, sometimes one of a few others; or, for Rainbow, different on every line
+    glyph_props Result = {0x00afafaf, 0x000c0c0c, 0};
+    uint64_t Mixed = (uint64_t)Line*0xc2b2ae3d27d4eb4full;
+    if(Rainbow)
+    {
+        Result.Foreground = (uint32_t)(Line & 0xffffff);
+        Result.Flags = (uint32_t)((Line >> 24) & 0xff);
+    }
+    else if((Mixed >> 60) == 0)
+    {
+        Result.Foreground = 0x00ff0000 >> ((Mixed >> 56) & 7);
+        Result.Flags = (uint32_t)(Mixed >> 54) & 1;
+    }
+    return Result;
+}
+
+static uint32_t TestLineIsComplex(size_t Line)
+{
+    uint32_t Result = (((uint64_t)Line*0xff51afd7ed558ccdull) >> 59) == 1;
+    return Result;
+}
+
+static int CheckLine(line_index *Index, size_t Line, size_t FirstP, size_t OnePastLastP, uint32_t Complex, int Rainbow)
+{
+    example_line Got = GetLine(Index, Line);
+    glyph_props Props = TestLineProps(Line, Rainbow);
+    int Result = ((Got.FirstP == FirstP) &&
+                  (Got.OnePastLastP == OnePastLastP) &&
+                  ((Got.ContainsComplexChars != 0) == (Complex != 0)) &&
+                  PropsAreEqual(Got.StartingProps, Props));
+    if(!Result)
+    {
+        printf("FAILED: line %llu read back as [%llu, %llu) complex %u, not [%llu, %llu) complex %u\n",
+               (unsigned long long)Line, (unsigned long long)Got.FirstP, (unsigned long long)Got.OnePastLastP,
+               Got.ContainsComplexChars, (unsigned long long)FirstP, (unsigned long long)OnePastLastP, Complex);
+    }
+    return Result;
+}
+
+static int CheckAllLines(line_index *Index, size_t *FirstPs, int Rainbow)
+{
+    int Result = 1;
+    line_index_state *State = &Index->State;
+    for(size_t Line = State->FirstLine; Result && (Line < State->OnePastLastLine); ++Line)
+    {
+        // NOTE: The last line is the one that was just started
+        if((Line + 1) < State->OnePastLastLine)
+        {
+            Result = CheckLine(Index, Line, FirstPs[Line], FirstPs[Line + 1], TestLineIsComplex(Line), Rainbow);
+        }
+        else
+        {
+            Result = CheckLine(Index, Line, FirstPs[Line], State->CurrentEndP, 0, Rainbow);
+        }
+    }
+
+    // NOTE: Lines that were dropped, or haven't come yet, are empty
+    if(Result)
+    {
+        example_line Before = GetLine(Index, State->FirstLine - 1);
+        example_line After = GetLine(Index, State->OnePastLastLine);
+        Result = ((Before.FirstP == 0) && (Before.OnePastLastP == 0) &&
+                  (After.FirstP == 0) && (After.OnePastLastP == 0));
+        if(!Result)
+        {
+            printf("FAILED: lines outside [%llu, %llu) are not empty\n",
+                   (unsigned long long)State->FirstLine, (unsigned long long)State->OnePastLastLine);
+        }
+    }
+
+    return Result;
+}
+
+static int CheckLineIndex(uint32_t MaxChunkCount, uint32_t MaxPropsCount, size_t LineCount, int Rainbow)
+{
+    int Result = 1;
+
+    line_index Index = AllocateLineIndex(MaxChunkCount, MaxPropsCount);
+    size_t *FirstPs = (size_t *)malloc((LineCount + 1)*sizeof(size_t));
+    size_t MaxLineCount = (size_t)MaxChunkCount*LINE_CHUNK_SIZE;
+
+    // NOTE: Built the way ParseLines builds it: the current line grows, then the next one starts where it ends
+    FirstPs[0] = 0;
+    ResetLineIndex(&Index, 0, TestLineProps(0, Rainbow));
+    for(size_t Line = 0; Result && (Line < LineCount); ++Line)
+    {
+        size_t OnePastLastP = FirstPs[Line] + TestLineLength(Line);
+        SetCurrentLineEnd(&Index, FirstPs[Line] + TestLineLength(Line)/2);
+        MarkCurrentLineComplex(&Index, TestLineIsComplex(Line));
+        SetCurrentLineEnd(&Index, OnePastLastP);
+        Result = ((GetCurrentLine(&Index) == Line) &&
+                  (GetCurrentLineLength(&Index) == TestLineLength(Line)) &&
+                  CheckLine(&Index, Line, FirstPs[Line], OnePastLastP, TestLineIsComplex(Line), Rainbow));
+
+        AppendLine(&Index, OnePastLastP, TestLineProps(Line + 1, Rainbow));
+        FirstPs[Line + 1] = OnePastLastP;
+
+        // NOTE: Only running out of props (which takes Rainbow) drops lines before the chunks are all used
+        size_t Count = GetLineIndexCount(&Index);
+        if((Index.State.FirstLine % LINE_CHUNK_SIZE) ||
+           (Count > MaxLineCount) ||
+           (!Rainbow && (Count <= (MaxLineCount - LINE_CHUNK_SIZE)) && (Index.State.FirstLine != 0)))
+        {
+            printf("FAILED: %llu lines from %llu after appending line %llu\n", (unsigned long long)Count,
+                   (unsigned long long)Index.State.FirstLine, (unsigned long long)(Line + 1));
+            Result = 0;
+        }
+
+        if(Result && ((Line % 997) == 0))
+        {
+            Result = CheckAllLines(&Index, FirstPs, Rainbow);
+        }
+    }
+
+    if(Result)
+    {
+        Result = CheckAllLines(&Index, FirstPs, Rainbow);
+    }
+
+    // NOTE: What reopening a scrollback file does: the same chunks and props, and the saved state
+    size_t MemorySize = GetLineIndexMemorySize(MaxChunkCount, MaxPropsCount);
+    char *Copy = (char *)malloc(MemorySize);
+    memcpy(Copy, Index.Chunks, MemorySize);
+    line_index Attached;
+    if(Result)
+    {
+        Result = (AttachLineIndex(&Attached, Copy, MaxChunkCount, MaxPropsCount, Index.State) &&
+                  CheckAllLines(&Attached, FirstPs, Rainbow));
+        if(!Result)
+        {
+            printf("FAILED: the index didn't come back from its state\n");
+        }
+    }
+    if(Result)
+    {
+        Result = (!AttachLineIndex(&Attached, Copy, 2*MaxChunkCount, MaxPropsCount, Index.State) &&
+                  (GetLineIndexCount(&Attached) == 0) &&
+                  (GetLine(&Attached, Index.State.FirstLine).OnePastLastP == 0));
+        if(!Result)
+        {
+            printf("FAILED: the index came back from the state of a different size\n");
+        }
+    }
+
+    if(Result)
+    {
+        size_t FirstP = FirstPs[LineCount] + 12345;
+        ResetLineIndex(&Index, FirstP, TestLineProps(1, 1));
+        example_line Got = GetLine(&Index, GetCurrentLine(&Index));
+        Result = ((GetLineIndexCount(&Index) == 1) &&
+                  (Got.FirstP == FirstP) && (Got.OnePastLastP == FirstP) &&
+                  PropsAreEqual(Got.StartingProps, TestLineProps(1, 1)));
+        if(!Result)
+        {
+            printf("FAILED: the index didn't start over\n");
+        }
+    }
+
+    printf("%9llu lines in %u chunks, %7u props%s: %s\n", (unsigned long long)LineCount, MaxChunkCount, MaxPropsCount,
+           Rainbow ? ", different on every line" : "", Result ? "ok" : "FAILED");
+
+    free(Copy);
+    free(FirstPs);
+    FreeLineIndex(&Index);
+
+    return Result;
+}
+
+static int CheckSourceBuffers(void)
+{
+    int Result = 1;
+
+    size_t Sizes[] = {1, 4096, 65536 + 1, 1024*1024, 16*1024*1024};
+    for(uint32_t SizeIndex = 0; SizeIndex < ArrayCount(Sizes); ++SizeIndex)
+    {
+        Result = CheckBuffer(Sizes[SizeIndex], 0) && Result;
+    }
+
+    // NOTE: Whatever the huge page request actually got, including the fallbacks
+    Result = CheckBuffer(1, 1) && Result;
+    Result = CheckBuffer(16*1024*1024, 1) && Result;
+
+    Result = CheckFileBuffer("source_buffer_bench_check.rtsb") && Result;
+
+    // NOTE: A buffer small enough that the producer is forever waiting on the consumer, and a big one where it mostly isn't
+    Result = CheckProducerConsumer(65536, 4096) && Result;
+    Result = CheckProducerConsumer(16*1024*1024, 65536) && Result;
+
+    // NOTE: Small enough that the chunks wrap many times over, and, with different props on every line, that the props do
+    Result = CheckLineIndex(4, 2*LINE_CHUNK_SIZE, 100000, 0) && Result;
+    Result = CheckLineIndex(4, 2*LINE_CHUNK_SIZE, 100000, 1) && Result;
+    Result = CheckLineIndex(64, 1024*1024, 300000, 0) && Result;
+
+    return Result;
+}
+
+static void BenchProducerConsumer(size_t DataSize)
+{
+    source_buffer Buffer = AllocateSourceBuffer(DataSize, 0);
+    if(!Buffer.Data)
+    {
+        printf("Could not allocate a %llu byte buffer\n", (unsigned long long)DataSize);
+        return;
+    }
+
+    char *Source = MakeSPSCSource();
+    size_t ChunkSizes[] = {64, 4096, 65536};
+    size_t TotalSize = (size_t)4 << 30;
+
+    memset(Buffer.Data, 0, Buffer.DataSize);
+
+    printf("DataSize=%llu, %llu MB streamed per run\n", (unsigned long long)Buffer.DataSize, (unsigned long long)(TotalSize >> 20));
+    for(uint32_t ChunkIndex = 0; ChunkIndex < ArrayCount(ChunkSizes); ++ChunkIndex)
+    {
+        size_t ChunkSize = ChunkSizes[ChunkIndex];
+
+        // NOTE: One thread, write then read, the way UpdateTerminalBuffer does it today
+        double Start = GetSeconds();
+        uint64_t Sink = StreamMagic(&Buffer, Source, ChunkSize, TotalSize);
+        double Middle = GetSeconds();
+
+        // NOTE: StreamMagic used the single-threaded calls, so the two sides start from where it left off
+        Buffer.PublishedFilledSize = Buffer.CachedPublishedSize = Buffer.AbsoluteFilledSize;
+        Buffer.ConsumerP = Buffer.CachedConsumerP = Buffer.AbsoluteFilledSize;
+
+        spsc_side Producer = {0};
+        Producer.Buffer = &Buffer;
+        Producer.Source = Source;
+        Producer.ChunkSize = ChunkSize;
+        Producer.TotalSize = TotalSize;
+        spsc_side Consumer = Producer;
+
+        RunProducerConsumer(&Producer, &Consumer);
+        double End = GetSeconds();
+        Sink += Consumer.Sink;
+
+        printf("%6llu byte chunks:  one thread %6.2f GB/s  two threads %6.2f GB/s  (producer stalled %llu, consumer %llu times)  (%x)\n",
+               (unsigned long long)ChunkSize,
+               (double)TotalSize / (1e9*(Middle - Start)), (double)TotalSize / (1e9*(End - Middle)),
+               (unsigned long long)Producer.StallCount, (unsigned long long)Consumer.StallCount, (uint32_t)(Sink & 0xf));
+    }
+
+    free(Source);
+    FreeSourceBuffer(&Buffer);
+}
+
+static char *AllocateSplitRing(size_t DataSize)
+{
+    /* NOTE: Page-backed like the source buffer, so the comparison is only about the mapping.
+       On Linux a big malloc can end up on transparent huge pages, which the memfd's shmem
+       pages usually aren't, and that alone made the ordinary ring look 30% faster. */
+#if _WIN32
+    char *Result = (char *)VirtualAlloc(0, DataSize, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+#else
+    char *Result = (char *)mmap(0, DataSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    else
+    {
+        madvise(Result, DataSize, MADV_NOHUGEPAGE);
+    }
+#endif
+    return Result;
+}
+
+static void FreeSplitRing(char *Ring, size_t DataSize)
+{
+#if _WIN32
+    VirtualFree(Ring, 0, MEM_RELEASE);
+#else
+    munmap(Ring, DataSize);
+#endif
+}
+
+static uint64_t StreamSplit(char *Ring, size_t RingSize, char *Source, size_t ChunkSize, size_t TotalSize)
+{
+    // NOTE: An ordinary ring buffer, which has to split anything that crosses the end in two
+    uint64_t Sink = 0;
+    size_t Relative = 0;
+    for(size_t Written = 0; Written < TotalSize; Written += ChunkSize)
+    {
+        size_t First = RingSize - Relative;
+        if(First > ChunkSize)
+        {
+            First = ChunkSize;
+        }
+
+        memcpy(Ring + Relative, Source, First);
+        memcpy(Ring, Source + First, ChunkSize - First);
+
+        Sink += SumChunk(Ring + Relative, First);
+        Sink += SumChunk(Ring, ChunkSize - First);
+
+        Relative += ChunkSize;
+        if(Relative >= RingSize)
+        {
+            Relative -= RingSize;
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchThroughput(size_t DataSize)
+{
+    source_buffer Buffer = AllocateSourceBuffer(DataSize, 0);
+    if(!Buffer.Data)
+    {
+        printf("Could not allocate a %llu byte buffer\n", (unsigned long long)DataSize);
+        return;
+    }
+
+    DataSize = Buffer.DataSize;
+    char *Ring = AllocateSplitRing(DataSize);
+    if(!Ring)
+    {
+        printf("Could not allocate a %llu byte ring\n", (unsigned long long)DataSize);
+        FreeSourceBuffer(&Buffer);
+        return;
+    }
+
+    size_t ChunkSizes[] = {64, 4096, 65536};
+    size_t TotalSize = (size_t)4 << 30;
+
+    char *Source = (char *)malloc(65536);
+    for(size_t Index = 0; Index < 65536; ++Index)
+    {
+        Source[Index] = ExpectedByte(Index);
+    }
+
+    // NOTE: Touch every page of both first, so page faults aren't counted against whichever runs first
+    memset(Buffer.Data, 0, DataSize);
+    memset(Ring, 0, DataSize);
+
+    printf("DataSize=%llu, %llu MB streamed per run\n", (unsigned long long)DataSize, (unsigned long long)(TotalSize >> 20));
+    for(uint32_t ChunkIndex = 0; ChunkIndex < ArrayCount(ChunkSizes); ++ChunkIndex)
+    {
+        size_t ChunkSize = ChunkSizes[ChunkIndex];
+
+        double Start = GetSeconds();
+        uint64_t Sink = StreamMagic(&Buffer, Source, ChunkSize, TotalSize);
+        double Middle = GetSeconds();
+        Sink += StreamSplit(Ring, DataSize, Source, ChunkSize, TotalSize);
+        double End = GetSeconds();
+
+        printf("%6llu byte chunks:  double-mapped %6.2f GB/s  split ring %6.2f GB/s  (%x)\n",
+               (unsigned long long)ChunkSize,
+               (double)TotalSize / (1e9*(Middle - Start)), (double)TotalSize / (1e9*(End - Middle)),
+               (uint32_t)(Sink & 0xf));
+    }
+
+    free(Source);
+    FreeSplitRing(Ring, DataSize);
+    FreeSourceBuffer(&Buffer);
+}
+
+#if _WIN32
+static int OpenTLBMissCounter(void)
+{
+    // NOTE: There's no user-mode way to read TLB misses on Windows, so this always reports n/a
+    return -1;
+}
+
+static uint64_t ReadTLBMissCounter(int Counter)
+{
+    return 0;
+}
+#else
+static int OpenTLBMissCounter(void)
+{
+    // NOTE: Returns -1 where there is no PMU to count with (most VMs) or perf_event_paranoid forbids it
+    struct perf_event_attr Attributes;
+    memset(&Attributes, 0, sizeof(Attributes));
+    Attributes.size = sizeof(Attributes);
+    Attributes.type = PERF_TYPE_HW_CACHE;
+    Attributes.config = (PERF_COUNT_HW_CACHE_DTLB |
+                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    Attributes.exclude_kernel = 1;
+    Attributes.exclude_hv = 1;
+
+    int Result = (int)syscall(SYS_perf_event_open, &Attributes, 0, -1, -1, 0);
+    return Result;
+}
+
+static uint64_t ReadTLBMissCounter(int Counter)
+{
+    uint64_t Result = 0;
+    if((Counter < 0) || (read(Counter, &Result, sizeof(Result)) != sizeof(Result)))
+    {
+        Result = 0;
+    }
+
+    return Result;
+}
+#endif
+
+static void FillWithLines(source_buffer *Buffer, size_t TotalSize)
+{
+    // NOTE: What splat feeds the terminal: text lines of varying length, read from the pipe in 64KB chunks
+    size_t ChunkSize = 65536;
+    size_t LineLength = 0;
+    for(size_t Written = 0; Written < TotalSize; Written += ChunkSize)
+    {
+        source_buffer_range Dest = GetNextWritableRange(Buffer, ChunkSize);
+        for(size_t Index = 0; Index < Dest.Count; ++Index)
+        {
+            char Byte = ExpectedByte(Dest.AbsoluteP + Index);
+            Dest.Data[Index] = (LineLength++ >= (size_t)(40 + (Byte & 63))) ? '\n' : (char)('a' + (Byte & 15));
+            if(Dest.Data[Index] == '\n')
+            {
+                LineLength = 0;
+            }
+        }
+
+        CommitWrite(Buffer, Dest.Count);
+    }
+}
+
+static uint64_t ParseAll(source_buffer *Buffer, size_t TotalSize)
+{
+    // NOTE: Stands in for ParseLines: one pass over everything as it comes in, finding line ends
+    uint64_t Sink = 0;
+    size_t ChunkSize = 65536;
+    size_t StartP = GetCurrentAbsoluteP(Buffer) - TotalSize;
+    for(size_t Read = 0; Read < TotalSize; Read += ChunkSize)
+    {
+        source_buffer_range Range = ReadSourceAt(Buffer, StartP + Read, ChunkSize);
+        for(size_t Index = 0; Index < Range.Count; ++Index)
+        {
+            Sink += (Range.Data[Index] == '\n');
+        }
+    }
+
+    return Sink;
+}
+
+static uint64_t LayoutRandomScreens(source_buffer *Buffer, uint32_t ScreenCount)
+{
+    /* NOTE: Stands in for LayoutLines while scrolling around a big scrollback: every screen
+       reads 100 lines of ~80 bytes from somewhere else in the buffer, so with 4KB pages
+       nearly every line is on a page the TLB doesn't have. */
+    uint64_t Sink = 0;
+    size_t EndP = GetCurrentAbsoluteP(Buffer);
+    size_t Available = Buffer->DataSize - 1;
+    for(uint32_t ScreenIndex = 0; ScreenIndex < ScreenCount; ++ScreenIndex)
+    {
+        uint64_t Mixed = (uint64_t)(ScreenIndex + 1)*0x9e3779b97f4a7c15ull;
+        size_t ScreenP = EndP - Available + (size_t)((Mixed >> 11) % (Available - 100*80));
+        for(uint32_t LineIndex = 0; LineIndex < 100; ++LineIndex)
+        {
+            // NOTE: Lines of a screen are spread out like a long-line file would spread them
+            size_t LineP = ScreenP + (size_t)LineIndex*(Available / 4096);
+            source_buffer_range Range = ReadSourceAt(Buffer, LineP, 80);
+            Sink += SumChunk(Range.Data, Range.Count);
+        }
+    }
+
+    return Sink;
+}
+
+static void BenchPages(size_t DataSize)
+{
+    int Counter = OpenTLBMissCounter();
+
+    printf("DataSize=%llu, filled twice over, then 200000 screens of 100 scattered lines\n", (unsigned long long)DataSize);
+    for(int UseHugePages = 0; UseHugePages <= 1; ++UseHugePages)
+    {
+        source_buffer Buffer = AllocateSourceBuffer(DataSize, UseHugePages);
+        if(!Buffer.Data)
+        {
+            printf("Could not allocate a %llu byte buffer\n", (unsigned long long)DataSize);
+            continue;
+        }
+
+        size_t TotalSize = 2*Buffer.DataSize;
+
+        double Start = GetSeconds();
+        FillWithLines(&Buffer, TotalSize);
+        double Filled = GetSeconds();
+
+        uint64_t Misses0 = ReadTLBMissCounter(Counter);
+        uint64_t Sink = ParseAll(&Buffer, Buffer.DataSize - 1);
+        double Parsed = GetSeconds();
+        uint64_t Misses1 = ReadTLBMissCounter(Counter);
+        Sink += LayoutRandomScreens(&Buffer, 200000);
+        double LaidOut = GetSeconds();
+        uint64_t Misses2 = ReadTLBMissCounter(Counter);
+
+        char ParseMisses[32] = "n/a";
+        char LayoutMisses[32] = "n/a";
+        if(Counter >= 0)
+        {
+            sprintf(ParseMisses, "%.2f", 1000.0*(double)(Misses1 - Misses0) / (double)Buffer.DataSize);
+            sprintf(LayoutMisses, "%.2f", (double)(Misses2 - Misses1) / 20000000.0);
+        }
+
+        printf("%-6s %4lluKB pages:  fill %6.2f GB/s  parse %6.2f GB/s (%s dTLB misses/KB)  layout %6.1f ns/line (%s dTLB misses/line)  (%x)\n",
+               UseHugePages ? "huge" : "small", (unsigned long long)(Buffer.PageSize >> 10),
+               (double)TotalSize / (1e9*(Filled - Start)), (double)Buffer.DataSize / (1e9*(Parsed - Filled)), ParseMisses,
+               1e9*(LaidOut - Parsed) / 20000000.0, LayoutMisses, (uint32_t)(Sink & 0xf));
+
+        FreeSourceBuffer(&Buffer);
+    }
+
+    if(Counter >= 0)
+    {
+        close(Counter);
+    }
+}
+
+static void BenchFile(size_t DataSize)
+{
+    char *Path = "source_buffer_bench.rtsb";
+    remove(Path);
+
+    source_buffer Buffer = AllocateFileSourceBuffer(Path, DataSize, 0);
+    if(!Buffer.Data)
+    {
+        printf("Could not make a %llu byte buffer in %s\n", (unsigned long long)DataSize, Path);
+        return;
+    }
+
+    DataSize = Buffer.DataSize;
+    double Start = GetSeconds();
+    FillWithLines(&Buffer, DataSize + DataSize/2);
+    double Filled = GetSeconds();
+    FreeSourceBuffer(&Buffer);
+    double Closed = GetSeconds();
+
+    // NOTE: What the terminal does on reopening: map it, then read the lines of the last screen
+    Buffer = AllocateFileSourceBuffer(Path, DataSize, 0);
+    double Opened = GetSeconds();
+    uint64_t Sink = 0;
+    if(Buffer.Data)
+    {
+        source_buffer_range Range = ReadSourceAt(&Buffer, GetCurrentAbsoluteP(&Buffer) - 100*80, 100*80);
+        Sink += SumChunk(Range.Data, Range.Count);
+    }
+    double FirstScreen = GetSeconds();
+
+    // NOTE: What it would take to get the same lines back by replaying the output: one pass over all of it
+    Sink += Buffer.Data ? ParseAll(&Buffer, DataSize - 1) : 0;
+    double Replayed = GetSeconds();
+
+    printf("DataSize=%llu: fill %.2f GB/s, close %.2f ms\n", (unsigned long long)DataSize,
+           (double)(DataSize + DataSize/2) / (1e9*(Filled - Start)), 1e3*(Closed - Filled));
+    printf("reopen %.3f ms, first screen %.3f ms, vs replaying the whole buffer %.1f ms  (%x)\n",
+           1e3*(Opened - Closed), 1e3*(FirstScreen - Opened), 1e3*(Replayed - FirstScreen), (uint32_t)(Sink & 0xf));
+
+    FreeSourceBuffer(&Buffer);
+    remove(Path);
+}
+
+static size_t WriteLogLine(char *Out, uint64_t LineNumber)
+{
+    // NOTE: Build-log-ish output, which is what usually scrolls off the top of a terminal
+    static char *Levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    static char *Words[] = {"compiling", "linking", "src/render/glyph_table.c", "src/terminal/parser.c", "worker",
+                            "request", "completed", "cache", "miss", "retrying", "connection", "\x1b[32mok\x1b[0m",
+                            "\x1b[1;31mfailed\x1b[0m", "bytes", "in", "ms", "from", "to", "user", "session"};
+    uint64_t Random = RandomU64();
+    size_t Count = (size_t)sprintf(Out, "2026-10-17 %02u:%02u:%02u.%03u [%s] ",
+                                   (uint32_t)((LineNumber / 3600000) % 24), (uint32_t)((LineNumber / 60000) % 60),
+                                   (uint32_t)((LineNumber / 1000) % 60), (uint32_t)(LineNumber % 1000),
+                                   Levels[Random % ArrayCount(Levels)]);
+    uint32_t WordCount = 3 + (uint32_t)((Random >> 8) % 10);
+    for(uint32_t WordIndex = 0; WordIndex < WordCount; ++WordIndex)
+    {
+        uint64_t Pick = RandomU64();
+        if((Pick & 7) == 0)
+        {
+            Count += (size_t)sprintf(Out + Count, "%u ", (uint32_t)((Pick >> 8) % 100000));
+        }
+        else
+        {
+            Count += (size_t)sprintf(Out + Count, "%s ", Words[(Pick >> 8) % ArrayCount(Words)]);
+        }
+    }
+    Out[Count - 1] = '\n';
+
+    return Count;
+}
+
+static uint64_t WeighBytes(char *Data, size_t AbsoluteP, size_t Count)
+{
+    // NOTE: Adds up the same however the bytes are split into reads, but not if any of them is in the wrong place
+    uint64_t Result = 0;
+    for(size_t Index = 0; Index < Count; ++Index)
+    {
+        Result += (uint64_t)(char unsigned)Data[Index]*(((uint64_t)(AbsoluteP + Index) << 1) | 1);
+    }
+
+    return Result;
+}
+
+static void BenchCold(size_t TotalSize)
+{
+    /* NOTE: Streams TotalSize bytes of log output through a 16MB scrollback with a 64MB cold
+       store behind it, archiving before every write the way the terminal does.  Every 16th
+       pipe read is random bytes, so the stored-raw path gets used too.  Then checks that
+       everything the cold store still holds reads back right (in reads of random length, so
+       plenty cross block boundaries), and times the kinds of reads scrolling does. */
+    source_buffer Source = AllocateSourceBuffer(16*1024*1024, 0);
+    cold_scrollback Cold = AllocateColdScrollback(64*1024*1024, 16384);
+    if(!Source.Data || !Cold.Store.Data)
+    {
+        printf("Could not allocate the buffers\n");
+        return;
+    }
+
+    size_t BlockCount = TotalSize / COLD_BLOCK_SIZE + 2;
+    uint64_t *WeightBefore = (uint64_t *)calloc(BlockCount, sizeof(uint64_t));
+    char *Chunk = (char *)malloc(65536 + 4096);
+
+    uint64_t LineNumber = 0;
+    uint64_t Weight = 0;
+    double ArchiveSeconds = 0;
+    for(uint32_t ChunkIndex = 0; GetCurrentAbsoluteP(&Source) < TotalSize; ++ChunkIndex)
+    {
+        size_t ChunkCount = 0;
+        if((ChunkIndex % 16) == 15)
+        {
+            for(; ChunkCount < 65536; ChunkCount += 8)
+            {
+                uint64_t Random = RandomU64();
+                memcpy(Chunk + ChunkCount, &Random, 8);
+            }
+        }
+        else
+        {
+            while(ChunkCount < 65536)
+            {
+                ChunkCount += WriteLogLine(Chunk + ChunkCount, LineNumber++);
+            }
+        }
+
+        double Start = GetSeconds();
+        ArchiveColdScrollback(&Cold, &Source, ChunkCount);
+        ArchiveSeconds += GetSeconds() - Start;
+
+        source_buffer_range Dest = GetNextWritableRange(&Source, ChunkCount);
+        memcpy(Dest.Data, Chunk, ChunkCount);
+        for(size_t Index = 0; Index < ChunkCount; ++Index)
+        {
+            size_t P = Dest.AbsoluteP + Index;
+            if((P % COLD_BLOCK_SIZE) == 0)
+            {
+                WeightBefore[P / COLD_BLOCK_SIZE] = Weight;
+            }
+            Weight += (uint64_t)(char unsigned)Chunk[Index]*(((uint64_t)P << 1) | 1);
+        }
+        CommitWrite(&Source, ChunkCount);
+    }
+
+    size_t HeldCount = Cold.OnePastLastP - Cold.FirstP;
+    double AverageLine = (double)(TotalSize - TotalSize/16) / (double)LineNumber;
+    printf("%llu MB streamed, %.0f bytes per log line; the cold store holds %llu MB (~%.1f million lines) in %llu MB\n",
+           (unsigned long long)(TotalSize >> 20), AverageLine, (unsigned long long)(HeldCount >> 20),
+           (double)HeldCount / (AverageLine*1e6), (unsigned long long)(Cold.Store.DataSize >> 20));
+    printf("archived %llu blocks at %.0f MB/s, %.2f:1 overall (the random blocks are stored raw)\n",
+           (unsigned long long)Cold.ArchivedCount, (double)(Cold.ArchivedCount*COLD_BLOCK_SIZE) / (1e6*ArchiveSeconds),
+           (double)(Cold.ArchivedCount*COLD_BLOCK_SIZE) / (double)Cold.CompressedSize);
+
+    // NOTE: Everything the cold store holds, read back in pieces
+    uint64_t ReadWeight = 0;
+    size_t P = Cold.FirstP;
+    int Passed = 1;
+    while(P < Cold.OnePastLastP)
+    {
+        size_t Count = 1 + (size_t)(RandomU64() % 4096);
+        source_buffer_range Range = ReadColdScrollbackAt(&Cold, &Source, P, Count);
+        if((Range.AbsoluteP != P) || (Range.Count != Count))
+        {
+            printf("FAILED: cold read of %llu bytes at %llu returned %llu\n",
+                   (unsigned long long)Count, (unsigned long long)P, (unsigned long long)Range.Count);
+            Passed = 0;
+            break;
+        }
+
+        ReadWeight += WeighBytes(Range.Data, P, Range.Count);
+        P += Range.Count;
+    }
+
+    // NOTE: The last read can run past the cold store into Source, so only whole blocks are compared
+    size_t EndP = P - (P % COLD_BLOCK_SIZE);
+    ReadWeight -= WeighBytes(ReadSourceAt(&Source, EndP, P - EndP).Data, EndP, P - EndP);
+    uint64_t ExpectedWeight = WeightBefore[EndP / COLD_BLOCK_SIZE] - WeightBefore[Cold.FirstP / COLD_BLOCK_SIZE];
+    if(Passed && (ReadWeight != ExpectedWeight))
+    {
+        printf("FAILED: what the cold store read back doesn't match what was written\n");
+        Passed = 0;
+    }
+    printf("read back %llu MB of cold scrollback: %s\n", (unsigned long long)(HeldCount >> 20), Passed ? "ok" : "FAILED");
+
+    // NOTE: Paging up through history a screen at a time mostly hits the block cache, jumping around always misses
+    size_t ScreenBytes = 50*(size_t)AverageLine;
+    size_t DecompressCount = Cold.DecompressCount;
+    uint64_t Sink = 0;
+    double Start = GetSeconds();
+    uint32_t ScreenCount = 0;
+    for(P = Cold.OnePastLastP - ScreenBytes; (P >= Cold.FirstP + ScreenBytes) && (ScreenCount < 20000); P -= ScreenBytes)
+    {
+        for(size_t LineP = P; LineP < P + ScreenBytes; LineP += (size_t)AverageLine)
+        {
+            source_buffer_range Range = ReadColdScrollbackAt(&Cold, &Source, LineP, (size_t)AverageLine);
+            Sink += SumChunk(Range.Data, Range.Count);
+        }
+        ++ScreenCount;
+    }
+    double Middle = GetSeconds();
+    size_t PagingDecompressCount = Cold.DecompressCount - DecompressCount;
+
+    for(uint32_t JumpIndex = 0; JumpIndex < 20000; ++JumpIndex)
+    {
+        P = Cold.FirstP + (size_t)(RandomU64() % (HeldCount - ScreenBytes));
+        for(size_t LineP = P; LineP < P + ScreenBytes; LineP += (size_t)AverageLine)
+        {
+            source_buffer_range Range = ReadColdScrollbackAt(&Cold, &Source, LineP, (size_t)AverageLine);
+            Sink += SumChunk(Range.Data, Range.Count);
+        }
+    }
+    double End = GetSeconds();
+
+    printf("paging up: %.1f us per 50-line screen (%llu decompressions for %u screens)\n",
+           1e6*(Middle - Start) / (double)ScreenCount, (unsigned long long)PagingDecompressCount, ScreenCount);
+    printf("jumping around: %.1f us per 50-line screen  (%x)\n", 1e6*(End - Middle) / 20000.0, (uint32_t)(Sink & 0xf));
+
+    free(Chunk);
+    free(WeightBefore);
+    FreeColdScrollback(&Cold);
+    FreeSourceBuffer(&Source);
+}
+
+static void BenchLineIndex(size_t LineCount)
+{
+    // NOTE: The terminal's sizes
+    uint32_t MaxChunkCount = 4096;
+    uint32_t MaxPropsCount = 1024*1024;
+
+    for(int Rainbow = 0; Rainbow <= 1; ++Rainbow)
+    {
+        line_index Index = AllocateLineIndex(MaxChunkCount, MaxPropsCount);
+        if(!Index.Chunks)
+        {
+            printf("Could not reserve the line index\n");
+            return;
+        }
+
+        double Start = GetSeconds();
+        size_t P = 0;
+        ResetLineIndex(&Index, 0, TestLineProps(0, Rainbow));
+        for(size_t Line = 0; Line < LineCount; ++Line)
+        {
+            P += TestLineLength(Line);
+            MarkCurrentLineComplex(&Index, TestLineIsComplex(Line));
+            SetCurrentLineEnd(&Index, P);
+            AppendLine(&Index, P, TestLineProps(Line + 1, Rainbow));
+        }
+        double Appended = GetSeconds();
+
+        size_t Count = GetLineIndexCount(&Index);
+        size_t FirstLine = Index.State.FirstLine;
+        uint64_t Sink = 0;
+        for(size_t Lookup = 0; Lookup < LineCount; ++Lookup)
+        {
+            example_line Line = GetLine(&Index, FirstLine + RandomU64() % Count);
+            Sink += Line.FirstP + Line.StartingProps.Foreground;
+        }
+        double LookedUp = GetSeconds();
+
+        // NOTE: And every line that is still there reads back as it went in
+        int Passed = 1;
+        P = 0;
+        for(size_t Line = 0; Passed && ((Line + 1) < Index.State.OnePastLastLine); ++Line)
+        {
+            size_t OnePastLastP = P + TestLineLength(Line);
+            if(Line >= FirstLine)
+            {
+                Passed = CheckLine(&Index, Line, P, OnePastLastP, TestLineIsComplex(Line), Rainbow);
+            }
+            P = OnePastLastP;
+        }
+
+        size_t Committed = Index.CommittedChunkSize + Index.CommittedPropsSize;
+        printf("%s%llu lines appended, %llu kept: %.1f ns/append, %.1f ns/random lookup, %.2f bytes/line (%.1fMB committed)%s  (%x)\n",
+               Rainbow ? "props different on every line: " : "", (unsigned long long)LineCount, (unsigned long long)Count,
+               1e9*(Appended - Start) / (double)LineCount, 1e9*(LookedUp - Appended) / (double)LineCount,
+               (double)Committed / (double)Count, (double)Committed / (1024.0*1024.0), Passed ? "" : " FAILED",
+               (uint32_t)(Sink & 0xf));
+
+        FreeLineIndex(&Index);
+    }
+
+    printf("vs %u bytes/line for example_line records: %.1fMB for the same lines\n",
+           (uint32_t)sizeof(example_line), (double)(LineCount*sizeof(example_line)) / (1024.0*1024.0));
+}
+
+int main(int ArgCount, char **Args)
+{
+    char *Mode = (ArgCount > 1) ? Args[1] : "-check";
+    if(strcmp(Mode, "-check") == 0)
+    {
+        int Passed = CheckSourceBuffers();
+        return Passed ? 0 : 1;
+    }
+    else if(strcmp(Mode, "-throughput") == 0)
+    {
+        size_t DataSize = 16*1024*1024;
+        if(ArgCount > 2)
+        {
+            DataSize = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchThroughput(DataSize);
+    }
+    else if(strcmp(Mode, "-pages") == 0)
+    {
+        size_t DataSize = 256*1024*1024;
+        if(ArgCount > 2)
+        {
+            DataSize = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchPages(DataSize);
+    }
+    else if(strcmp(Mode, "-spsc") == 0)
+    {
+        size_t DataSize = 16*1024*1024;
+        if(ArgCount > 2)
+        {
+            DataSize = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchProducerConsumer(DataSize);
+    }
+    else if(strcmp(Mode, "-file") == 0)
+    {
+        size_t DataSize = (size_t)1 << 30;
+        if(ArgCount > 2)
+        {
+            DataSize = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchFile(DataSize);
+    }
+    else if(strcmp(Mode, "-cold") == 0)
+    {
+        size_t TotalSize = (size_t)1 << 30;
+        if(ArgCount > 2)
+        {
+            TotalSize = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchCold(TotalSize);
+    }
+    else if(strcmp(Mode, "-lines") == 0)
+    {
+        size_t LineCount = 10000000;
+        if(ArgCount > 2)
+        {
+            LineCount = (size_t)strtoull(Args[2], 0, 0);
+        }
+
+        BenchLineIndex(LineCount);
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [-check|-throughput [DataSize]|-spsc [DataSize]|-pages [DataSize]|-file [DataSize]|-cold [TotalSize]|-lines [LineCount]]\n", Args[0]);
+        return 1;
+    }
+
+    return 0;
+}